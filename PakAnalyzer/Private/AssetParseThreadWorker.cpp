@@ -9,6 +9,7 @@
 #include "Misc/Compression.h"
 #include "Misc/Paths.h"
 #include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
 #include "Serialization/Archive.h"
 #include "Serialization/MemoryWriter.h"
 #include "Serialization/MemoryReader.h"
@@ -19,6 +20,9 @@
 #include "CommonDefines.h"
 #include "ExtractThreadWorker.h"
 
+// Bump when the layout written by SerializeSummaryRecord changes
+static const int32 ASSET_SUMMARY_RECORD_VERSION = 1;
+
 class FAssetParseMemoryReader : public FMemoryReader
 {
 public:
@@ -52,6 +56,70 @@ protected:
 	const TArray<FNameEntryId>& NameMap;
 };
 
+/** Pak readers, buffers and results of one parse task, reused for all assets the task parses. */
+struct FAssetParseContext
+{
+	// Paks kept open at once by one task
+	static const int32 MaxOpenReaders = 16;
+
+	struct FOpenReader
+	{
+		TUniquePtr<FArchive> Archive;
+		uint64 LastUse = 0;
+	};
+
+	TMap<int32, FOpenReader> Readers;
+	uint64 ReaderUseCounter = 0;
+	TArray<uint8> FileBuffer;
+	TArray<uint8> CompressedBuffer;
+
+	// Results of the task, merged once all assets are parsed
+	TArray<TPair<FName, FName>> Classes;
+	TArray<TPair<FName, FName>> Depends;
+	TArray<int32> DependSlots;
+	FAssetSummaryCache::FNewRecords NewRecords;
+
+	int32 OpenCount = 0;
+	int32 AllocCount = 0;
+
+	FArchive* GetReader(int32 InPakIndex, const FString& InPakFilePath)
+	{
+		++ReaderUseCounter;
+
+		if (FOpenReader* Found = Readers.Find(InPakIndex))
+		{
+			Found->LastUse = ReaderUseCounter;
+			return Found->Archive.Get();
+		}
+
+		if (Readers.Num() >= MaxOpenReaders)
+		{
+			// Parse order interleaves paks, only close the least recently used one
+			int32 OldestPakIndex = INDEX_NONE;
+			uint64 OldestUse = MAX_uint64;
+			for (const TPair<int32, FOpenReader>& Pair : Readers)
+			{
+				if (Pair.Value.LastUse < OldestUse)
+				{
+					OldestUse = Pair.Value.LastUse;
+					OldestPakIndex = Pair.Key;
+				}
+			}
+			Readers.Remove(OldestPakIndex);
+		}
+
+		++OpenCount;
+		FArchive* Reader = IFileManager::Get().CreateFileReader(*InPakFilePath);
+		if (Reader)
+		{
+			FOpenReader& OpenReader = Readers.Add(InPakIndex);
+			OpenReader.Archive.Reset(Reader);
+			OpenReader.LastUse = ReaderUseCounter;
+		}
+		return Reader;
+	}
+};
+
 template<class T>
 FString FindFullPath(const TArray<T>& InMaps, int32 Index, const FString& InPathSpliter = TEXT("/"))
 {
@@ -72,8 +140,174 @@ FString FindFullPath(const TArray<T>& InMaps, int32 Index, const FString& InPath
 	return ObjectPath;
 }
 
+static void ResetAssetSummary(const FPakFileEntryPtr& InFile)
+{
+	if (!InFile->AssetSummary.IsValid())
+	{
+		InFile->AssetSummary = MakeShared<FAssetSummary>();
+	}
+	else
+	{
+		InFile->AssetSummary->Names.Empty();
+		InFile->AssetSummary->ObjectExports.Empty();
+		InFile->AssetSummary->ObjectImports.Empty();
+	}
+}
+
+/** Adds the class and the package dependencies of a parsed or cached asset to the task results. */
+static void CollectParseResults(FAssetParseContext& Context, const FPakFileEntryPtr& InFile, bool bFillDependency)
+{
+	FAssetSummary& Summary = *InFile->AssetSummary;
+
+	FName MainObjectName = *FPaths::GetBaseFilename(InFile->Filename.ToString());
+	FName MainClassObjectName = *FString::Printf(TEXT("%s_C"), *MainObjectName.ToString());
+	FName MainObjectClassName = NAME_None;
+	FName MainClassObjectClassName = NAME_None;
+	FName AssetClass = NAME_None;
+
+	for (const FObjectExportPtrType& ExportEx : Summary.ObjectExports)
+	{
+		FName ObjectName = *FPaths::GetBaseFilename(ExportEx->ObjectName.ToString());
+		if (ObjectName == MainObjectName)
+		{
+			MainObjectClassName = ExportEx->ClassName;
+		}
+		else if (ObjectName == MainClassObjectName)
+		{
+			MainClassObjectClassName = ExportEx->ClassName;
+		}
+
+		if (ExportEx->bIsAsset)
+		{
+			AssetClass = ExportEx->ClassName;
+		}
+	}
+
+	if (MainObjectClassName == NAME_None && MainClassObjectClassName == NAME_None)
+	{
+		if (Summary.ObjectExports.Num() == 1)
+		{
+			MainObjectClassName = Summary.ObjectExports[0]->ClassName;
+		}
+		else if (!AssetClass.IsNone())
+		{
+			MainObjectClassName = AssetClass;
+		}
+	}
+
+	if (MainObjectClassName != NAME_None || MainClassObjectClassName != NAME_None)
+	{
+		Context.Classes.Emplace(InFile->PackagePath, MainObjectClassName != NAME_None ? MainObjectClassName : MainClassObjectClassName);
+	}
+
+	if (bFillDependency)
+	{
+		for (const FObjectImportPtrType& ImportEx : Summary.ObjectImports)
+		{
+			if (ImportEx->ClassName == "Package" && !ImportEx->ObjectPath.ToString().StartsWith(TEXT("/Script")))
+			{
+				FPackageInfoPtr Depends = MakeShared<FPackageInfo>();
+				Depends->PackageName = ImportEx->ObjectPath;
+				Summary.DependencyList.Add(Depends);
+				Context.Depends.Emplace(ImportEx->ObjectPath, InFile->PackagePath);
+			}
+		}
+		Summary.DependencyList.Shrink();
+	}
+}
+
+static void SerializePackageInfos(FArchive& Ar, TArray<FPackageInfoPtr>& InOutPackages)
+{
+	int32 Count = InOutPackages.Num();
+	Ar << Count;
+	if (Ar.IsLoading())
+	{
+		InOutPackages.SetNum(FMath::Max(Count, 0));
+	}
+
+	for (FPackageInfoPtr& Package : InOutPackages)
+	{
+		if (Ar.IsLoading())
+		{
+			Package = MakeShared<FPackageInfo>();
+		}
+		Ar << Package->PackageName;
+		Ar << Package->ExtraInfo;
+	}
+}
+
+/**
+ * Record of the asset summary cache. The package summary is kept as serialized in the package,
+ * the package dependency list is rebuilt from the imports by CollectParseResults.
+ */
+static void SerializeSummaryRecord(FArchive& Ar, TArray<uint8>& InOutSummaryData, FAssetSummary& InOutSummary)
+{
+	Ar << InOutSummaryData;
+
+	int32 NameCount = InOutSummary.Names.Num();
+	Ar << NameCount;
+	if (Ar.IsLoading())
+	{
+		InOutSummary.Names.SetNum(FMath::Max(NameCount, 0));
+	}
+	for (FNamePtrType& Name : InOutSummary.Names)
+	{
+		if (Ar.IsLoading())
+		{
+			Name = MakeShared<FName>();
+		}
+		Ar << *Name;
+	}
+
+	int32 ExportCount = InOutSummary.ObjectExports.Num();
+	Ar << ExportCount;
+	if (Ar.IsLoading())
+	{
+		InOutSummary.ObjectExports.SetNum(FMath::Max(ExportCount, 0));
+	}
+	for (FObjectExportPtrType& ExportEx : InOutSummary.ObjectExports)
+	{
+		if (Ar.IsLoading())
+		{
+			ExportEx = MakeShared<FObjectExportEx>();
+		}
+		Ar << ExportEx->Index;
+		Ar << ExportEx->ObjectName;
+		Ar << ExportEx->SerialSize;
+		Ar << ExportEx->SerialOffset;
+		Ar << ExportEx->bIsAsset;
+		Ar << ExportEx->bNotForClient;
+		Ar << ExportEx->bNotForServer;
+		Ar << ExportEx->ObjectPath;
+		Ar << ExportEx->ClassName;
+		Ar << ExportEx->TemplateObject;
+		Ar << ExportEx->Super;
+		SerializePackageInfos(Ar, ExportEx->DependencyList);
+	}
+
+	int32 ImportCount = InOutSummary.ObjectImports.Num();
+	Ar << ImportCount;
+	if (Ar.IsLoading())
+	{
+		InOutSummary.ObjectImports.SetNum(FMath::Max(ImportCount, 0));
+	}
+	for (FObjectImportPtrType& ImportEx : InOutSummary.ObjectImports)
+	{
+		if (Ar.IsLoading())
+		{
+			ImportEx = MakeShared<FObjectImportEx>();
+		}
+		Ar << ImportEx->Index;
+		Ar << ImportEx->ClassPackage;
+		Ar << ImportEx->ClassName;
+		Ar << ImportEx->ObjectName;
+		Ar << ImportEx->ObjectPath;
+	}
+}
+
 FAssetParseThreadWorker::FAssetParseThreadWorker()
 	: Thread(nullptr)
+	, SummaryCache(TEXT("Pak"), ASSET_SUMMARY_RECORD_VERSION)
 {
 }
 
@@ -91,21 +325,24 @@ uint32 FAssetParseThreadWorker::Run()
 {
 	UE_LOG(LogPakAnalyzer, Display, TEXT("Asset parse worker starts."));
 
-	FCriticalSection Mutex;
 	const static bool bForceSingleThread = false;
 	const int32 TotalCount = Files.Num();
-	
-	TMultiMap<FName, FName> DependsMap;
-	TMap<FName, FName> ClassMap;
+
+	SummaryCache.Load();
+
+	TAtomic<int64> HeaderBytes{ 0 };
+	TAtomic<int64> AssetBytes{ 0 };
 
 	// Parse assets
-	ParallelFor(TotalCount, [this, &DependsMap, &ClassMap, &Mutex](int32 InIndex){
+	auto ParseFile = [this, &HeaderBytes, &AssetBytes](FAssetParseContext& Context, int32 InIndex){
 		if (StopTaskCounter.GetValue() > 0)
 		{
 			return;
 		}
 
-		TArray<uint8> FileBuffer;
+		TArray<uint8>& FileBuffer = Context.FileBuffer;
+		const int32 BufferCapacity = FileBuffer.Max();
+		const int32 CompressedBufferCapacity = Context.CompressedBuffer.Max();
 		bool SerializeSuccess = false;
 
 		FPakFileEntryPtr File = Files[InIndex];
@@ -119,71 +356,73 @@ uint32 FAssetParseThreadWorker::Run()
 		const int32 PakVersion = Summary.PakInfo.Version;
 		const FAES::FAESKey AESKey = Summary.DecryptAESKey;
 
+		// Unchanged assets are restored from the cache without reading the pak
+		const FString CacheKey = GetCacheKey(*File);
+		const TArray<uint8>* CacheRecord = CacheKey.IsEmpty() ? nullptr : SummaryCache.Find(CacheKey);
+		if (CacheRecord)
+		{
+			ResetAssetSummary(File);
+			const bool bFillDependency = File->AssetSummary->DependencyList.Num() <= 0;
+
+			TArray<uint8> SummaryData;
+			FMemoryReader RecordReader(*CacheRecord);
+			SerializeSummaryRecord(RecordReader, SummaryData, *File->AssetSummary);
+
+			FMemoryReader SummaryReader(SummaryData);
+			SummaryReader << File->AssetSummary->PackageSummary;
+
+			if (!RecordReader.IsError() && !SummaryReader.IsError())
+			{
+				CollectParseResults(Context, File, bFillDependency);
+				return;
+			}
+
+			UE_LOG(LogPakAnalyzer, Warning, TEXT("Invalid asset summary cache record, parse again: %s."), *File->Path);
+		}
+
 		if (OnReadAssetContent.IsBound())
 		{
 			OnReadAssetContent.Execute(File, SerializeSuccess, FileBuffer);
 		}
-		else
+		else if (FArchive* ReaderArchive = Context.GetReader(File->OwnerPakIndex, PakFilePath))
 		{
-			FArchive* ReaderArchive = IFileManager::Get().CreateFileReader(*PakFilePath);
 			ReaderArchive->Seek(File->PakEntry.Offset);
 
 			FPakEntry EntryInfo;
 			EntryInfo.Serialize(*ReaderArchive, PakVersion);
 
-			if (EntryInfo.IndexDataEquals(File->PakEntry))
+			if (!ReaderArchive->IsError() && EntryInfo.IndexDataEquals(File->PakEntry))
 			{
-				FMemoryWriter Writer(FileBuffer, false, true);
-
-				if (EntryInfo.CompressionMethodIndex == 0)
-				{
-					const int64 BufferSize = 8 * 1024 * 1024; // 8MB buffer for extracting
-					void* Buffer = FMemory::Malloc(BufferSize);
-
-					if (FExtractThreadWorker::BufferedCopyFile(Writer, *ReaderArchive, File->PakEntry, Buffer, BufferSize, AESKey))
+				const int64 DataOffset = ReaderArchive->Tell();
+				SerializeSuccess = ReadAssetHeader([&](int64 InSize, TArray<uint8>& InOutData)
 					{
-						SerializeSuccess = true;
-					}
-
-					FMemory::Free(Buffer);
-				}
-				else
-				{
-					uint8* PersistantCompressionBuffer = NULL;
-					int64 CompressionBufferSize = 0;
-					const bool bHasRelativeCompressedChunkOffsets = PakVersion >= FPakInfo::PakFile_Version_RelativeChunkOffsets;
-
-					if (FExtractThreadWorker::UncompressCopyFile(Writer, *ReaderArchive, File->PakEntry, PersistantCompressionBuffer, CompressionBufferSize, AESKey, File->CompressionMethod, bHasRelativeCompressedChunkOffsets))
-					{
-						SerializeSuccess = true;
-					}
-
-					FMemory::Free(PersistantCompressionBuffer);
-				}
+						return FExtractThreadWorker::ReadEntryPrefix(*ReaderArchive, File->PakEntry, DataOffset, PakVersion, AESKey, File->CompressionMethod, InSize, InOutData, Context.CompressedBuffer);
+					}, FileBuffer);
 			}
 
-			ReaderArchive->Close();
-			delete ReaderArchive;
+			// A failed read leaves the archive in error, it is reopened for the next asset
+			if (ReaderArchive->IsError())
+			{
+				Context.Readers.Remove(File->OwnerPakIndex);
+			}
 		}
 
+		Context.AllocCount += (FileBuffer.Max() > BufferCapacity ? 1 : 0) + (Context.CompressedBuffer.Max() > CompressedBufferCapacity ? 1 : 0);
+
 		if (SerializeSuccess)
 		{
-			if (!File->AssetSummary.IsValid())
-			{
-				File->AssetSummary = MakeShared<FAssetSummary>();
-			}
-			else
-			{
-				File->AssetSummary->Names.Empty();
-				File->AssetSummary->ObjectExports.Empty();
-				File->AssetSummary->ObjectImports.Empty();
-			}
+			HeaderBytes.AddExchange(FileBuffer.Num());
+			AssetBytes.AddExchange(File->PakEntry.UncompressedSize);
+
+			ResetAssetSummary(File);
+			const bool bFillDependency = File->AssetSummary->DependencyList.Num() <= 0;
 			
 			TArray<FNameEntryId> NameMap;
 			FAssetParseMemoryReader Reader(NameMap, FileBuffer);
 
 			// Serialize summary
 			Reader << File->AssetSummary->PackageSummary;
+			const int64 SummarySize = Reader.Tell();
 			
 			Reader.Seek(0);
 			int32 Tag = 0;
@@ -274,12 +513,6 @@ uint32 FAssetParseThreadWorker::Run()
 			}
 			File->AssetSummary->ObjectImports.Shrink();
 
-			FName MainObjectName = *FPaths::GetBaseFilename(File->Filename.ToString());
-			FName MainClassObjectName = *FString::Printf(TEXT("%s_C"), *MainObjectName.ToString());
-			FName MainObjectClassName = NAME_None;
-			FName MainClassObjectClassName = NAME_None;
-			FName AssetClass = NAME_None;
-
 			// Parse Export Object Path
 			for (int32 i = 0; i < File->AssetSummary->ObjectExports.Num(); ++i)
 			{
@@ -290,60 +523,13 @@ uint32 FAssetParseThreadWorker::Run()
 				ParseObjectName(Imports, Exports, Export.ClassIndex, ExportEx->ClassName);
 				ParseObjectName(Imports, Exports, Export.TemplateIndex, ExportEx->TemplateObject);
 				ParseObjectName(Imports, Exports, Export.SuperIndex, ExportEx->Super);
-
-				FName ObjectName = *FPaths::GetBaseFilename(ExportEx->ObjectName.ToString());
-				if (ObjectName == MainObjectName)
-				{
-					MainObjectClassName = ExportEx->ClassName;
-				}
-				else if (ObjectName == MainClassObjectName)
-				{
-					MainClassObjectClassName = ExportEx->ClassName;
-				}
-
-				if (ExportEx->bIsAsset)
-				{
-					AssetClass = ExportEx->ClassName;
-				}
 			}
 
-			if (MainObjectClassName == NAME_None && MainClassObjectClassName == NAME_None)
-			{
-				if (File->AssetSummary->ObjectExports.Num() == 1)
-				{
-					MainObjectClassName = File->AssetSummary->ObjectExports[0]->ClassName;
-				}
-				else if (!AssetClass.IsNone())
-				{
-					MainObjectClassName = AssetClass;
-				}
-			}
-
-			if (MainObjectClassName != NAME_None || MainClassObjectClassName != NAME_None)
-			{
-				FScopeLock ScopeLock(&Mutex);
-				ClassMap.Add(File->PackagePath, MainObjectClassName != NAME_None ? MainObjectClassName : MainClassObjectClassName);
-			}
-
-			const bool bFillDependency = File->AssetSummary->DependencyList.Num() <= 0;
+			// Parse Import Object Path
 			for (int32 i = 0; i < File->AssetSummary->ObjectImports.Num(); ++i)
 			{
-				const FObjectImport& Import = Imports[i];
-				FObjectImportPtrType& ImportEx = File->AssetSummary->ObjectImports[i];
-
-				ImportEx->ObjectPath = *FindFullPath(Imports, i);
-
-				if (bFillDependency && Import.ClassName == "Package" && !ImportEx->ObjectPath.ToString().StartsWith(TEXT("/Script")))
-				{
-					FPackageInfoPtr Depends = MakeShared<FPackageInfo>();
-					Depends->PackageName = ImportEx->ObjectPath;
-					File->AssetSummary->DependencyList.Add(Depends);
-
-					FScopeLock ScopeLock(&Mutex);
-					DependsMap.Add(ImportEx->ObjectPath, File->PackagePath);
-				}
+				File->AssetSummary->ObjectImports[i]->ObjectPath = *FindFullPath(Imports, i);
 			}
-			File->AssetSummary->DependencyList.Shrink();
 
 			// Serialize Preload Dependency
 			TArray<FPackageIndex> PreloadDependencies;
@@ -426,11 +612,134 @@ uint32 FAssetParseThreadWorker::Run()
 					}
 				}
 			}
+
+			CollectParseResults(Context, File, bFillDependency);
+
+			if (!CacheKey.IsEmpty() && !Reader.IsError())
+			{
+				TArray<uint8> SummaryData(FileBuffer.GetData(), SummarySize);
+				TArray<uint8> Record;
+				FMemoryWriter RecordWriter(Record);
+				SerializeSummaryRecord(RecordWriter, SummaryData, *File->AssetSummary);
+				Context.NewRecords.Emplace(CacheKey, MoveTemp(Record));
+			}
 		}
-	}, bForceSingleThread);
+	};
+
+	// Every task parses the prioritized files requested so far before its own one, the rest is parsed in the background
+	TArray<FAssetParseContext> Contexts;
+	ParallelForWithTaskContext(Contexts, TotalCount, [this, &ParseFile](FAssetParseContext& Context, int32 InIndex){
+		int32 Index = INDEX_NONE;
+		do
+		{
+			Index = PopPriorityFile();
+			if (Index == INDEX_NONE)
+			{
+				Index = InIndex;
+			}
+
+			if (StopTaskCounter.GetValue() > 0 || ClaimedFiles[Index].AtomicSet(true))
+			{
+				continue;
+			}
+
+			ParseFile(Context, Index);
+			ParsedFiles[Index] = true;
+
+			if (RequestedFiles[Index] && Files[Index]->AssetSummary.IsValid())
+			{
+				OnAssetParsed.ExecuteIfBound(Files[Index]);
+			}
+		} while (Index != InIndex);
+	}, bForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::BackgroundPriority);
+
+	int32 OpenCount = 0;
+	int32 AllocCount = 0;
+	int32 ClassCount = 0;
+	for (FAssetParseContext& Context : Contexts)
+	{
+		OpenCount += Context.OpenCount;
+		AllocCount += Context.AllocCount;
+		ClassCount += Context.Classes.Num();
+		Context.Readers.Empty();
+		SummaryCache.Append(MoveTemp(Context.NewRecords));
+	}
+	const int32 TaskCount = Contexts.Num();
+
+	ClassTypeMap ClassMap;
+	ClassMap.Reserve(ClassCount);
+	for (const FAssetParseContext& Context : Contexts)
+	{
+		for (const TPair<FName, FName>& Class : Context.Classes)
+		{
+			ClassMap.Add(Class.Key, Class.Value);
+		}
+	}
+
+	// Reverse dependency index, the dependents of slot i are Targets[Offsets[i], Offsets[i + 1])
+	TMap<FName, int32> PackageSlots;
+	TArray<int32> FileSlots;
+	PackageSlots.Reserve(TotalCount);
+	FileSlots.SetNumUninitialized(TotalCount);
+	for (int32 i = 0; i < TotalCount; ++i)
+	{
+		FileSlots[i] = PackageSlots.FindOrAdd(Files[i]->PackagePath, PackageSlots.Num());
+	}
+
+	ParallelFor(Contexts.Num(), [&Contexts, &PackageSlots](int32 InIndex) {
+		FAssetParseContext& Context = Contexts[InIndex];
+		Context.DependSlots.SetNumUninitialized(Context.Depends.Num());
+		for (int32 i = 0; i < Context.Depends.Num(); ++i)
+		{
+			const int32* Slot = PackageSlots.Find(Context.Depends[i].Key);
+			Context.DependSlots[i] = Slot ? *Slot : INDEX_NONE;
+		}
+	}, bForceSingleThread ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+
+	TArray<int32> Offsets;
+	Offsets.SetNumZeroed(PackageSlots.Num() + 1);
+	for (const FAssetParseContext& Context : Contexts)
+	{
+		for (int32 Slot : Context.DependSlots)
+		{
+			if (Slot != INDEX_NONE)
+			{
+				++Offsets[Slot + 1];
+			}
+		}
+	}
+	for (int32 i = 1; i < Offsets.Num(); ++i)
+	{
+		Offsets[i] += Offsets[i - 1];
+	}
+
+	TArray<FName> Targets;
+	TArray<int32> Cursors(Offsets.GetData(), PackageSlots.Num());
+	Targets.SetNumUninitialized(Offsets.Last());
+	for (const FAssetParseContext& Context : Contexts)
+	{
+		for (int32 i = 0; i < Context.DependSlots.Num(); ++i)
+		{
+			const int32 Slot = Context.DependSlots[i];
+			if (Slot != INDEX_NONE)
+			{
+				Targets[Cursors[Slot]++] = Context.Depends[i].Value;
+			}
+		}
+	}
+	Contexts.Empty();
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Asset parse read %.2f MB of headers from %.2f MB of assets with %d tasks, %d pak opens and %d buffer allocations."),
+		HeaderBytes.Load() / 1024.0 / 1024.0, AssetBytes.Load() / 1024.0 / 1024.0, TaskCount, OpenCount, AllocCount);
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Asset parse restored %d of %d assets from the summary cache, %d assets added."), SummaryCache.GetHitCount(), TotalCount, SummaryCache.GetAddCount());
+
+	if (StopTaskCounter.GetValue() <= 0 && (SummaryCache.GetHitCount() > 0 || SummaryCache.GetAddCount() > 0))
+	{
+		SummaryCache.Save();
+	}
 
 	// Parse depends
-	ParallelFor(TotalCount, [this, &DependsMap](int32 InIndex) {
+	ParallelFor(TotalCount, [this, &FileSlots, &Offsets, &Targets](int32 InIndex) {
 		if (StopTaskCounter.GetValue() > 0)
 		{
 			return;
@@ -446,13 +755,12 @@ uint32 FAssetParseThreadWorker::Run()
 			return;
 		}
 
-		TArray<FName> Assets;
-		DependsMap.MultiFind(File->PackagePath, Assets);
-
-		for (const FName& Asset : Assets)
+		const int32 Slot = FileSlots[InIndex];
+		File->AssetSummary->DependentList.Reserve(Offsets[Slot + 1] - Offsets[Slot]);
+		for (int32 i = Offsets[Slot]; i < Offsets[Slot + 1]; ++i)
 		{
 			FPackageInfoPtr Depends = MakeShared<FPackageInfo>();
-			Depends->PackageName = Asset;
+			Depends->PackageName = Targets[i];
 			File->AssetSummary->DependentList.Add(Depends);
 		}
 		File->AssetSummary->DependentList.Shrink();
@@ -509,9 +817,86 @@ void FAssetParseThreadWorker::StartParse(TArray<FPakFileEntryPtr>& InFiles, TArr
 	Files = MoveTemp(InFiles);
 	Summaries = MoveTemp(InSummaries);
 
+	{
+		FScopeLock Lock(&PriorityCriticalSection);
+
+		PriorityFiles.Empty();
+		FileIndices.Empty(Files.Num());
+		for (int32 i = 0; i < Files.Num(); ++i)
+		{
+			FileIndices.Add(Files[i].Get(), i);
+		}
+
+		ClaimedFiles.Empty();
+		ClaimedFiles.SetNum(Files.Num());
+		ParsedFiles.Empty();
+		ParsedFiles.SetNum(Files.Num());
+		RequestedFiles.Empty();
+		RequestedFiles.SetNum(Files.Num());
+	}
+
 	Thread = FRunnableThread::Create(this, TEXT("AssetParseThreadWorker"), 0, EThreadPriority::TPri_Highest);
 }
 
+void FAssetParseThreadWorker::PrioritizeFiles(const TArray<FPakFileEntryPtr>& InFiles)
+{
+	FScopeLock Lock(&PriorityCriticalSection);
+
+	// The first file is the most urgent one and is popped first
+	for (int32 i = InFiles.Num() - 1; i >= 0; --i)
+	{
+		const int32* Index = InFiles[i].IsValid() ? FileIndices.Find(InFiles[i].Get()) : nullptr;
+		if (Index && !ParsedFiles[*Index])
+		{
+			RequestedFiles[*Index] = true;
+			PriorityFiles.Add(*Index);
+		}
+	}
+}
+
+int32 FAssetParseThreadWorker::PopPriorityFile()
+{
+	FScopeLock Lock(&PriorityCriticalSection);
+
+	while (PriorityFiles.Num() > 0)
+	{
+		const int32 Index = PriorityFiles.Pop(EAllowShrinking::No);
+		if (!ClaimedFiles[Index])
+		{
+			return Index;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+FString FAssetParseThreadWorker::GetCacheKey(const FPakFileEntry& InFile)
+{
+	// Entries without a hash, like loose files, are not cached
+	FSHAHash Hash;
+	FMemory::Memcpy(Hash.Hash, InFile.PakEntry.Hash, sizeof(Hash.Hash));
+	return Hash != FSHAHash() ? Hash.ToString() : FString();
+}
+
+bool FAssetParseThreadWorker::ReadAssetHeader(TFunctionRef<bool(int64, TArray<uint8>&)> InReadPrefix, TArray<uint8>& OutData)
+{
+	// Enough for the summary of almost every package, larger ones are read in full
+	static const int64 SummaryReadSize = 16 * 1024;
+
+	OutData.Reset();
+	if (!InReadPrefix(SummaryReadSize, OutData))
+	{
+		return false;
+	}
+
+	FPackageFileSummary PackageSummary;
+	FMemoryReader SummaryReader(OutData);
+	SummaryReader << PackageSummary;
+
+	const bool bValidSummary = !SummaryReader.IsError() && (PackageSummary.Tag == PACKAGE_FILE_TAG || PackageSummary.Tag == PACKAGE_FILE_TAG_SWAPPED) && PackageSummary.TotalHeaderSize > 0;
+	return InReadPrefix(bValidSummary ? PackageSummary.TotalHeaderSize : MAX_int64, OutData);
+}
+
 bool FAssetParseThreadWorker::ParseObjectName(const TArray<FObjectImport>& Imports, const TArray<FObjectExport>& Exports, FPackageIndex Index, FName& OutObjectName)
 {
 	if (Index.IsImport())
@@ -1,15 +1,21 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
 #include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Templates/Function.h"
 #include "Misc/AES.h"
 
 #include "Misc/Guid.h"
 #include "PakFileEntry.h"
 
+#include "AssetSummaryCache.h"
+
 typedef TMap<FName, FName> ClassTypeMap;
 DECLARE_DELEGATE_ThreeParams(FOnReadAssetContent, FPakFileEntryPtr /*InFile*/, bool& /*bOutSuccess*/, TArray<uint8>& /*OutContent*/);
 DECLARE_DELEGATE_TwoParams(FOnParseFinish, bool/* bCancel*/, const ClassTypeMap&/* ClassMap*/);
+DECLARE_DELEGATE_OneParam(FOnAssetParsed, FPakFileEntryPtr /*InFile*/);
 
 class FAssetParseThreadWorker : public FRunnable
 {
@@ -26,17 +32,47 @@ public:
 	void EnsureCompletion();
 	void StartParse(TArray<FPakFileEntryPtr>& InFiles, TArray<FPakFileSumary>& InSummaries);
 
+	/**
+	 * Moves files of the running parse to the front, the first file is parsed first.
+	 * OnAssetParsed is executed on the parse thread as soon as each of them is parsed.
+	 */
+	void PrioritizeFiles(const TArray<FPakFileEntryPtr>& InFiles);
+
+	/**
+	 * Reads the package header of an asset: a prefix holding the summary first, then up to its TotalHeaderSize.
+	 * InReadPrefix extends the buffer to at least the given size or the whole file, export data is never requested.
+	 */
+	static bool ReadAssetHeader(TFunctionRef<bool(int64 /*Size*/, TArray<uint8>& /*InOutData*/)> InReadPrefix, TArray<uint8>& OutData);
+
 	FOnReadAssetContent OnReadAssetContent;
 	FOnParseFinish OnParseFinish;
+	FOnAssetParsed OnAssetParsed;
 
 protected:
 	bool ParseObjectName(const TArray<FObjectImport>& Imports, const TArray<FObjectExport>& Exports, FPackageIndex Index, FName& OutObjectName);
 	bool ParseObjectPath(FAssetSummaryPtr InSummary, FPackageIndex Index, FName& OutFullPath);
 
+	/** Returns INDEX_NONE when no unclaimed prioritized file is left. */
+	int32 PopPriorityFile();
+
+	/** Content hash of the entry, empty when the entry has none. */
+	static FString GetCacheKey(const FPakFileEntry& InFile);
+
 protected:
 	class FRunnableThread* Thread;
 	FThreadSafeCounter StopTaskCounter;
 
 	TArray<FPakFileEntryPtr> Files;
 	TArray<FPakFileSumary> Summaries;
+
+	FCriticalSection PriorityCriticalSection;
+	TArray<int32> PriorityFiles;
+	TMap<const FPakFileEntry*, int32> FileIndices;
+
+	// Per file flags, sized by StartParse
+	TArray<FThreadSafeBool> ClaimedFiles;
+	TArray<FThreadSafeBool> ParsedFiles;
+	TArray<FThreadSafeBool> RequestedFiles;
+
+	FAssetSummaryCache SummaryCache;
 };
@@ -0,0 +1,207 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "AssetSummaryCache.h"
+
+#include "HAL/PlatformTime.h"
+#include "Misc/Paths.h"
+
+#include "CacheFile.h"
+#include "CommonDefines.h"
+
+static const uint32 ASSET_SUMMARY_CACHE_MAGIC = 0x41534358;
+static const int32 ASSET_SUMMARY_CACHE_VERSION = 1;
+
+// Loads a record may stay unused before it is dropped
+static const int32 ASSET_SUMMARY_CACHE_MAX_UNUSED_GENERATIONS = 8;
+
+// The cache is shared by every project opened, least recently used records are dropped above this size
+static const int64 ASSET_SUMMARY_CACHE_MAX_SIZE = 256 * 1024 * 1024;
+static const int64 ASSET_SUMMARY_CACHE_HEADER_SIZE = 64;
+
+FAssetSummaryCache::FAssetSummaryCache(const FString& InName, int32 InRecordVersion)
+	: Name(InName)
+	, RecordVersion(InRecordVersion)
+{
+
+}
+
+bool FAssetSummaryCache::Load()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	RecordIndices.Empty();
+	Records.Empty();
+	UsedFlags.Empty();
+	Generation = 0;
+	AddCount = 0;
+
+	const FString CachePath = GetCachePath();
+
+	int32 CachedGeneration = 0;
+	const bool bLoaded = FCacheFile::Load(CachePath, ASSET_SUMMARY_CACHE_MAGIC, ASSET_SUMMARY_CACHE_VERSION, ASSET_SUMMARY_CACHE_MAX_SIZE, [this, &CachePath, &CachedGeneration](FArchive& Reader)
+		{
+			int32 CachedRecordVersion = 0;
+			Reader << CachedRecordVersion;
+			if (CachedRecordVersion != RecordVersion)
+			{
+				UE_LOG(LogPakAnalyzer, Log, TEXT("Asset summary cache is out of date: %s."), *CachePath);
+				return false;
+			}
+
+			int32 RecordCount = 0;
+			Reader << CachedGeneration;
+			Reader << RecordCount;
+			if (RecordCount < 0)
+			{
+				return false;
+			}
+
+			RecordIndices.Reserve(RecordCount);
+			Records.Reserve(RecordCount);
+			for (int32 i = 0; i < RecordCount && !Reader.IsError(); ++i)
+			{
+				FString Key;
+				FRecord Record;
+				Reader << Key;
+				Reader << Record.LastUsedGeneration;
+				Reader << Record.Data;
+
+				RecordIndices.Add(MoveTemp(Key), Records.Add(MoveTemp(Record)));
+			}
+
+			return true;
+		});
+
+	if (!bLoaded)
+	{
+		RecordIndices.Empty();
+		Records.Empty();
+		return false;
+	}
+
+	UsedFlags.SetNum(Records.Num());
+
+	Generation = CachedGeneration + 1;
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Load asset summary cache: %s, record count: %d, %.3fs."), *CachePath, Records.Num(), FPlatformTime::Seconds() - StartTime);
+
+	return true;
+}
+
+bool FAssetSummaryCache::Save()
+{
+	for (int32 i = 0; i < Records.Num(); ++i)
+	{
+		if (UsedFlags[i])
+		{
+			Records[i].LastUsedGeneration = Generation;
+		}
+	}
+
+	// Most recently used records first, keep them until the size budget is spent
+	TArray<const TPair<FString, int32>*> SavedRecords;
+	SavedRecords.Reserve(RecordIndices.Num());
+	for (const TPair<FString, int32>& Pair : RecordIndices)
+	{
+		if (Generation - Records[Pair.Value].LastUsedGeneration <= ASSET_SUMMARY_CACHE_MAX_UNUSED_GENERATIONS)
+		{
+			SavedRecords.Add(&Pair);
+		}
+	}
+
+	SavedRecords.Sort([this](const TPair<FString, int32>& A, const TPair<FString, int32>& B)
+		{
+			return Records[A.Value].LastUsedGeneration > Records[B.Value].LastUsedGeneration;
+		});
+
+	int64 SavedSize = 0;
+	for (int32 i = 0; i < SavedRecords.Num(); ++i)
+	{
+		// Upper bound of the serialized key, generation and data
+		const TPair<FString, int32>& Pair = *SavedRecords[i];
+		SavedSize += sizeof(int32) + (Pair.Key.Len() + 1) * sizeof(TCHAR) + sizeof(int32) + sizeof(int32) + Records[Pair.Value].Data.Num();
+		if (SavedSize > ASSET_SUMMARY_CACHE_MAX_SIZE - ASSET_SUMMARY_CACHE_HEADER_SIZE)
+		{
+			SavedRecords.SetNum(i);
+			break;
+		}
+	}
+
+	const FString CachePath = GetCachePath();
+	const int32 RecordCount = SavedRecords.Num();
+
+	const bool bSaved = FCacheFile::Save(CachePath, ASSET_SUMMARY_CACHE_MAGIC, ASSET_SUMMARY_CACHE_VERSION, [this, &SavedRecords](FArchive& Writer)
+		{
+			int32 CachedRecordVersion = RecordVersion;
+			int32 RecordCount = SavedRecords.Num();
+
+			Writer << CachedRecordVersion;
+			Writer << Generation;
+			Writer << RecordCount;
+
+			for (const TPair<FString, int32>* Pair : SavedRecords)
+			{
+				FRecord& Record = Records[Pair->Value];
+				Writer << const_cast<FString&>(Pair->Key);
+				Writer << Record.LastUsedGeneration;
+				Writer << Record.Data;
+			}
+		});
+
+	if (!bSaved)
+	{
+		return false;
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Save asset summary cache: %s, record count: %d, dropped: %d."), *CachePath, RecordCount, Records.Num() - RecordCount);
+
+	return true;
+}
+
+const TArray<uint8>* FAssetSummaryCache::Find(const FString& InKey) const
+{
+	const int32* Index = RecordIndices.Find(InKey);
+	if (!Index)
+	{
+		return nullptr;
+	}
+
+	UsedFlags[*Index] = true;
+	return &Records[*Index].Data;
+}
+
+void FAssetSummaryCache::Append(FNewRecords&& InRecords)
+{
+	for (TPair<FString, TArray<uint8>>& NewRecord : InRecords)
+	{
+		// A record which failed to restore was parsed again and replaces the old one
+		int32& Index = RecordIndices.FindOrAdd(MoveTemp(NewRecord.Key), INDEX_NONE);
+		if (Index == INDEX_NONE)
+		{
+			Index = Records.AddDefaulted();
+			UsedFlags.AddDefaulted();
+		}
+
+		Records[Index].Data = MoveTemp(NewRecord.Value);
+		Records[Index].LastUsedGeneration = Generation;
+		UsedFlags[Index] = false;
+		++AddCount;
+	}
+
+	InRecords.Empty();
+}
+
+int32 FAssetSummaryCache::GetHitCount() const
+{
+	int32 HitCount = 0;
+	for (const FThreadSafeBool& bUsed : UsedFlags)
+	{
+		HitCount += bUsed ? 1 : 0;
+	}
+	return HitCount;
+}
+
+FString FAssetSummaryCache::GetCachePath() const
+{
+	return FPaths::ProjectSavedDir() / TEXT("AssetSummaryCache") / FString::Printf(TEXT("%s.bin"), *Name);
+}
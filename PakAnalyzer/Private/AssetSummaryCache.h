@@ -0,0 +1,51 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+
+/**
+ * On disk cache of parsed asset headers under Saved/AssetSummaryCache, keyed by the content hash of the asset.
+ * Records are opaque to the cache, every user serializes its own format identified by InRecordVersion.
+ * Records not used by the last few loads are dropped when the cache is saved, and least recently used ones above a size budget.
+ */
+class FAssetSummaryCache
+{
+public:
+	/** Records created by one parse task, appended to the cache once all tasks are done. */
+	typedef TArray<TPair<FString, TArray<uint8>>> FNewRecords;
+
+	FAssetSummaryCache(const FString& InName, int32 InRecordVersion);
+
+	bool Load();
+	bool Save();
+
+	/** Lock free, loaded records do not change until Append. Marks the record as used by this load. */
+	const TArray<uint8>* Find(const FString& InKey) const;
+	/** Not thread safe, call it after the parse tasks finished. */
+	void Append(FNewRecords&& InRecords);
+
+	int32 GetHitCount() const;
+	int32 GetAddCount() const { return AddCount; }
+
+protected:
+	struct FRecord
+	{
+		TArray<uint8> Data;
+		int32 LastUsedGeneration = 0;
+	};
+
+	FString GetCachePath() const;
+
+protected:
+	FString Name;
+	int32 RecordVersion;
+
+	TMap<FString, int32> RecordIndices;
+	TArray<FRecord> Records;
+	// Set by Find, one flag per record so lookups never share a lock
+	mutable TArray<FThreadSafeBool> UsedFlags;
+	int32 Generation = 0;
+	int32 AddCount = 0;
+};
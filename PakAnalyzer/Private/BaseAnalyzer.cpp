@@ -1,22 +1,33 @@
 #include "BaseAnalyzer.h"
 
+#include "Algo/Sort.h"
 #include "AssetRegistry/AssetRegistryState.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
 #include "Json.h"
 #include "Misc/Base64.h"
 #include "Misc/FileHelper.h"
 #include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
 #include "Serialization/ArrayReader.h"
 
 #include "CommonDefines.h"
+#include "FileQuery.h"
+#include "PakTreeArena.h"
+#include "PathTrigramIndex.h"
 
 FBaseAnalyzer::FBaseAnalyzer()
+	: bCancelTrigramIndex(false)
 {
 
 }
 
 FBaseAnalyzer::~FBaseAnalyzer()
 {
-
+	StopBuildTrigramIndex();
+	ReleaseTrees();
 }
 
 bool FBaseAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<FString>& InDefaultAESKeys, int32 ContainerStartIndex)
@@ -27,11 +38,149 @@ bool FBaseAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArray
 
 void FBaseAnalyzer::GetFiles(const FString& InFilterText, const TMap<FName, bool>& InClassFilterMap, const TMap<int32, bool>& InPakIndexFilter, TArray<FPakFileEntryPtr>& OutFiles) const
 {
-	FScopeLock Lock(const_cast<FCriticalSection*>(&CriticalSection));
+	TSharedPtr<const FFileIndex, ESPMode::ThreadSafe> Index;
+	TSharedPtr<const FPathTrigramIndex, ESPMode::ThreadSafe> Trigrams;
+	{
+		FScopeLock Lock(const_cast<FCriticalSection*>(&CriticalSection));
+		Index = FileIndex;
+		Trigrams = TrigramIndex;
+	}
+
+	if (!Index.IsValid())
+	{
+		return;
+	}
+
+	const FFileQuery Query = FFileQuery::Parse(InFilterText);
+
+	// Only scan files whose path contains every trigram of the longest term, falls back to a full scan until the index is ready
+	const FString* LongestTerm = nullptr;
+	for (const FString& Term : Query.Terms)
+	{
+		if (!LongestTerm || Term.Len() > LongestTerm->Len())
+		{
+			LongestTerm = &Term;
+		}
+	}
+
+	TArray<int32> Candidates;
+	const bool bUseCandidates = LongestTerm && Trigrams.IsValid() && Trigrams->GetFileListSerial() == Index->FileListSerial &&
+		Trigrams->FindCandidates(*LongestTerm, Candidates);
+
+	// Resolve filters and query predicates to flat tables once, the scan itself never touches a map
+	TArray<bool> ClassVisible;
+	ClassVisible.SetNumUninitialized(Index->Classes.Num());
+	for (int32 i = 0; i < Index->Classes.Num(); ++i)
+	{
+		const bool* bShow = InClassFilterMap.Find(Index->Classes[i]);
+		ClassVisible[i] = InClassFilterMap.Num() <= 0 || (bShow && *bShow);
+	}
+
+	TArray<bool> PakVisible;
+	PakVisible.SetNumUninitialized(FMath::Max(Index->MaxPakIndex + 1, Index->PakNames.Num()));
+	for (int32 i = 0; i < PakVisible.Num(); ++i)
+	{
+		const bool* bShowIndex = InPakIndexFilter.Find(i);
+		PakVisible[i] = InPakIndexFilter.Num() <= 0 || (bShowIndex && *bShowIndex);
+	}
+
+	TArray<bool> CompressionVisible;
+	CompressionVisible.Init(true, Index->CompressionMethods.Num());
+
+	bool EncryptedVisible[2] = { true, true };
+	TArray<const FFileQuery::FPredicate*> NumericPredicates;
+
+	for (const FFileQuery::FPredicate& Predicate : Query.Predicates)
+	{
+		switch (Predicate.Field)
+		{
+		case FFileQuery::EField::Class:
+			for (int32 i = 0; i < ClassVisible.Num(); ++i)
+			{
+				ClassVisible[i] = ClassVisible[i] && MatchesAnyValue(Index->Classes[i].ToString(), Predicate.Values);
+			}
+			break;
+		case FFileQuery::EField::Pak:
+			for (int32 i = 0; i < PakVisible.Num(); ++i)
+			{
+				const bool bMatch = Predicate.Values.Contains(LexToString(i)) || (Index->PakNames.IsValidIndex(i) && MatchesAnyValue(Index->PakNames[i], Predicate.Values));
+				PakVisible[i] = PakVisible[i] && bMatch;
+			}
+			break;
+		case FFileQuery::EField::Compression:
+			for (int32 i = 0; i < CompressionVisible.Num(); ++i)
+			{
+				CompressionVisible[i] = CompressionVisible[i] && MatchesAnyValue(Index->CompressionMethods[i].ToString(), Predicate.Values);
+			}
+			break;
+		case FFileQuery::EField::Encrypted:
+			EncryptedVisible[Predicate.Number > 0.0 ? 0 : 1] = false;
+			break;
+		default:
+			NumericPredicates.Add(&Predicate);
+			break;
+		}
+	}
+
+	static const int32 ChunkSize = 16 * 1024;
+	const int32 FileCount = bUseCandidates ? Candidates.Num() : Index->Files.Num();
+	const int32 ChunkCount = FMath::DivideAndRoundUp(FileCount, ChunkSize);
+
+	TArray<TArray<FPakFileEntryPtr>> ChunkResults;
+	ChunkResults.SetNum(ChunkCount);
+
+	ParallelFor(ChunkCount, [&](int32 ChunkIndex)
+	{
+		TArray<FPakFileEntryPtr>& ChunkResult = ChunkResults[ChunkIndex];
+		const int32 End = FMath::Min((ChunkIndex + 1) * ChunkSize, FileCount);
+
+		for (int32 j = ChunkIndex * ChunkSize; j < End; ++j)
+		{
+			const int32 i = bUseCandidates ? Candidates[j] : j;
+			const int32 PakIndex = Index->PakIndices[i];
+			if (!ClassVisible[Index->ClassIds[i]] || !PakVisible.IsValidIndex(PakIndex) || !PakVisible[PakIndex] ||
+				!CompressionVisible[Index->CompressionIds[i]] || !EncryptedVisible[Index->Encrypted[i] ? 1 : 0])
+			{
+				continue;
+			}
+
+			bool bMatch = true;
+			for (const FFileQuery::FPredicate* Predicate : NumericPredicates)
+			{
+				double Value = 0.0;
+				switch (Predicate->Field)
+				{
+				case FFileQuery::EField::Size: Value = (double)Index->Sizes[i]; break;
+				case FFileQuery::EField::CompressedSize: Value = (double)Index->CompressedSizes[i]; break;
+				case FFileQuery::EField::BlockCount: Value = (double)Index->BlockCounts[i]; break;
+				default: Value = Index->Sizes[i] > 0 ? (double)Index->CompressedSizes[i] / Index->Sizes[i] : 1.0; break;
+				}
+
+				if (!FFileQuery::CompareNumber(Value, Predicate->Compare, Predicate->Number))
+				{
+					bMatch = false;
+					break;
+				}
+			}
+
+			const FPakFileEntryPtr& File = Index->Files[i];
+			if (bMatch && Query.MatchesPath(*File->Path))
+			{
+				ChunkResult.Add(File);
+			}
+		}
+	});
+
+	int32 ResultCount = 0;
+	for (const TArray<FPakFileEntryPtr>& ChunkResult : ChunkResults)
+	{
+		ResultCount += ChunkResult.Num();
+	}
 
-	for (FPakTreeEntryPtr PakTreeRoot : PakTreeRoots)
+	OutFiles.Reserve(OutFiles.Num() + ResultCount);
+	for (const TArray<FPakFileEntryPtr>& ChunkResult : ChunkResults)
 	{
-		RetriveFiles(PakTreeRoot, InFilterText, InClassFilterMap, InPakIndexFilter, OutFiles);
+		OutFiles.Append(ChunkResult);
 	}
 }
 
@@ -65,6 +214,8 @@ bool FBaseAnalyzer::LoadAssetRegistry(const FString& InRegristryPath)
 		RefreshClassMap(TreeRoot, TreeRoot);
 		RefreshPackageDependency(TreeRoot, TreeRoot);
 	}
+
+	RefreshFileIndex();
 	
 	return true;
 }
@@ -94,7 +245,7 @@ void FBaseAnalyzer::RefreshPackageDependency(FPakTreeEntryPtr InTreeRoot, FPakTr
 		return;
 	}
 
-	for (auto& Pair : InRoot->ChildrenMap)
+	for (auto& Pair : InRoot->GetChildrenMap())
 	{
 		FPakTreeEntryPtr Child = Pair.Value;
 
@@ -170,7 +321,7 @@ bool FBaseAnalyzer::ExportToJson(const FString& InOutputPath, const TArray<FPakF
 		TSharedRef<FJsonObject> FileObject = MakeShareable(new FJsonObject);
 
 		FileObject->SetStringField(TEXT("Name"), It->Filename.ToString());
-		FileObject->SetStringField(TEXT("Path"), It->Path);
+		FileObject->SetStringField(TEXT("Path"), It->Path.ToString());
 		FileObject->SetNumberField(TEXT("Offset"), PakEntry.Offset);
 		FileObject->SetNumberField(TEXT("Size"), PakEntry.UncompressedSize);
 		FileObject->SetNumberField(TEXT("Compressed Size"), PakEntry.Size);
@@ -289,23 +440,23 @@ FString FBaseAnalyzer::GetAssetRegistryPath() const
 
 void FBaseAnalyzer::RefreshClassMap(FPakTreeEntryPtr InTreeRoot, FPakTreeEntryPtr InRoot)
 {
-	InRoot->FileClassMap.Empty();
+	InRoot->GetMutableFileClassMap().Empty();
 
-	for (auto& Pair : InRoot->ChildrenMap)
+	for (auto& Pair : InRoot->GetChildrenMap())
 	{
 		FPakTreeEntryPtr Child = Pair.Value;
 
 		if (Child->bIsDirectory)
 		{
 			RefreshClassMap(InTreeRoot, Child);
-			for (auto& ClassPair : Child->FileClassMap)
+			for (auto& ClassPair : Child->GetFileClassMap())
 			{
 				InsertClassInfo(InTreeRoot, InRoot, ClassPair.Key, ClassPair.Value->FileCount, ClassPair.Value->Size, ClassPair.Value->CompressedSize);
 			}
 		}
 		else
 		{
-			Child->Class = GetAssetClass(Child->Path, Child->PackagePath);
+			Child->Class = GetAssetClass(Child->Path.ToString(), Child->PackagePath);
 			InsertClassInfo(InTreeRoot, InRoot, Child->Class, 1, Child->Size, Child->CompressedSize);
 		}
 	}
@@ -313,7 +464,7 @@ void FBaseAnalyzer::RefreshClassMap(FPakTreeEntryPtr InTreeRoot, FPakTreeEntryPt
 
 void FBaseAnalyzer::RefreshTreeNode(FPakTreeEntryPtr InRoot)
 {
-	for (auto& Pair : InRoot->ChildrenMap)
+	for (auto& Pair : InRoot->GetChildrenMap())
 	{
 		FPakTreeEntryPtr Child = Pair.Value;
 		if (Child->bIsDirectory)
@@ -332,7 +483,7 @@ void FBaseAnalyzer::RefreshTreeNode(FPakTreeEntryPtr InRoot)
 		InRoot->CompressedSize += Child->CompressedSize;
 	}
 
-	InRoot->ChildrenMap.ValueSort([](const FPakTreeEntryPtr& A, const FPakTreeEntryPtr& B) -> bool
+	InRoot->GetMutableChildrenMap().ValueSort([](const FPakTreeEntryPtr& A, const FPakTreeEntryPtr& B) -> bool
 		{
 			if (A->bIsDirectory == B->bIsDirectory)
 			{
@@ -345,7 +496,7 @@ void FBaseAnalyzer::RefreshTreeNode(FPakTreeEntryPtr InRoot)
 
 void FBaseAnalyzer::RefreshTreeNodeSizePercent(FPakTreeEntryPtr InTreeRoot, FPakTreeEntryPtr InRoot)
 {
-	for (auto& Pair : InRoot->ChildrenMap)
+	for (auto& Pair : InRoot->GetChildrenMap())
 	{
 		FPakTreeEntryPtr Child = Pair.Value;
 		Child->CompressedSizePercentOfTotal = InTreeRoot->CompressedSize > 0 ? (float)Child->CompressedSize / InTreeRoot->CompressedSize : 0.f;
@@ -360,7 +511,7 @@ void FBaseAnalyzer::RefreshTreeNodeSizePercent(FPakTreeEntryPtr InTreeRoot, FPak
 
 void FBaseAnalyzer::RetriveFiles(FPakTreeEntryPtr InRoot, const FString& InFilterText, const TMap<FName, bool>& InClassFilterMap, const TMap<int32, bool>& InPakIndexFilter, TArray<FPakFileEntryPtr>& OutFiles) const
 {
-	for (auto& Pair : InRoot->ChildrenMap)
+	for (auto& Pair : InRoot->GetChildrenMap())
 	{
 		FPakTreeEntryPtr Child = Pair.Value;
 		if (Child->bIsDirectory)
@@ -374,7 +525,7 @@ void FBaseAnalyzer::RetriveFiles(FPakTreeEntryPtr InRoot, const FString& InFilte
 			const bool bMatchClass = (InClassFilterMap.Num() <= 0 || (bShow && *bShow));
 			const bool bMatchIndex = (InPakIndexFilter.Num() <= 0) || (bShowIndex && *bShowIndex);
 
-			if (bMatchClass && bMatchIndex && (InFilterText.IsEmpty() || /*Child->Filename.Contains(InFilterText) ||*/ Child->Path.Contains(InFilterText)))
+			if (bMatchClass && bMatchIndex && (InFilterText.IsEmpty() || /*Child->Filename.Contains(InFilterText) ||*/ FCString::Stristr(*Child->Path, *InFilterText) != nullptr))
 			{
 				OutFiles.Add(Child);
 			}
@@ -384,7 +535,7 @@ void FBaseAnalyzer::RetriveFiles(FPakTreeEntryPtr InRoot, const FString& InFilte
 
 void FBaseAnalyzer::RetriveUAssetFiles(FPakTreeEntryPtr InRoot, TArray<FPakFileEntryPtr>& OutFiles) const
 {
-	for (auto& Pair : InRoot->ChildrenMap)
+	for (auto& Pair : InRoot->GetChildrenMap())
 	{
 		FPakTreeEntryPtr Child = Pair.Value;
 		if (Child->bIsDirectory)
@@ -403,13 +554,13 @@ void FBaseAnalyzer::RetriveUAssetFiles(FPakTreeEntryPtr InRoot, TArray<FPakFileE
 
 void FBaseAnalyzer::InsertClassInfo(FPakTreeEntryPtr InTreeRoot, FPakTreeEntryPtr InRoot, FName InClassName, int32 InFileCount, int64 InSize, int64 InCompressedSize)
 {
-	FPakClassEntryPtr* ClassEntryPtr = InRoot->FileClassMap.Find(InClassName);
+	const FPakClassEntryPtr* ClassEntryPtr = InRoot->GetFileClassMap().Find(InClassName);
 	FPakClassEntryPtr ClassEntry = nullptr;
 
 	if (!ClassEntryPtr)
 	{
 		ClassEntry = MakeShared<FPakClassEntry>(InClassName, InSize, InCompressedSize, InFileCount);
-		InRoot->FileClassMap.Add(InClassName, ClassEntry);
+		InRoot->GetMutableFileClassMap().Add(InClassName, ClassEntry);
 	}
 	else
 	{
@@ -474,6 +625,240 @@ FName FBaseAnalyzer::GetPackagePath(const FString& InFilePath)
 	}
 }
 
+void FBaseAnalyzer::RefreshFileIndex()
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	TSharedPtr<FFileIndex, ESPMode::ThreadSafe> NewIndex = MakeShared<FFileIndex, ESPMode::ThreadSafe>();
+
+	static const TMap<FName, bool> EmptyClassFilter;
+	static const TMap<int32, bool> EmptyPakIndexFilter;
+	for (const FPakTreeEntryPtr& PakTreeRoot : PakTreeRoots)
+	{
+		if (PakTreeRoot.IsValid())
+		{
+			RetriveFiles(PakTreeRoot, TEXT(""), EmptyClassFilter, EmptyPakIndexFilter, NewIndex->Files);
+		}
+	}
+
+	const int32 FileCount = NewIndex->Files.Num();
+	NewIndex->ClassIds.SetNumUninitialized(FileCount);
+	NewIndex->Sizes.SetNumUninitialized(FileCount);
+	NewIndex->CompressedSizes.SetNumUninitialized(FileCount);
+	NewIndex->BlockCounts.SetNumUninitialized(FileCount);
+	NewIndex->PakIndices.SetNumUninitialized(FileCount);
+	NewIndex->CompressionIds.SetNumUninitialized(FileCount);
+	NewIndex->Encrypted.SetNumUninitialized(FileCount);
+
+	TMap<FName, int32> ClassToId;
+	TMap<FName, int32> CompressionToId;
+	for (int32 i = 0; i < FileCount; ++i)
+	{
+		const FPakFileEntryPtr& File = NewIndex->Files[i];
+
+		int32* ClassId = ClassToId.Find(File->Class);
+		if (!ClassId)
+		{
+			ClassId = &ClassToId.Add(File->Class, NewIndex->Classes.Add(File->Class));
+		}
+
+		int32* CompressionId = CompressionToId.Find(File->CompressionMethod);
+		if (!CompressionId)
+		{
+			CompressionId = &CompressionToId.Add(File->CompressionMethod, NewIndex->CompressionMethods.Add(File->CompressionMethod));
+		}
+
+		NewIndex->ClassIds[i] = *ClassId;
+		NewIndex->CompressionIds[i] = *CompressionId;
+		NewIndex->Sizes[i] = File->PakEntry.UncompressedSize;
+		NewIndex->CompressedSizes[i] = File->PakEntry.Size;
+		NewIndex->BlockCounts[i] = File->PakEntry.CompressionBlocks.Num();
+		NewIndex->PakIndices[i] = File->OwnerPakIndex;
+		NewIndex->Encrypted[i] = File->PakEntry.IsEncrypted();
+		NewIndex->MaxPakIndex = FMath::Max<int32>(NewIndex->MaxPakIndex, File->OwnerPakIndex);
+	}
+
+	for (const FPakFileSumaryPtr& Summary : PakFileSummaries)
+	{
+		NewIndex->PakNames.Add(Summary.IsValid() ? FPaths::GetBaseFilename(Summary->PakFilePath) : FString());
+	}
+
+	bool bFileListChanged = true;
+	{
+		FScopeLock Lock(&CriticalSection);
+		bFileListChanged = !FileIndex.IsValid() || FileIndex->Files != NewIndex->Files;
+		NewIndex->FileListSerial = bFileListChanged ? ++FileListSerialCounter : FileIndex->FileListSerial;
+		FileIndex = NewIndex;
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Refresh file index: %d files, %d classes in %.3fs."), NewIndex->Files.Num(), NewIndex->Classes.Num(), FPlatformTime::Seconds() - StartTime);
+
+	if (bFileListChanged && bTrigramIndexEnabled)
+	{
+		StartBuildTrigramIndex();
+	}
+}
+
+bool FBaseAnalyzer::MatchesAnyValue(const FString& InText, const TArray<FString>& InValues)
+{
+	for (const FString& Value : InValues)
+	{
+		if (InText.MatchesWildcard(Value) || InText.StartsWith(Value + TEXT("-")) || InText.StartsWith(Value + TEXT("_")))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void FBaseAnalyzer::MakeOutputDirectories(const TArray<FString>& InOutputFilePaths)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	TSet<FString> Directories;
+	for (const FString& FilePath : InOutputFilePaths)
+	{
+		Directories.Add(FPaths::GetPath(FilePath));
+	}
+
+	// Creating a directory tree creates its parents, only the deepest directories are created explicitly
+	TSet<FString> ParentDirectories;
+	for (const FString& Directory : Directories)
+	{
+		FString Parent = FPaths::GetPath(Directory);
+		while (!Parent.IsEmpty())
+		{
+			bool bAlreadyInSet = false;
+			ParentDirectories.Add(Parent, &bAlreadyInSet);
+			if (bAlreadyInSet)
+			{
+				break;
+			}
+			Parent = FPaths::GetPath(Parent);
+		}
+	}
+
+	TArray<FString> LeafDirectories;
+	for (const FString& Directory : Directories)
+	{
+		if (!Directory.IsEmpty() && !ParentDirectories.Contains(Directory))
+		{
+			LeafDirectories.Add(Directory);
+		}
+	}
+
+	// Concurrent creation of a shared parent is harmless, the tree creation checks the result
+	ParallelFor(LeafDirectories.Num(), [&LeafDirectories](int32 Index)
+		{
+			IFileManager::Get().MakeDirectory(*LeafDirectories[Index], true);
+		});
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Make output directories: %d files in %d directories, %d created as leaves in %.2fs."), InOutputFilePaths.Num(), Directories.Num(), LeafDirectories.Num(), FPlatformTime::Seconds() - StartTime);
+}
+
+void FBaseAnalyzer::StartBuildTrigramIndex()
+{
+	StopBuildTrigramIndex();
+
+	TSharedPtr<const FFileIndex, ESPMode::ThreadSafe> Index;
+	{
+		FScopeLock Lock(&CriticalSection);
+		Index = FileIndex;
+		TrigramIndex.Reset();
+	}
+
+	if (!Index.IsValid() || Index->Files.Num() <= 0)
+	{
+		return;
+	}
+
+	bCancelTrigramIndex = false;
+	TrigramIndexTask = Async(EAsyncExecution::ThreadPool, [this, Index]()
+	{
+		TSharedPtr<FPathTrigramIndex, ESPMode::ThreadSafe> NewTrigramIndex = MakeShared<FPathTrigramIndex, ESPMode::ThreadSafe>(Index->FileListSerial);
+		if (NewTrigramIndex->Build(Index->Files, bCancelTrigramIndex))
+		{
+			FScopeLock Lock(&CriticalSection);
+			TrigramIndex = NewTrigramIndex;
+		}
+	});
+}
+
+void FBaseAnalyzer::StopBuildTrigramIndex()
+{
+	if (TrigramIndexTask.IsValid())
+	{
+		bCancelTrigramIndex = true;
+		TrigramIndexTask.Wait();
+		TrigramIndexTask = TFuture<void>();
+	}
+}
+
+void FBaseAnalyzer::FinishVerify(const FVerifyResult& InResult)
+{
+	FFunctionGraphTask::CreateAndDispatchWhenReady([Handler = VerifyFinishHandler, InResult]()
+		{
+			if (Handler.IsBound())
+			{
+				Handler.Execute(InResult);
+			}
+			else
+			{
+				FPakAnalyzerDelegates::OnVerifyFinish.ExecuteIfBound(InResult);
+			}
+		},
+		TStatId(), nullptr, ENamedThreads::GameThread);
+}
+
+void FBaseAnalyzer::FinishEmptyVerify()
+{
+	if (VerifyFinishHandler.IsBound())
+	{
+		FinishVerify(FVerifyResult());
+	}
+}
+
+void FBaseAnalyzer::LogTreeMemoryUsage() const
+{
+	int32 NodeCount = 0;
+	int32 BlockCount = 0;
+	SIZE_T ArenaSize = 0;
+	SIZE_T NodeAllocatedSize = 0;
+
+	for (const FPakTreeEntryPtr& PakTreeRoot : PakTreeRoots)
+	{
+		const FPakTreeArena* Arena = PakTreeRoot.IsValid() ? PakTreeRoot->GetArena() : nullptr;
+		if (Arena)
+		{
+			NodeCount += Arena->GetNodeCount();
+			BlockCount += Arena->GetBlockCount();
+			ArenaSize += Arena->GetAllocatedSize();
+			NodeAllocatedSize += Arena->GetNodeAllocatedSize();
+		}
+	}
+
+	// Process wide, also counts index records, names and asset registry loaded since the reset
+	const int64 UsedPhysicalGrowth = (int64)FPlatformMemory::GetStats().UsedPhysical - (int64)LoadStartUsedPhysical;
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Tree memory: %d nodes, arena %.2f MB in %d blocks, directory maps and compression blocks %.2f MB, used physical grew %.2f MB since load start."),
+		NodeCount, ArenaSize / 1024.f / 1024.f, BlockCount, NodeAllocatedSize / 1024.f / 1024.f, UsedPhysicalGrowth / 1024.f / 1024.f);
+}
+
+void FBaseAnalyzer::ReleaseTrees()
+{
+	for (const FPakTreeEntryPtr& Root : PakTreeRoots)
+	{
+		if (Root.IsValid())
+		{
+			Root->ReleaseTree();
+		}
+	}
+
+	PakTreeRoots.Empty();
+	LoadStartUsedPhysical = FPlatformMemory::GetStats().UsedPhysical;
+}
+
 void FBaseAnalyzer::Reset()
 {
 	for (FPakFileSumaryPtr Summary : PakFileSummaries)
@@ -481,18 +866,20 @@ void FBaseAnalyzer::Reset()
 		Summary.Reset();
 	}
 
-	for (FPakTreeEntryPtr Root : PakTreeRoots)
-	{
-		Root.Reset();
-	}
+	ReleaseTrees();
 
 	PakFileSummaries.Empty();
-	PakTreeRoots.Empty();
 
 	AssetRegistryState.Reset();
 
 	AssetRegistryPath = TEXT("");
 	DefaultClassMap.Empty();
+
+	StopBuildTrigramIndex();
+
+	FScopeLock Lock(&CriticalSection);
+	FileIndex.Reset();
+	TrigramIndex.Reset();
 }
 
 FString FBaseAnalyzer::ResolveCompressionMethod(const FPakFileSumary& Summary, const FPakEntry* InPakEntry) const
@@ -507,47 +894,154 @@ FString FBaseAnalyzer::ResolveCompressionMethod(const FPakFileSumary& Summary, c
 	}
 }
 
-FPakTreeEntryPtr FBaseAnalyzer::InsertFileToTree(FPakTreeEntryPtr InRoot, const FPakFileSumary& Summary, const FString& InFullPath, const FPakEntry& InPakEntry)
+void FBaseAnalyzer::NormalizeTreePath(FString& InOutPath)
 {
-	static const TCHAR* Delims[2] = { TEXT("\\"), TEXT("/") };
+	InOutPath.ReplaceCharInline(TEXT('\\'), TEXT('/'));
 
-	TArray<FString> PathItems;
-	InFullPath.ParseIntoArray(PathItems, Delims, 2);
+	if (InOutPath.Contains(TEXT("//")))
+	{
+		while (InOutPath.ReplaceInline(TEXT("//"), TEXT("/")) > 0) {}
+	}
 
-	if (PathItems.Num() <= 0)
+	int32 LeadingCount = 0;
+	while (LeadingCount < InOutPath.Len() && InOutPath[LeadingCount] == TEXT('/'))
 	{
-		return nullptr;
+		++LeadingCount;
 	}
 
-	FString CurrentPath;
-	FPakTreeEntryPtr Parent = InRoot;
+	if (LeadingCount > 0)
+	{
+		InOutPath.RemoveAt(0, LeadingCount);
+	}
 
-	for (int32 i = 0; i < PathItems.Num(); ++i)
+	if (InOutPath.EndsWith(TEXT("/")))
 	{
-		CurrentPath = CurrentPath / PathItems[i];
+		InOutPath.LeftChopInline(1);
+	}
+}
+
+void FBaseAnalyzer::BuildTree(FPakTreeEntryPtr InRoot, const FPakFileSumary& Summary, TArray<FString>& InPaths, TFunctionRef<const FPakEntry&(int32)> InGetEntry, TArray<FPakTreeEntryPtr>& OutFiles)
+{
+	const double StartTime = FPlatformTime::Seconds();
 
-		FPakTreeEntryPtr* Child = Parent->ChildrenMap.Find(*PathItems[i]);
-		if (Child)
+	OutFiles.Reset();
+	OutFiles.AddDefaulted(InPaths.Num());
+
+	TArray<int32> SortedIndices;
+	SortedIndices.Reserve(InPaths.Num());
+	for (int32 i = 0; i < InPaths.Num(); ++i)
+	{
+		NormalizeTreePath(InPaths[i]);
+		if (!InPaths[i].IsEmpty())
 		{
-			Parent = *Child;
-			continue;
+			SortedIndices.Add(i);
 		}
-		else
+	}
+
+	// Paths sharing a directory are adjacent after sorting, so every directory is resolved once.
+	// Paths differing only by case compare equal, break ties on the index so the first one always wins.
+	Algo::Sort(SortedIndices, [&InPaths](int32 A, int32 B)
 		{
-			const bool bLastItem = (i == PathItems.Num() - 1);
+			const int32 Result = InPaths[A].Compare(InPaths[B], ESearchCase::IgnoreCase);
+			return Result != 0 ? Result < 0 : A < B;
+		});
 
-			FPakTreeEntryPtr NewChild = MakeShared<FPakTreeEntry>(*PathItems[i], CurrentPath, !bLastItem);
-			if (bLastItem)
+	struct FDirectoryLevel
+	{
+		FPakTreeEntry* Node;
+		int32 PathEnd;
+	};
+
+	TSharedRef<FPakTreeArena> Arena = MakeShared<FPakTreeArena>();
+	InRoot->SetArena(Arena);
+
+	TArray<FDirectoryLevel, TInlineAllocator<32>> Levels;
+	Levels.Add({ InRoot.Get(), 0 });
+
+	int32 ConflictCount = 0;
+	for (const int32 Index : SortedIndices)
+	{
+		const FString& Path = InPaths[Index];
+		const TCHAR* PathData = *Path;
+
+		// Keep the deepest directory which is still a prefix of this path
+		int32 Depth = Levels.Num() - 1;
+		while (Depth > 0)
+		{
+			const FDirectoryLevel& Level = Levels[Depth];
+			if (Path.Len() > Level.PathEnd && PathData[Level.PathEnd] == TEXT('/') && FCString::Strnicmp(PathData, *Level.Node->Path, Level.PathEnd) == 0)
 			{
-				NewChild->PakEntry = InPakEntry;
-				NewChild->CompressionMethod = *ResolveCompressionMethod(Summary, &InPakEntry);
-				NewChild->PackagePath = GetPackagePath(CurrentPath);
+				break;
+			}
+			--Depth;
+		}
+		Levels.SetNum(Depth + 1);
+
+		int32 SegmentStart = Depth > 0 ? Levels[Depth].PathEnd + 1 : 0;
+		bool bConflict = false;
+
+		for (int32 SegmentEnd = Path.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromStart, SegmentStart); SegmentEnd != INDEX_NONE; SegmentEnd = Path.Find(TEXT("/"), ESearchCase::CaseSensitive, ESearchDir::FromStart, SegmentStart))
+		{
+			const FName DirectoryName(SegmentEnd - SegmentStart, PathData + SegmentStart);
+			FPakTreeEntry* Parent = Levels.Last().Node;
+
+			FPakTreeEntry* Directory = nullptr;
+			const FPakTreeEntryPtr* Existing = Parent->GetChildrenMap().Find(DirectoryName);
+			if (Existing)
+			{
+				Directory = (*Existing)->bIsDirectory ? Existing->Get() : nullptr;
+			}
+			else
+			{
+				FPakTreeEntryPtr NewDirectory = Arena->NewNode(DirectoryName, PathData, SegmentEnd, true);
+				Directory = NewDirectory.Get();
+				Parent->GetMutableChildrenMap().Add(DirectoryName, NewDirectory);
 			}
 
-			Parent->ChildrenMap.Add(*PathItems[i], NewChild);
-			Parent = NewChild;
+			if (!Directory)
+			{
+				// A file already uses this directory name
+				bConflict = true;
+				break;
+			}
+
+			Levels.Add({ Directory, SegmentEnd });
+			SegmentStart = SegmentEnd + 1;
 		}
+
+		if (bConflict)
+		{
+			++ConflictCount;
+			continue;
+		}
+
+		const FName Filename(Path.Len() - SegmentStart, PathData + SegmentStart);
+		FPakTreeEntry* Parent = Levels.Last().Node;
+
+		const FPakTreeEntryPtr* Existing = Parent->GetChildrenMap().Find(Filename);
+		if (Existing)
+		{
+			OutFiles[Index] = *Existing;
+			continue;
+		}
+
+		const FPakEntry& PakEntry = InGetEntry(Index);
+
+		FPakTreeEntryPtr NewChild = Arena->NewNode(Filename, PathData, Path.Len(), false);
+		NewChild->PakEntry = PakEntry;
+		NewChild->CompressionMethod = *ResolveCompressionMethod(Summary, &PakEntry);
+		NewChild->PackagePath = GetPackagePath(Path);
+
+		Parent->GetMutableChildrenMap().Add(Filename, NewChild);
+		OutFiles[Index] = NewChild;
+	}
+
+	if (ConflictCount > 0)
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Build tree: %s, %d files conflict with existing file names."), *InRoot->Filename.ToString(), ConflictCount);
 	}
 
-	return Parent;
+	const double BuildTime = FPlatformTime::Seconds() - StartTime;
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Build tree: %s, %d paths in %.3fs, %.3fs per million paths."),
+		*InRoot->Filename.ToString(), InPaths.Num(), BuildTime, InPaths.Num() > 0 ? BuildTime * 1000000.0 / InPaths.Num() : 0.0);
 }
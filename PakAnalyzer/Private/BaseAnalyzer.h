@@ -4,14 +4,17 @@
 
 #include "CoreMinimal.h"
 
+#include "Async/Future.h"
 #include "HAL/CriticalSection.h"
 #include "Misc/AES.h"
 #include "Misc/Guid.h"
 #include "Misc/SecureHash.h"
+#include "Templates/Atomic.h"
 
 #include "IPakAnalyzer.h"
 
 class FArrayReader;
+class FPathTrigramIndex;
 
 class FBaseAnalyzer : public IPakAnalyzer
 {
@@ -28,14 +31,28 @@ public:
 	virtual bool ExportToCsv(const FString& InOutputPath, const TArray<FPakFileEntryPtr>& InFiles) override;
 	virtual FString GetAssetRegistryPath() const override;
 	virtual void ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles) override {}
+	virtual bool ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles) override { return true; }
 	virtual void CancelExtract() override {}
+	virtual void VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles) override {}
+	virtual void CancelVerify() override {}
+	virtual void PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles) override {}
 	virtual void SetExtractThreadCount(int32 InThreadCount) override {}
+	virtual void SetExtractIOThreadCount(int32 InReadThreadCount, int32 InWriteThreadCount) override {}
+	virtual void SetExtractMode(EExtractMode InMode) override {}
+	virtual void SetExtractDeduplicate(bool bInDeduplicate) override {}
+
+	/** Analyzers wrapped by another one are never searched directly and can skip the trigram index */
+	void SetTrigramIndexEnabled(bool bInEnabled) { bTrigramIndexEnabled = bInEnabled; }
+	/** Analyzers wrapped by another one hand their verify result to it instead of broadcasting OnVerifyFinish */
+	void SetVerifyFinishHandler(const FPakAnalyzerDelegates::FOnVerifyFinish& InHandler) { VerifyFinishHandler = InHandler; }
 
 protected:
 	virtual void Reset();
 	virtual FString ResolveCompressionMethod(const FPakFileSumary& Summary, const FPakEntry* InPakEntry) const;
 
-	FPakTreeEntryPtr InsertFileToTree(FPakTreeEntryPtr InRoot, const FPakFileSumary& Summary, const FString& InFullPath, const FPakEntry& InPakEntry);
+	/** Builds all files of one root in a single sorted pass, OutFiles[i] is the file node of InPaths[i]. InPaths are normalized in place. */
+	void BuildTree(FPakTreeEntryPtr InRoot, const FPakFileSumary& Summary, TArray<FString>& InPaths, TFunctionRef<const FPakEntry&(int32)> InGetEntry, TArray<FPakTreeEntryPtr>& OutFiles);
+	static void NormalizeTreePath(FString& InOutPath);
 	bool LoadAssetRegistry(FArrayReader& InData);
 	void RefreshPackageDependency(FPakTreeEntryPtr InTreeRoot, FPakTreeEntryPtr InRoot);
 	void RefreshClassMap(FPakTreeEntryPtr InTreeRoot, FPakTreeEntryPtr InRoot);
@@ -46,12 +63,58 @@ protected:
 	void InsertClassInfo(FPakTreeEntryPtr InTreeRoot, FPakTreeEntryPtr InRoot, FName InClassName, int32 InFileCount, int64 InSize, int64 InCompressedSize);
 	FName GetAssetClass(const FString& InFilename, const FName InPackagePath);
 	FName GetPackagePath(const FString& InFilePath);
+	void LogTreeMemoryUsage() const;
+	/**
+	 * Breaks the reference cycles inside every tree right away, even while a copy of a root is still held.
+	 * Nodes alias the arena reference count, any FPakFileEntryPtr kept past this keeps its whole arena allocated.
+	 */
+	void ReleaseTrees();
+	void RefreshFileIndex();
+	static bool MatchesAnyValue(const FString& InText, const TArray<FString>& InValues);
+	/** Creates the directories of all output files up front, so extract workers can open files without checking them. */
+	static void MakeOutputDirectories(const TArray<FString>& InOutputFilePaths);
+	void StartBuildTrigramIndex();
+	void StopBuildTrigramIndex();
+	/** Sends the result to the game thread, callable from any thread. */
+	void FinishVerify(const FVerifyResult& InResult);
+	/** A wrapping analyzer waits for every inner analyzer, so one with nothing to verify still reports. */
+	void FinishEmptyVerify();
 
 protected:
+	// Flat snapshot of all files in tree order, scanned by GetFiles instead of walking the tree
+	struct FFileIndex
+	{
+		TArray<FPakFileEntryPtr> Files;
+		TArray<int32> ClassIds;
+		TArray<FName> Classes;
+		int32 MaxPakIndex = 0;
+		// Columns evaluated by queries without touching the file entries
+		TArray<int64> Sizes;
+		TArray<int64> CompressedSizes;
+		TArray<int32> BlockCounts;
+		TArray<int32> PakIndices;
+		TArray<int32> CompressionIds;
+		TArray<FName> CompressionMethods;
+		TArray<bool> Encrypted;
+		TArray<FString> PakNames;
+		// Changes only when the file list changes, a trigram index built for the same serial can be reused
+		uint32 FileListSerial = 0;
+	};
+
 	FCriticalSection CriticalSection;
+	TSharedPtr<const FFileIndex, ESPMode::ThreadSafe> FileIndex;
+	TSharedPtr<const FPathTrigramIndex, ESPMode::ThreadSafe> TrigramIndex;
+	uint32 FileListSerialCounter = 0;
+
+	bool bTrigramIndexEnabled = true;
+	FPakAnalyzerDelegates::FOnVerifyFinish VerifyFinishHandler;
+	TFuture<void> TrigramIndexTask;
+	TAtomic<bool> bCancelTrigramIndex;
 
 	TArray<FPakFileSumaryPtr> PakFileSummaries;
 	TArray<FPakTreeEntryPtr> PakTreeRoots;
+	// Process used physical memory after the previous trees were released
+	uint64 LoadStartUsedPhysical = 0;
 	TMap<FName, FName> DefaultClassMap;
 
 	FString AssetRegistryPath;
@@ -0,0 +1,94 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "CacheFile.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+
+#include "CommonDefines.h"
+
+bool FCacheFile::Load(const FString& InPath, uint32 InMagic, int32 InVersion, int64 InMaxSize, TFunctionRef<bool(FArchive&)> InReadBody)
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	const int64 FileSize = FileManager.FileSize(*InPath);
+	if (FileSize < 0)
+	{
+		return false;
+	}
+
+	if (FileSize > InMaxSize)
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Cache file is too large, delete it: %s, %lld bytes."), *InPath, FileSize);
+		FileManager.Delete(*InPath, false, true, true);
+		return false;
+	}
+
+	TArray<uint8> Content;
+	if (!FFileHelper::LoadFileToArray(Content, *InPath, FILEREAD_Silent))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Content);
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	Reader << Magic;
+	Reader << Version;
+	if (Reader.IsError() || Magic != InMagic || Version != InVersion)
+	{
+		UE_LOG(LogPakAnalyzer, Log, TEXT("Cache file is out of date: %s."), *InPath);
+		return false;
+	}
+
+	if (!InReadBody(Reader))
+	{
+		return false;
+	}
+
+	if (Reader.IsError())
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Cache file is corrupted: %s."), *InPath);
+		return false;
+	}
+
+	return true;
+}
+
+bool FCacheFile::Save(const FString& InPath, uint32 InMagic, int32 InVersion, TFunctionRef<void(FArchive&)> InWriteBody)
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	const FString TempPath = FPaths::CreateTempFilename(*FPaths::GetPath(InPath), *FPaths::GetBaseFilename(InPath), TEXT(".tmp"));
+
+	FArchive* Writer = FileManager.CreateFileWriter(*TempPath);
+	if (!Writer)
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Create cache file failed: %s."), *TempPath);
+		return false;
+	}
+
+	uint32 Magic = InMagic;
+	int32 Version = InVersion;
+	*Writer << Magic;
+	*Writer << Version;
+
+	InWriteBody(*Writer);
+
+	const bool bWriteResult = !Writer->IsError();
+	Writer->Close();
+	delete Writer;
+
+	// Readers only ever see a complete file
+	if (!bWriteResult || !FileManager.Move(*InPath, *TempPath, true, true))
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Save cache file failed: %s."), *InPath);
+		FileManager.Delete(*TempPath, false, true, true);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,22 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Versioned binary files under Saved used by the pak index and asset summary caches.
+ * Files start with a magic and a version, a file with other values is ignored and rewritten by the next Save.
+ */
+class FCacheFile
+{
+public:
+	/**
+	 * Reads the whole file and passes the body after the header to InReadBody.
+	 * Files larger than InMaxSize are deleted without being read.
+	 */
+	static bool Load(const FString& InPath, uint32 InMagic, int32 InVersion, int64 InMaxSize, TFunctionRef<bool(FArchive&)> InReadBody);
+
+	/** Writes to a temp file unique to this process and moves it into place, a crash or a second instance never leaves a partial file. */
+	static bool Save(const FString& InPath, uint32 InMagic, int32 InVersion, TFunctionRef<void(FArchive&)> InWriteBody);
+};
@@ -0,0 +1,148 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "ExtractJournal.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+
+#include "CommonDefines.h"
+
+// Flush every so many records, so a crash loses only the last few completions
+static const int32 EXTRACT_JOURNAL_FLUSH_INTERVAL = 256;
+
+FExtractJournal::~FExtractJournal()
+{
+	Close();
+}
+
+FExtractJournalRecord FExtractJournal::MakeRecord(const FPakFileEntry& InFile, const FString& InPakName)
+{
+	FExtractJournalRecord Record;
+	Record.Path = InFile.Path.ToString();
+	Record.PakName = InPakName;
+	Record.Offset = InFile.PakEntry.Offset;
+	Record.Size = InFile.PakEntry.UncompressedSize;
+	Record.Hash = BytesToHex(InFile.PakEntry.Hash, sizeof(InFile.PakEntry.Hash));
+
+	return Record;
+}
+
+void FExtractJournal::Load(const FString& InOutputPath)
+{
+	Records.Empty();
+
+	TArray<FString> Lines;
+	if (!FFileHelper::LoadFileToStringArray(Lines, *GetJournalPath(InOutputPath)))
+	{
+		return;
+	}
+
+	TArray<FString> Fields;
+	for (const FString& Line : Lines)
+	{
+		Line.ParseIntoArray(Fields, TEXT("\t"), false);
+		// Link path is optional
+		if (Fields.Num() != 5 && Fields.Num() != 6)
+		{
+			continue;
+		}
+
+		FExtractJournalRecord Record;
+		Record.Path = Fields[0];
+		Record.PakName = Fields[1];
+		LexFromString(Record.Offset, *Fields[2]);
+		LexFromString(Record.Size, *Fields[3]);
+		Record.Hash = Fields[4];
+		Record.LinkPath = Fields.Num() > 5 ? Fields[5] : FString();
+
+		Records.Add(Record.Path, MoveTemp(Record));
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Load extract journal: %d records from %s."), Records.Num(), *InOutputPath);
+}
+
+const FExtractJournalRecord* FExtractJournal::Find(const FString& InPath) const
+{
+	return Records.Find(InPath);
+}
+
+void FExtractJournal::GetLinkedPaths(TSet<FString>& OutPaths) const
+{
+	for (const auto& It : Records)
+	{
+		if (!It.Value.LinkPath.IsEmpty())
+		{
+			OutPaths.Add(It.Key);
+			OutPaths.Add(It.Value.LinkPath);
+		}
+	}
+}
+
+bool FExtractJournal::Open(const FString& InOutputPath, const TSet<FString>& InReplacedPaths)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*GetJournalPath(InOutputPath)));
+	if (!Writer)
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Open extract journal failed! Output: %s"), *InOutputPath);
+		return false;
+	}
+
+	for (const auto& It : Records)
+	{
+		if (!InReplacedPaths.Contains(It.Key))
+		{
+			WriteLine(It.Value);
+		}
+	}
+	Writer->Flush();
+
+	return true;
+}
+
+void FExtractJournal::Append(const FExtractJournalRecord& InRecord)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!Writer)
+	{
+		return;
+	}
+
+	WriteLine(InRecord);
+	if (++UnflushedCount >= EXTRACT_JOURNAL_FLUSH_INTERVAL)
+	{
+		Writer->Flush();
+		UnflushedCount = 0;
+	}
+}
+
+void FExtractJournal::Close()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (Writer)
+	{
+		Writer->Close();
+		Writer.Reset();
+	}
+	UnflushedCount = 0;
+}
+
+FString FExtractJournal::GetJournalPath(const FString& InOutputPath)
+{
+	return InOutputPath / TEXT(".UnrealPakViewer.journal");
+}
+
+void FExtractJournal::WriteLine(const FExtractJournalRecord& InRecord)
+{
+	const FString Line = InRecord.LinkPath.IsEmpty() ?
+		FString::Printf(TEXT("%s\t%s\t%lld\t%lld\t%s\n"), *InRecord.Path, *InRecord.PakName, InRecord.Offset, InRecord.Size, *InRecord.Hash) :
+		FString::Printf(TEXT("%s\t%s\t%lld\t%lld\t%s\t%s\n"), *InRecord.Path, *InRecord.PakName, InRecord.Offset, InRecord.Size, *InRecord.Hash, *InRecord.LinkPath);
+
+	FTCHARToUTF8 Converter(*Line);
+	Writer->Serialize((void*)Converter.Get(), Converter.Length());
+}
@@ -0,0 +1,54 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+#include "PakFileEntry.h"
+
+struct FExtractJournalRecord
+{
+	FString Path;
+	FString PakName;
+	int64 Offset = 0;
+	int64 Size = 0;
+	FString Hash;
+	// Path of the file this one is hardlinked to by deduplicated extraction
+	FString LinkPath;
+};
+
+/**
+ * Text journal in the output directory, one line per extracted file, appended as files complete.
+ * Resume and incremental extraction use it to skip files whose content did not change.
+ */
+class FExtractJournal
+{
+public:
+	~FExtractJournal();
+
+	static FExtractJournalRecord MakeRecord(const FPakFileEntry& InFile, const FString& InPakName);
+
+	/** Loads the journal of earlier extractions, later lines replace earlier lines of the same path. */
+	void Load(const FString& InOutputPath);
+	const FExtractJournalRecord* Find(const FString& InPath) const;
+
+	/** Paths sharing their content with another path through a hardlink. */
+	void GetLinkedPaths(TSet<FString>& OutPaths) const;
+
+	/** Rewrites the journal without the records of paths extracted again and keeps it open for appending. */
+	bool Open(const FString& InOutputPath, const TSet<FString>& InReplacedPaths);
+	void Append(const FExtractJournalRecord& InRecord);
+	void Close();
+
+protected:
+	static FString GetJournalPath(const FString& InOutputPath);
+	void WriteLine(const FExtractJournalRecord& InRecord);
+
+protected:
+	TMap<FString, FExtractJournalRecord> Records;
+
+	FCriticalSection CriticalSection;
+	TUniquePtr<FArchive> Writer;
+	int32 UnflushedCount = 0;
+};
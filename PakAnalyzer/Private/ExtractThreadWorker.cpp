@@ -1,17 +1,432 @@
 #include "ExtractThreadWorker.h"
 
+#include "Async/ParallelFor.h"
 #include "HAL/FileManager.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
 #include "HAL/RunnableThread.h"
 #include "IPlatformFilePak.h"
 #include "Misc/Compression.h"
 #include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
 #include "Serialization/Archive.h"
 
+#if PLATFORM_WINDOWS
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include <Windows.h>
+#include "Windows/HideWindowsPlatformTypes.h"
+#elif PLATFORM_UNIX || PLATFORM_MAC
+#include <unistd.h>
+#endif
+
 #include "CommonDefines.h"
 
-FExtractThreadWorker::FExtractThreadWorker()
+/** Reads from a copy of a pak range in memory, positions are absolute pak offsets. */
+class FPakRangeReader : public FArchive
+{
+public:
+	FPakRangeReader(const TArray<uint8>& InBytes, int64 InBaseOffset)
+		: Bytes(InBytes)
+		, BaseOffset(InBaseOffset)
+		, Pos(InBaseOffset)
+	{
+		SetIsLoading(true);
+	}
+
+	virtual void Serialize(void* Data, int64 Num) override
+	{
+		if (Pos < BaseOffset || Pos + Num > BaseOffset + Bytes.Num())
+		{
+			SetError();
+			return;
+		}
+
+		FMemory::Memcpy(Data, Bytes.GetData() + (Pos - BaseOffset), Num);
+		Pos += Num;
+	}
+
+	virtual void Seek(int64 InPos) override { Pos = InPos; }
+	virtual int64 Tell() override { return Pos; }
+	virtual int64 TotalSize() override { return BaseOffset + Bytes.Num(); }
+	virtual FString GetArchiveName() const override { return TEXT("FPakRangeReader"); }
+
+protected:
+	const TArray<uint8>& Bytes;
+	int64 BaseOffset;
+	int64 Pos;
+};
+
+void FExtractQueue::BuildTasks(const TArray<FPakFileEntry>& InFiles, const TArray<FPakFileSumary>& InSummaries, TArray<FExtractTask>& OutTasks)
+{
+	// Large compressed files are split in ranges of compression blocks, so several workers can share them
+	static const int64 SplitFileSize = 64 * 1024 * 1024;
+	static const int64 SplitPartSize = 16 * 1024 * 1024;
+
+	// Small files close to each other in the same pak are read together
+	static const int64 CoalesceFileSize = 1024 * 1024;
+	static const int64 CoalesceMaxGap = 64 * 1024;
+	static const int64 CoalesceMaxReadSize = 8 * 1024 * 1024;
+
+	OutTasks.Reserve(InFiles.Num());
+
+	int32 CoalescedFileCount = 0;
+	for (int32 FileIndex = 0; FileIndex < InFiles.Num(); ++FileIndex)
+	{
+		const FPakFileEntry& File = InFiles[FileIndex];
+		const FPakEntry& PakEntry = File.PakEntry;
+
+		const int32 BlockCount = PakEntry.CompressionBlocks.Num();
+		if (PakEntry.CompressionMethodIndex != 0 && PakEntry.UncompressedSize >= SplitFileSize && PakEntry.CompressionBlockSize > 0 && BlockCount > 1)
+		{
+			const int32 BlocksPerPart = FMath::Max<int32>(SplitPartSize / PakEntry.CompressionBlockSize, 1);
+			for (int32 BlockStart = 0; BlockStart < BlockCount; BlockStart += BlocksPerPart)
+			{
+				FExtractTask& Task = OutTasks.AddDefaulted_GetRef();
+				Task.FileIndex = FileIndex;
+				Task.BlockStart = BlockStart;
+				Task.BlockEnd = FMath::Min(BlockStart + BlocksPerPart, BlockCount);
+				Task.Size = FMath::Min<int64>((int64)Task.BlockEnd * PakEntry.CompressionBlockSize, PakEntry.UncompressedSize) - (int64)BlockStart * PakEntry.CompressionBlockSize;
+			}
+			continue;
+		}
+
+		const int64 EntryEnd = InSummaries.IsValidIndex(File.OwnerPakIndex) ?
+			PakEntry.Offset + PakEntry.GetSerializedSize(InSummaries[File.OwnerPakIndex].PakInfo.Version) + (PakEntry.IsEncrypted() ? Align(PakEntry.Size, FAES::AESBlockSize) : PakEntry.Size) : 0;
+
+		FExtractTask* LastTask = OutTasks.Num() > 0 ? &OutTasks.Last() : nullptr;
+		const FPakFileEntry* LastFile = LastTask ? &InFiles[LastTask->FileIndex + LastTask->FileCount - 1] : nullptr;
+		const bool bCanCoalesce = LastTask && LastTask->IsWholeFile() && EntryEnd > 0 &&
+			LastFile->OwnerPakIndex == File.OwnerPakIndex && LastFile->PakEntry.Size <= CoalesceFileSize && PakEntry.Size <= CoalesceFileSize &&
+			PakEntry.Offset >= LastTask->ReadOffset + LastTask->ReadSize && PakEntry.Offset - (LastTask->ReadOffset + LastTask->ReadSize) <= CoalesceMaxGap &&
+			EntryEnd - LastTask->ReadOffset <= CoalesceMaxReadSize;
+
+		if (bCanCoalesce)
+		{
+			++LastTask->FileCount;
+			LastTask->Size += PakEntry.UncompressedSize;
+			LastTask->ReadSize = EntryEnd - LastTask->ReadOffset;
+			++CoalescedFileCount;
+		}
+		else
+		{
+			FExtractTask& Task = OutTasks.AddDefaulted_GetRef();
+			Task.FileIndex = FileIndex;
+			Task.Size = PakEntry.UncompressedSize;
+			Task.ReadOffset = PakEntry.Offset;
+			Task.ReadSize = EntryEnd > 0 ? EntryEnd - PakEntry.Offset : 0;
+		}
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Extract plan: %d files in %d tasks, %d files coalesced into adjacent reads."), InFiles.Num(), OutTasks.Num(), CoalescedFileCount);
+}
+
+void FExtractQueue::Initialize(TArray<FPakFileEntry>& InFiles, TArray<FExtractTask>& InTasks, int32 InWorkerCount)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	Files = MoveTemp(InFiles);
+	Tasks = MoveTemp(InTasks);
+
+	// Split tasks in contiguous ranges of about the same size
+	int64 TotalSize = 0;
+	for (const FExtractTask& Task : Tasks)
+	{
+		TotalSize += Task.Size;
+	}
+
+	const int32 WorkerCount = FMath::Max(InWorkerCount, 1);
+	Ranges.SetNum(WorkerCount);
+
+	int32 TaskIndex = 0;
+	int64 AccumulatedSize = 0;
+	for (int32 i = 0; i < WorkerCount; ++i)
+	{
+		Ranges[i].Begin = TaskIndex;
+
+		const int64 TargetSize = TotalSize * (i + 1) / WorkerCount;
+		while (TaskIndex < Tasks.Num() && (AccumulatedSize < TargetSize || i == WorkerCount - 1))
+		{
+			AccumulatedSize += Tasks[TaskIndex].Size;
+			++TaskIndex;
+		}
+
+		Ranges[i].End = TaskIndex;
+	}
+}
+
+void FExtractQueue::SetDuplicates(TMap<int32, TArray<FPakFileEntry>>& InDuplicates)
+{
+	Duplicates = MoveTemp(InDuplicates);
+}
+
+bool FExtractQueue::Pop(int32 InWorkerIndex, FExtractTask& OutTask)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (!Ranges.IsValidIndex(InWorkerIndex))
+	{
+		return false;
+	}
+
+	FTaskRange& OwnRange = Ranges[InWorkerIndex];
+	if (OwnRange.Begin >= OwnRange.End)
+	{
+		int32 VictimIndex = INDEX_NONE;
+		int32 VictimCount = 0;
+		for (int32 i = 0; i < Ranges.Num(); ++i)
+		{
+			const int32 Count = Ranges[i].End - Ranges[i].Begin;
+			if (Count > VictimCount)
+			{
+				VictimIndex = i;
+				VictimCount = Count;
+			}
+		}
+
+		if (VictimIndex == INDEX_NONE)
+		{
+			return false;
+		}
+
+		// Steal the back half, the victim keeps working on the front
+		FTaskRange& VictimRange = Ranges[VictimIndex];
+		const int32 Middle = VictimRange.End - FMath::Max(VictimCount / 2, 1);
+		OwnRange.Begin = Middle;
+		OwnRange.End = VictimRange.End;
+		VictimRange.End = Middle;
+	}
+
+	OutTask = Tasks[OwnRange.Begin++];
+	return true;
+}
+
+FExtractStageQueue::FExtractStageQueue(int32 InCapacity)
+	: Capacity(FMath::Max(InCapacity, 1))
+	, bFinished(false)
+	, bCancelled(false)
+{
+	// Manual reset, a trigger wakes every waiter and is only reset under the lock while the condition is false
+	NotEmptyEvent = FPlatformProcess::GetSynchEventFromPool(true);
+	NotFullEvent = FPlatformProcess::GetSynchEventFromPool(true);
+}
+
+FExtractStageQueue::~FExtractStageQueue()
+{
+	FPlatformProcess::ReturnSynchEventToPool(NotEmptyEvent);
+	FPlatformProcess::ReturnSynchEventToPool(NotFullEvent);
+}
+
+bool FExtractStageQueue::Push(FExtractChunkPtr& InChunk)
+{
+	while (true)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+			if (bCancelled)
+			{
+				return false;
+			}
+
+			if (Chunks.Num() < Capacity)
+			{
+				Chunks.Add(MoveTemp(InChunk));
+				NotEmptyEvent->Trigger();
+				return true;
+			}
+
+			NotFullEvent->Reset();
+		}
+
+		NotFullEvent->Wait();
+	}
+}
+
+bool FExtractStageQueue::Pop(FExtractChunkPtr& OutChunk)
+{
+	while (true)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+			if (bCancelled)
+			{
+				return false;
+			}
+
+			if (Chunks.Num() > 0)
+			{
+				OutChunk = MoveTemp(Chunks[0]);
+				Chunks.RemoveAt(0, 1, EAllowShrinking::No);
+				NotFullEvent->Trigger();
+				return true;
+			}
+
+			if (bFinished)
+			{
+				return false;
+			}
+
+			NotEmptyEvent->Reset();
+		}
+
+		NotEmptyEvent->Wait();
+	}
+}
+
+void FExtractStageQueue::Finish()
+{
+	FScopeLock Lock(&CriticalSection);
+	bFinished = true;
+	NotEmptyEvent->Trigger();
+}
+
+void FExtractStageQueue::Cancel()
+{
+	FScopeLock Lock(&CriticalSection);
+	bCancelled = true;
+	Chunks.Empty();
+	NotEmptyEvent->Trigger();
+	NotFullEvent->Trigger();
+}
+
+FExtractPipeline::FExtractPipeline(int32 InReadCount, int32 InDecodeCount, int32 InWriteCount)
+	: DecodeQueue(InDecodeCount * 2)
+	, ActiveReaders(InReadCount)
+	, ActiveDecoders(InDecodeCount)
+{
+	const int32 WriteCount = FMath::Max(InWriteCount, 1);
+	const int32 WriteQueueCapacity = FMath::Max(InDecodeCount * 2 / WriteCount, 2);
+
+	ActiveWriters.Set(WriteCount);
+	for (int32 i = 0; i < WriteCount; ++i)
+	{
+		WriteQueues.Add(MakeUnique<FExtractStageQueue>(WriteQueueCapacity));
+	}
+
+	// Enough to fill every queue while each worker holds one, the archive writer parks out of order chunks within this limit
+	MaxChunks = FMath::Max(InReadCount, 1) + FMath::Max(InDecodeCount, 1) * 3 + WriteCount * (WriteQueueCapacity + 1);
+
+	ChunkReleasedEvent = FPlatformProcess::GetSynchEventFromPool(true);
+}
+
+FExtractPipeline::~FExtractPipeline()
+{
+	FPlatformProcess::ReturnSynchEventToPool(ChunkReleasedEvent);
+}
+
+FExtractChunkPtr FExtractPipeline::AcquireChunk()
+{
+	while (true)
+	{
+		{
+			FScopeLock Lock(&PoolCriticalSection);
+			if (bCancelled)
+			{
+				return nullptr;
+			}
+
+			if (OutstandingChunks < MaxChunks)
+			{
+				++OutstandingChunks;
+				if (FreeChunks.Num() > 0)
+				{
+					return FreeChunks.Pop(EAllowShrinking::No);
+				}
+				break;
+			}
+
+			ChunkReleasedEvent->Reset();
+		}
+
+		ChunkReleasedEvent->Wait();
+	}
+
+	return MakeUnique<FExtractChunk>();
+}
+
+void FExtractPipeline::ReleaseChunk(FExtractChunkPtr& InChunk)
+{
+	if (!InChunk.IsValid())
+	{
+		return;
+	}
+
+	// Keep the buffers, only reset the description
+	InChunk->FileIndex = INDEX_NONE;
+	InChunk->Sequence = 0;
+	InChunk->BlockStart = 0;
+	InChunk->BlockEnd = INDEX_NONE;
+	InChunk->BlockBase = 0;
+	InChunk->OutputOffset = 0;
+	InChunk->OutputSize = 0;
+	InChunk->bFailed = false;
+
+	FScopeLock Lock(&PoolCriticalSection);
+	FreeChunks.Add(MoveTemp(InChunk));
+	--OutstandingChunks;
+	ChunkReleasedEvent->Trigger();
+}
+
+void FExtractPipeline::OnStageFinished(EExtractStage InStage)
+{
+	if (InStage == EExtractStage::Read)
+	{
+		if (ActiveReaders.Decrement() == 0)
+		{
+			DecodeQueue.Finish();
+		}
+	}
+	else if (InStage == EExtractStage::Decode)
+	{
+		if (ActiveDecoders.Decrement() == 0)
+		{
+			for (TUniquePtr<FExtractStageQueue>& WriteQueue : WriteQueues)
+			{
+				WriteQueue->Finish();
+			}
+		}
+	}
+	else if (InStage == EExtractStage::Write)
+	{
+		if (ActiveWriters.Decrement() == 0)
+		{
+			Journal.Close();
+		}
+	}
+}
+
+bool FExtractPipeline::OpenArchive(const FString& InArchivePath)
+{
+	Archive = MakeUnique<FTarWriter>();
+	if (!Archive->Open(InArchivePath))
+	{
+		Archive.Reset();
+		return false;
+	}
+
+	return true;
+}
+
+void FExtractPipeline::Cancel()
+{
+	{
+		// Set under the pool lock so a reader waiting for a chunk can't miss it
+		FScopeLock Lock(&PoolCriticalSection);
+		bCancelled = true;
+		ChunkReleasedEvent->Trigger();
+	}
+
+	DecodeQueue.Cancel();
+	for (TUniquePtr<FExtractStageQueue>& WriteQueue : WriteQueues)
+	{
+		WriteQueue->Cancel();
+	}
+}
+
+FExtractThreadWorker::FExtractThreadWorker(EExtractStage InStage)
 	: Thread(nullptr)
+	, Stage(InStage)
+	, WorkerIndex(0)
+	, NextSequence(0)
 {
 	Guid = FGuid::NewGuid();
 }
@@ -28,135 +443,572 @@ bool FExtractThreadWorker::Init()
 
 uint32 FExtractThreadWorker::Run()
 {
-	const int64 BufferSize = 8 * 1024 * 1024; // 8MB buffer for extracting
-	void* Buffer = FMemory::Malloc(BufferSize);
-	uint8* PersistantCompressionBuffer = NULL;
-	int64 CompressionBufferSize = 0;
+	FExtractWorkerStats Stats;
+	Stats.Stage = Stage;
+
+	switch (Stage)
+	{
+	case EExtractStage::Read:
+		RunRead(Stats);
+		break;
+	case EExtractStage::Decode:
+		RunDecode(Stats);
+		break;
+	case EExtractStage::Write:
+		if (!Pipeline->GetArchive())
+		{
+			RunWrite(Stats);
+		}
+		else if (WorkerIndex == 0)
+		{
+			RunWriteArchive(Stats);
+		}
+		break;
+	}
+
+	Pipeline->OnStageFinished(Stage);
+
+	if (!IsStopping())
+	{
+		UE_LOG(LogPakAnalyzer, Log, TEXT("Extract worker: %s (stage %d) finished, complete count: %d, error count: %d, %.2f MB/s."), *Guid.ToString(), (int32)Stage, Stats.CompleteCount, Stats.ErrorCount, Stats.GetBytesPerSecond() / 1024.0 / 1024.0);
+	}
+	else
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Extract worker: %s (stage %d) interrupted, complete count: %d, error count: %d."), *Guid.ToString(), (int32)Stage, Stats.CompleteCount, Stats.ErrorCount);
+	}
+
+	Stats.bFinished = true;
+	Stats.FinishTime = FPlatformTime::Seconds();
+	OnUpdateExtractProgress.ExecuteIfBound(Guid, Stats);
+
+	StopTaskCounter.Reset();
+	return 0;
+}
 
-	int32 CompleteCount = 0;
-	int32 ErrorCount = 0;
-	const int32 TotalCount = Files.Num();
+bool FExtractThreadWorker::IsStopping() const
+{
+	return StopTaskCounter.GetValue() > 0 || Pipeline->IsCancelled();
+}
 
+void FExtractThreadWorker::RunRead(FExtractWorkerStats& InOutStats)
+{
 	FArchive* ReaderArchive = nullptr;
 	int32 LastReaderIndex = -1;
 
-	for (const FPakFileEntry& File : Files)
+	TArray<uint8> ReadBuffer;
+	NextSequence = 0;
+
+	FExtractTask Task;
+	while (!IsStopping() && Pipeline->Queue.Pop(WorkerIndex, Task))
+	{
+		const FPakFileEntry& FirstFile = Pipeline->Queue.GetFile(Task.FileIndex);
+
+		if (Summaries.IsValidIndex(FirstFile.OwnerPakIndex) && (!ReaderArchive || FirstFile.OwnerPakIndex != LastReaderIndex))
+		{
+			if (ReaderArchive)
+			{
+				ReaderArchive->Close();
+				delete ReaderArchive;
+				ReaderArchive = nullptr;
+			}
+
+			ReaderArchive = IFileManager::Get().CreateFileReader(*Summaries[FirstFile.OwnerPakIndex].PakFilePath);
+			LastReaderIndex = FirstFile.OwnerPakIndex;
+		}
+
+		const bool bCanRead = Summaries.IsValidIndex(FirstFile.OwnerPakIndex) && ReaderArchive;
+		if (Task.IsCoalesced())
+		{
+			// One sequential read for the whole run, files are cut from memory
+			bool bReadSuccess = false;
+			if (bCanRead)
+			{
+				const double ReadStartTime = FPlatformTime::Seconds();
+
+				ReadBuffer.SetNumUninitialized(Task.ReadSize, EAllowShrinking::No);
+				ReaderArchive->Seek(Task.ReadOffset);
+				ReaderArchive->Serialize(ReadBuffer.GetData(), Task.ReadSize);
+				bReadSuccess = !ReaderArchive->IsError();
+
+				InOutStats.BusySeconds += FPlatformTime::Seconds() - ReadStartTime;
+				InOutStats.ExtractedBytes += Task.ReadSize;
+			}
+
+			FPakRangeReader RangeReader(ReadBuffer, Task.ReadOffset);
+			for (int32 i = 0; i < Task.FileCount; ++i)
+			{
+				const int32 FileIndex = Task.FileIndex + i;
+				const bool bPushed = bReadSuccess ? ReadFile(FileIndex, Task, RangeReader, InOutStats) : PushFailedChunk(FileIndex, 0, Pipeline->Queue.GetFile(FileIndex).PakEntry.UncompressedSize);
+				if (!bPushed)
+				{
+					break;
+				}
+			}
+		}
+		else if (bCanRead)
+		{
+			ReadFile(Task.FileIndex, Task, *ReaderArchive, InOutStats);
+		}
+		else
+		{
+			PushFailedChunk(Task.FileIndex, (int64)Task.BlockStart * FirstFile.PakEntry.CompressionBlockSize, Task.IsWholeFile() ? FirstFile.PakEntry.UncompressedSize : Task.Size);
+		}
+	}
+
+	if (ReaderArchive)
+	{
+		ReaderArchive->Close();
+		delete ReaderArchive;
+		ReaderArchive = nullptr;
+	}
+}
+
+bool FExtractThreadWorker::ReadFile(int32 InFileIndex, const FExtractTask& InTask, FArchive& InReader, FExtractWorkerStats& InOutStats)
+{
+	// Chunks are cut on compression block boundaries, stored data is cut on AES block boundaries
+	static const int64 ChunkSize = 8 * 1024 * 1024;
+
+	const FPakFileEntry& File = Pipeline->Queue.GetFile(InFileIndex);
+	const FPakFileSumary& Summary = Summaries[File.OwnerPakIndex];
+	const FPakEntry& Entry = File.PakEntry;
+
+	const int64 TaskOutputOffset = (int64)InTask.BlockStart * Entry.CompressionBlockSize;
+	const int64 TaskOutputSize = InTask.IsWholeFile() ? Entry.UncompressedSize : InTask.Size;
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	InReader.Seek(Entry.Offset);
+
+	FPakEntry EntryInfo;
+	EntryInfo.Serialize(InReader, Summary.PakInfo.Version);
+	if (InReader.IsError() || !(Entry == EntryInfo))
 	{
-		if (StopTaskCounter.GetValue() > 0)
+		UE_LOG(LogPakAnalyzer, Error, TEXT("Extract file failed! PakEntry mismatch! File: %s"), *File.Path);
+		return PushFailedChunk(InFileIndex, TaskOutputOffset, TaskOutputSize);
+	}
+
+	if (Entry.CompressionMethodIndex == 0)
+	{
+		const int64 DataOffset = InReader.Tell();
+		int64 Offset = 0;
+		do
+		{
+			FExtractChunkPtr Chunk = Pipeline->AcquireChunk();
+			if (!Chunk)
+			{
+				return false;
+			}
+
+			Chunk->FileIndex = InFileIndex;
+			Chunk->OutputOffset = Offset;
+			Chunk->OutputSize = FMath::Min(ChunkSize, Entry.Size - Offset);
+
+			const int64 SizeToRead = Entry.IsEncrypted() ? Align(Chunk->OutputSize, FAES::AESBlockSize) : Chunk->OutputSize;
+			Chunk->Data.SetNumUninitialized(SizeToRead, EAllowShrinking::No);
+
+			const double ReadStartTime = FPlatformTime::Seconds();
+			InReader.Seek(DataOffset + Offset);
+			InReader.Serialize(Chunk->Data.GetData(), SizeToRead);
+			Chunk->bFailed = InReader.IsError();
+			InOutStats.BusySeconds += FPlatformTime::Seconds() - ReadStartTime;
+			InOutStats.ExtractedBytes += SizeToRead;
+
+			Offset += Chunk->OutputSize;
+			if (!PushReadChunk(Chunk))
+			{
+				return false;
+			}
+		} while (Offset < Entry.Size);
+
+		return true;
+	}
+
+	const int32 BlockCount = Entry.CompressionBlocks.Num();
+	if (Entry.UncompressedSize == 0 || Entry.CompressionBlockSize == 0 || BlockCount == 0)
+	{
+		UE_LOG(LogPakAnalyzer, Error, TEXT("Extract compressed file failed! File: %s"), *File.Path);
+		return PushFailedChunk(InFileIndex, TaskOutputOffset, TaskOutputSize);
+	}
+
+	const int64 BaseOffset = Summary.PakInfo.Version >= FPakInfo::PakFile_Version_RelativeChunkOffsets ? Entry.Offset : 0;
+	const int32 BlocksPerChunk = FMath::Max<int32>(ChunkSize / Entry.CompressionBlockSize, 1);
+	const int32 TaskBlockEnd = InTask.IsWholeFile() ? BlockCount : FMath::Min(InTask.BlockEnd, BlockCount);
+
+	InOutStats.BusySeconds += FPlatformTime::Seconds() - StartTime;
+
+	for (int32 BlockStart = InTask.BlockStart; BlockStart < TaskBlockEnd; BlockStart += BlocksPerChunk)
+	{
+		FExtractChunkPtr Chunk = Pipeline->AcquireChunk();
+		if (!Chunk)
+		{
+			return false;
+		}
+
+		Chunk->FileIndex = InFileIndex;
+		Chunk->BlockStart = BlockStart;
+		Chunk->BlockEnd = FMath::Min(BlockStart + BlocksPerChunk, TaskBlockEnd);
+		Chunk->OutputOffset = (int64)BlockStart * Entry.CompressionBlockSize;
+		Chunk->OutputSize = FMath::Min<int64>((int64)Chunk->BlockEnd * Entry.CompressionBlockSize, Entry.UncompressedSize) - Chunk->OutputOffset;
+
+		int64 RangeStart = MAX_int64;
+		int64 RangeEnd = 0;
+		for (int32 BlockIndex = Chunk->BlockStart; BlockIndex < Chunk->BlockEnd; ++BlockIndex)
+		{
+			const FPakCompressedBlock& Block = Entry.CompressionBlocks[BlockIndex];
+			const int64 CompressedBlockSize = Block.CompressedEnd - Block.CompressedStart;
+			RangeStart = FMath::Min(RangeStart, Block.CompressedStart);
+			RangeEnd = FMath::Max(RangeEnd, Block.CompressedStart + (Entry.IsEncrypted() ? Align(CompressedBlockSize, FAES::AESBlockSize) : CompressedBlockSize));
+		}
+
+		Chunk->BlockBase = RangeStart;
+		Chunk->Data.SetNumUninitialized(RangeEnd - RangeStart, EAllowShrinking::No);
+
+		const double ReadStartTime = FPlatformTime::Seconds();
+		InReader.Seek(RangeStart + BaseOffset);
+		InReader.Serialize(Chunk->Data.GetData(), Chunk->Data.Num());
+		Chunk->bFailed = InReader.IsError();
+		InOutStats.BusySeconds += FPlatformTime::Seconds() - ReadStartTime;
+		InOutStats.ExtractedBytes += Chunk->Data.Num();
+
+		if (!PushReadChunk(Chunk))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FExtractThreadWorker::PushFailedChunk(int32 InFileIndex, int64 InOutputOffset, int64 InOutputSize)
+{
+	// Failed chunks still carry their size, so the writer knows when the file is done
+	FExtractChunkPtr Chunk = Pipeline->AcquireChunk();
+	if (!Chunk)
+	{
+		return false;
+	}
+
+	Chunk->FileIndex = InFileIndex;
+	Chunk->OutputOffset = InOutputOffset;
+	Chunk->OutputSize = InOutputSize;
+	Chunk->bFailed = true;
+
+	return PushReadChunk(Chunk);
+}
+
+bool FExtractThreadWorker::PushReadChunk(FExtractChunkPtr& InChunk)
+{
+	InChunk->Sequence = NextSequence++;
+	return Pipeline->GetDecodeQueue().Push(InChunk);
+}
+
+void FExtractThreadWorker::RunDecode(FExtractWorkerStats& InOutStats)
+{
+	FExtractChunkPtr Chunk;
+	while (!IsStopping() && Pipeline->GetDecodeQueue().Pop(Chunk))
+	{
+		if (!Chunk->bFailed)
+		{
+			const double StartTime = FPlatformTime::Seconds();
+
+			Chunk->bFailed = !DecodeChunk(*Chunk);
+
+			InOutStats.BusySeconds += FPlatformTime::Seconds() - StartTime;
+			InOutStats.ExtractedBytes += Chunk->OutputSize;
+		}
+
+		if (!Pipeline->GetWriteQueueForFile(Chunk->FileIndex).Push(Chunk))
 		{
 			break;
 		}
+	}
+
+	Pipeline->ReleaseChunk(Chunk);
+}
 
-		if (!Summaries.IsValidIndex(File.OwnerPakIndex))
+bool FExtractThreadWorker::DecodeChunk(FExtractChunk& InChunk)
+{
+	const FPakFileEntry& File = Pipeline->Queue.GetFile(InChunk.FileIndex);
+	const FPakFileSumary& Summary = Summaries[File.OwnerPakIndex];
+	const FPakEntry& Entry = File.PakEntry;
+
+	if (InChunk.BlockEnd == INDEX_NONE)
+	{
+		if (Entry.IsEncrypted())
 		{
-			continue;
+			FAES::DecryptData(InChunk.Data.GetData(), InChunk.Data.Num(), Summary.DecryptAESKey);
+		}
+
+		// Stored data is written as is, padding past OutputSize is ignored
+		Swap(InChunk.Data, InChunk.Output);
+		return true;
+	}
+
+	InChunk.Output.SetNumUninitialized(InChunk.OutputSize, EAllowShrinking::No);
+
+	for (int32 BlockIndex = InChunk.BlockStart; BlockIndex < InChunk.BlockEnd; ++BlockIndex)
+	{
+		uint8* CompressedData = InChunk.Data.GetData() + (Entry.CompressionBlocks[BlockIndex].CompressedStart - InChunk.BlockBase);
+		uint8* UncompressedData = InChunk.Output.GetData() + ((int64)BlockIndex * Entry.CompressionBlockSize - InChunk.OutputOffset);
+		if (!DecodeBlock(Entry, BlockIndex, CompressedData, UncompressedData, Summary.DecryptAESKey, File.CompressionMethod))
+		{
+			UE_LOG(LogPakAnalyzer, Error, TEXT("Extract compressed file failed! File: %s, block: %d"), *File.Path, BlockIndex);
+			return false;
 		}
+	}
 
-		const FPakFileSumary& Summary = Summaries[File.OwnerPakIndex];
+	return true;
+}
+
+void FExtractThreadWorker::RunWrite(FExtractWorkerStats& InOutStats)
+{
+	struct FOpenFile
+	{
+		TUniquePtr<FArchive> Handle;
+		int64 RemainingSize = 0;
+		bool bFailed = false;
+	};
+
+	TMap<int32, FOpenFile> OpenFiles;
+	FExtractStageQueue& WriteQueue = Pipeline->GetWriteQueue(WorkerIndex);
+
+	FExtractChunkPtr Chunk;
+	while (!IsStopping() && WriteQueue.Pop(Chunk))
+	{
+		const double StartTime = FPlatformTime::Seconds();
+		const int32 FileIndex = Chunk->FileIndex;
 
-		if (!ReaderArchive || File.OwnerPakIndex != LastReaderIndex)
+		FOpenFile* OpenFile = OpenFiles.Find(FileIndex);
+		if (!OpenFile)
 		{
-			if (ReaderArchive)
+			OpenFile = &OpenFiles.Add(FileIndex);
+			OpenFile->RemainingSize = Pipeline->Queue.GetFile(FileIndex).PakEntry.UncompressedSize;
+		}
+
+		if (Chunk->bFailed)
+		{
+			OpenFile->bFailed = true;
+		}
+		else if (!OpenFile->bFailed && !OpenFile->Handle)
+		{
+			// Opened on the first good chunk, a file which failed before that never touches the output
+			const FString OutputFilePath = OutputPath / *Pipeline->Queue.GetFile(FileIndex).Path;
+
+			// Directories were created before the extraction started
+			OpenFile->Handle.Reset(IFileManager::Get().CreateFileWriter(*OutputFilePath));
+			if (!OpenFile->Handle)
 			{
-				ReaderArchive->Close();
-				delete ReaderArchive;
-				ReaderArchive = nullptr;
+				UE_LOG(LogPakAnalyzer, Error, TEXT("Open local file to write failed! File: %s"), *OutputFilePath);
+				OpenFile->bFailed = true;
 			}
+		}
 
-			ReaderArchive = IFileManager::Get().CreateFileReader(*Summary.PakFilePath);
-			LastReaderIndex = File.OwnerPakIndex;
+		if (!OpenFile->bFailed && OpenFile->Handle)
+		{
+			// Chunks of a file may arrive out of order from the decoders
+			if (OpenFile->Handle->Tell() != Chunk->OutputOffset)
+			{
+				OpenFile->Handle->Seek(Chunk->OutputOffset);
+			}
+			OpenFile->Handle->Serialize(Chunk->Output.GetData(), Chunk->OutputSize);
+			InOutStats.ExtractedBytes += Chunk->OutputSize;
 		}
 
-		if (!ReaderArchive)
+		OpenFile->RemainingSize -= Chunk->OutputSize;
+		Pipeline->ReleaseChunk(Chunk);
+
+		if (OpenFile->RemainingSize <= 0)
 		{
-			++ErrorCount;
+			if (OpenFile->Handle)
+			{
+				OpenFile->bFailed |= !OpenFile->Handle->Close();
+			}
+
+			++InOutStats.CompleteCount;
+			if (OpenFile->bFailed)
+			{
+				++InOutStats.ErrorCount;
+			}
+			else
+			{
+				const FPakFileEntry& File = Pipeline->Queue.GetFile(FileIndex);
+				Pipeline->Journal.Append(FExtractJournal::MakeRecord(File, FPaths::GetCleanFilename(Summaries[File.OwnerPakIndex].PakFilePath)));
+			}
+			WriteDuplicates(FileIndex, !OpenFile->bFailed, InOutStats);
+			OpenFiles.Remove(FileIndex);
+
+			InOutStats.BusySeconds += FPlatformTime::Seconds() - StartTime;
+			OnUpdateExtractProgress.ExecuteIfBound(Guid, InOutStats);
 		}
 		else
 		{
-			const bool bHasRelativeCompressedChunkOffsets = Summary.PakInfo.Version >= FPakInfo::PakFile_Version_RelativeChunkOffsets;
+			InOutStats.BusySeconds += FPlatformTime::Seconds() - StartTime;
+		}
+	}
 
-			ReaderArchive->Seek(File.PakEntry.Offset);
+	Pipeline->ReleaseChunk(Chunk);
+}
+
+void FExtractThreadWorker::RunWriteArchive(FExtractWorkerStats& InOutStats)
+{
+	FTarWriter& Archive = *Pipeline->GetArchive();
+	FExtractStageQueue& WriteQueue = Pipeline->GetWriteQueue(WorkerIndex);
 
-			FPakEntry EntryInfo;
-			EntryInfo.Serialize(*ReaderArchive, Summary.PakInfo.Version);
-			if (File.PakEntry == EntryInfo)
+	// Decoders finish chunks out of order, the archive is written in read order
+	TMap<int64, FExtractChunkPtr> PendingChunks;
+	int64 WriteSequence = 0;
+
+	int32 FileIndex = INDEX_NONE;
+	int64 RemainingSize = 0;
+	bool bFileFailed = false;
+
+	FExtractChunkPtr Chunk;
+	while (!IsStopping() && WriteQueue.Pop(Chunk))
+	{
+		const double StartTime = FPlatformTime::Seconds();
+
+		PendingChunks.Add(Chunk->Sequence, MoveTemp(Chunk));
+
+		while (FExtractChunkPtr* NextChunk = PendingChunks.Find(WriteSequence))
+		{
+			FExtractChunkPtr ReadyChunk = MoveTemp(*NextChunk);
+			PendingChunks.Remove(WriteSequence);
+			++WriteSequence;
+
+			if (FileIndex == INDEX_NONE)
 			{
-				const FString OutputFilePath = OutputPath / File.Path;
-				const FString BasePath = FPaths::GetPath(OutputFilePath);
-				if (!FPaths::DirectoryExists(BasePath))
-				{
-					IFileManager::Get().MakeDirectory(*BasePath, true);
-				}
+				const FPakFileEntry& File = Pipeline->Queue.GetFile(ReadyChunk->FileIndex);
+				FileIndex = ReadyChunk->FileIndex;
+				RemainingSize = File.PakEntry.UncompressedSize;
+				bFileFailed = false;
+				Archive.BeginFile(*File.Path, RemainingSize);
+			}
 
-				TUniquePtr<FArchive> FileHandle(IFileManager::Get().CreateFileWriter(*OutputFilePath));
-				if (FileHandle)
-				{
-					if (EntryInfo.CompressionMethodIndex == 0)
-					{
-						if (!BufferedCopyFile(*FileHandle, *ReaderArchive, File.PakEntry, Buffer, BufferSize, Summary.DecryptAESKey))
-						{
-							// Add to failed list
-							++ErrorCount;
-							UE_LOG(LogPakAnalyzer, Error, TEXT("Extract none-compressed file failed! File: %s"), *File.Path);
-						}
-					}
-					else
-					{
-						if (!UncompressCopyFile(*FileHandle, *ReaderArchive, File.PakEntry, PersistantCompressionBuffer, CompressionBufferSize, Summary.DecryptAESKey, File.CompressionMethod, bHasRelativeCompressedChunkOffsets))
-						{
-							// Add to failed list
-							++ErrorCount;
-							UE_LOG(LogPakAnalyzer, Error, TEXT("Extract compressed file failed! File: %s"), *File.Path);
-						}
-					}
-				}
-				else
-				{
-					// open to write failed
-					++ErrorCount;
-					UE_LOG(LogPakAnalyzer, Error, TEXT("Open local file to write failed! File: %s"), *OutputFilePath);
-				}
+			// The header already holds the size, failed ranges are filled with zeros
+			if (ReadyChunk->bFailed)
+			{
+				Archive.WriteZeros(ReadyChunk->OutputSize);
+				bFileFailed = true;
 			}
 			else
 			{
-				// mismatch
-				++ErrorCount;
-				UE_LOG(LogPakAnalyzer, Error, TEXT("Extract file failed! PakEntry mismatch! File: %s"), *File.Path);
+				Archive.Write(ReadyChunk->Output.GetData(), ReadyChunk->OutputSize);
+			}
+			InOutStats.ExtractedBytes += ReadyChunk->OutputSize;
+
+			RemainingSize -= ReadyChunk->OutputSize;
+			Pipeline->ReleaseChunk(ReadyChunk);
+
+			if (RemainingSize <= 0)
+			{
+				Archive.EndFile();
+
+				++InOutStats.CompleteCount;
+				if (bFileFailed || Archive.IsError())
+				{
+					++InOutStats.ErrorCount;
+				}
+				WriteDuplicates(FileIndex, !bFileFailed, InOutStats);
+				FileIndex = INDEX_NONE;
+
+				OnUpdateExtractProgress.ExecuteIfBound(Guid, InOutStats);
 			}
 		}
 
-		++CompleteCount;
+		InOutStats.BusySeconds += FPlatformTime::Seconds() - StartTime;
+	}
 
-		OnUpdateExtractProgress.ExecuteIfBound(Guid, CompleteCount, ErrorCount, TotalCount);
+	for (auto& It : PendingChunks)
+	{
+		Pipeline->ReleaseChunk(It.Value);
 	}
+	Pipeline->ReleaseChunk(Chunk);
 
-	FMemory::Free(Buffer);
-	FMemory::Free(PersistantCompressionBuffer);
+	// An interrupted archive is left without the end marker
+	if (!Archive.Close(!IsStopping()))
+	{
+		UE_LOG(LogPakAnalyzer, Error, TEXT("Write archive failed! Archive: %s"), *OutputPath);
+	}
+}
 
-	if (ReaderArchive)
+void FExtractThreadWorker::WriteDuplicates(int32 InFileIndex, bool bInSuccess, FExtractWorkerStats& InOutStats)
+{
+	const TArray<FPakFileEntry>* Duplicates = Pipeline->Queue.GetDuplicates(InFileIndex);
+	if (!Duplicates)
 	{
-		ReaderArchive->Close();
-		delete ReaderArchive;
-		ReaderArchive = nullptr;
+		return;
+	}
+
+	const FPakFileEntry& File = Pipeline->Queue.GetFile(InFileIndex);
+	const FString SourcePath = OutputPath / *File.Path;
+	FTarWriter* Archive = Pipeline->GetArchive();
+	for (const FPakFileEntry& Duplicate : *Duplicates)
+	{
+		bool bLinked = false;
+		if (Archive)
+		{
+			// Archive links always point to the content, even when it failed to extract
+			Archive->AddHardLink(*Duplicate.Path, *File.Path);
+			bLinked = bInSuccess;
+		}
+		else
+		{
+			bLinked = bInSuccess && LinkOrCopyFile(SourcePath, OutputPath / *Duplicate.Path);
+		}
+
+		++InOutStats.CompleteCount;
+		if (bLinked)
+		{
+			FExtractJournalRecord Record = FExtractJournal::MakeRecord(Duplicate, FPaths::GetCleanFilename(Summaries[Duplicate.OwnerPakIndex].PakFilePath));
+			Record.LinkPath = File.Path.ToString();
+			Pipeline->Journal.Append(Record);
+		}
+		else
+		{
+			++InOutStats.ErrorCount;
+		}
 	}
-	
+}
+
+bool FExtractThreadWorker::LinkOrCopyFile(const FString& InSourcePath, const FString& InLinkPath)
+{
+	IFileManager& FileManager = IFileManager::Get();
+
+	// A link can not replace an existing file
+	FileManager.Delete(*InLinkPath, false, true, true);
 
-	if (CompleteCount == TotalCount)
+	const FString FullSourcePath = FPaths::ConvertRelativePathToFull(InSourcePath);
+	const FString FullLinkPath = FPaths::ConvertRelativePathToFull(InLinkPath);
+#if PLATFORM_WINDOWS
+	if (::CreateHardLinkW(*FullLinkPath, *FullSourcePath, nullptr))
 	{
-		UE_LOG(LogPakAnalyzer, Log, TEXT("Extract worker: %s finished, file count: %d, error count: %d."), *Guid.ToString(), TotalCount, ErrorCount);
+		return true;
 	}
-	else
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	if (::link(TCHAR_TO_UTF8(*FullSourcePath), TCHAR_TO_UTF8(*FullLinkPath)) == 0)
 	{
-		UE_LOG(LogPakAnalyzer, Warning, TEXT("Extract worker: %s interrupted, file count: %d, complete count: %d, error count: %d."), *Guid.ToString(), TotalCount, CompleteCount, ErrorCount);
+		return true;
 	}
+#endif
 
-	StopTaskCounter.Reset();
-	return 0;
+	// Different volumes or no link support
+	if (FileManager.Copy(*InLinkPath, *InSourcePath) == COPY_OK)
+	{
+		return true;
+	}
+
+	UE_LOG(LogPakAnalyzer, Error, TEXT("Link duplicate file failed! Source: %s, file: %s"), *InSourcePath, *InLinkPath);
+	return false;
 }
 
 void FExtractThreadWorker::Stop()
 {
 	StopTaskCounter.Increment();
+	if (Pipeline.IsValid())
+	{
+		// Wakes up workers waiting on a queue
+		Pipeline->Cancel();
+	}
 	EnsureCompletion();
 	StopTaskCounter.Reset();
 }
@@ -187,95 +1039,161 @@ void FExtractThreadWorker::EnsureCompletion()
 	}
 }
 
-void FExtractThreadWorker::StartExtract(const TArray<FPakFileSumary>& InSummaries, const FString& InOutputPath)
+void FExtractThreadWorker::StartExtract(const TArray<FPakFileSumary>& InSummaries, const FString& InOutputPath, TSharedPtr<FExtractPipeline, ESPMode::ThreadSafe> InPipeline, int32 InWorkerIndex)
 {
 	Shutdown();
 
-	UE_LOG(LogPakAnalyzer, Log, TEXT("Start extract worker: %s, output: %s, file count: %d."), *Guid.ToString(), *InOutputPath, Files.Num());
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Start extract worker: %s, output: %s."), *Guid.ToString(), *InOutputPath);
 
 	Summaries = InSummaries;
 	OutputPath = InOutputPath;
+	Pipeline = InPipeline;
+	WorkerIndex = InWorkerIndex;
 
 	Thread = FRunnableThread::Create(this, TEXT("ExtractThreadWorker"), 0, EThreadPriority::TPri_Highest);
 }
 
-void FExtractThreadWorker::InitTaskFiles(TArray<FPakFileEntry>& InFiles)
-{
-	Files = MoveTemp(InFiles);
-}
-
 FExtractThreadWorker::FOnUpdateExtractProgress& FExtractThreadWorker::GetOnUpdateExtractProgressDelegate()
 {
 	return OnUpdateExtractProgress;
 }
 
-bool FExtractThreadWorker::BufferedCopyFile(FArchive& Dest, FArchive& Source, const FPakEntry& Entry, void* Buffer, int64 BufferSize, const FAES::FAESKey& InKey)
+bool FExtractThreadWorker::ReadEntryToMemory(FArchive& Source, const FPakEntry& Entry, int32 InPakVersion, const FAES::FAESKey& InKey, FName InCompressionMethod, TArray<uint8>& OutData)
 {
-	// Align down
-	BufferSize = BufferSize & ~(FAES::AESBlockSize - 1);
-	int64 RemainingSizeToCopy = Entry.Size;
-	while (RemainingSizeToCopy > 0)
-	{
-		const int64 SizeToCopy = FMath::Min(BufferSize, RemainingSizeToCopy);
-		// If file is encrypted so we need to account for padding
-		int64 SizeToRead = Entry.IsEncrypted() ? Align(SizeToCopy, FAES::AESBlockSize) : SizeToCopy;
+	// Blocks are decompressed in parallel once an entry has at least this many
+	static const int32 MinParallelBlockCount = 4;
 
-		Source.Serialize(Buffer, SizeToRead);
+	if (Entry.CompressionMethodIndex == 0)
+	{
+		// Source is right behind the entry header
+		const int64 SizeToRead = Entry.IsEncrypted() ? Align(Entry.Size, FAES::AESBlockSize) : Entry.Size;
+		OutData.SetNumUninitialized(SizeToRead, EAllowShrinking::No);
+		Source.Serialize(OutData.GetData(), SizeToRead);
 		if (Entry.IsEncrypted())
 		{
-			FAES::DecryptData((uint8*)Buffer, SizeToRead, InKey);
+			FAES::DecryptData(OutData.GetData(), SizeToRead, InKey);
 		}
-		Dest.Serialize(Buffer, SizeToCopy);
-		RemainingSizeToCopy -= SizeToRead;
+		OutData.SetNum(Entry.Size, EAllowShrinking::No);
+		return !Source.IsError();
 	}
-	return true;
-}
 
-bool FExtractThreadWorker::UncompressCopyFile(FArchive& Dest, FArchive& Source, const FPakEntry& Entry, uint8*& PersistentBuffer, int64& BufferSize, const FAES::FAESKey& InKey, FName InCompressionMethod, bool bHasRelativeCompressedChunkOffsets)
-{
-	if (Entry.UncompressedSize == 0)
+	const int32 BlockCount = Entry.CompressionBlocks.Num();
+	if (Entry.UncompressedSize == 0 || BlockCount == 0)
 	{
 		return false;
 	}
 
-	// The compression block size depends on the bit window that the PAK file was originally created with. Since this isn't stored in the PAK file itself,
-	// we can use FCompression::CompressMemoryBound as a guideline for the max expected size to avoid unncessary reallocations, but we need to make sure
-	// that we check if the actual size is not actually greater (eg. UE-59278).
-	int32 MaxCompressionBlockSize = FCompression::CompressMemoryBound(InCompressionMethod, Entry.CompressionBlockSize);
+	int64 RangeStart = MAX_int64;
+	int64 RangeEnd = 0;
 	for (const FPakCompressedBlock& Block : Entry.CompressionBlocks)
 	{
-		MaxCompressionBlockSize = FMath::Max<int32>(MaxCompressionBlockSize, Block.CompressedEnd - Block.CompressedStart);
+		const int64 CompressedBlockSize = Block.CompressedEnd - Block.CompressedStart;
+		RangeStart = FMath::Min(RangeStart, Block.CompressedStart);
+		RangeEnd = FMath::Max(RangeEnd, Block.CompressedStart + (Entry.IsEncrypted() ? Align(CompressedBlockSize, FAES::AESBlockSize) : CompressedBlockSize));
 	}
 
-	int64 WorkingSize = Entry.CompressionBlockSize + MaxCompressionBlockSize;
-	if (BufferSize < WorkingSize)
+	// One read for all blocks, then every block is decrypted and decompressed into its own output range
+	TArray<uint8> CompressedData;
+	CompressedData.SetNumUninitialized(RangeEnd - RangeStart);
+	Source.Seek(RangeStart + (InPakVersion >= FPakInfo::PakFile_Version_RelativeChunkOffsets ? Entry.Offset : 0));
+	Source.Serialize(CompressedData.GetData(), CompressedData.Num());
+	if (Source.IsError())
 	{
-		PersistentBuffer = (uint8*)FMemory::Realloc(PersistentBuffer, WorkingSize);
-		BufferSize = WorkingSize;
+		return false;
 	}
 
-	uint8* UncompressedBuffer = PersistentBuffer + MaxCompressionBlockSize;
+	OutData.SetNumUninitialized(Entry.UncompressedSize, EAllowShrinking::No);
+
+	FThreadSafeBool bFailed = false;
+	ParallelFor(BlockCount, [&](int32 BlockIndex)
+		{
+			uint8* BlockData = CompressedData.GetData() + (Entry.CompressionBlocks[BlockIndex].CompressedStart - RangeStart);
+			if (!DecodeBlock(Entry, BlockIndex, BlockData, OutData.GetData() + (int64)Entry.CompressionBlockSize * BlockIndex, InKey, InCompressionMethod))
+			{
+				bFailed = true;
+			}
+		}, BlockCount < MinParallelBlockCount);
+
+	return !bFailed;
+}
+
+bool FExtractThreadWorker::ReadEntryPrefix(FArchive& Source, const FPakEntry& Entry, int64 InDataOffset, int32 InPakVersion, const FAES::FAESKey& InKey, FName InCompressionMethod, int64 InSize, TArray<uint8>& InOutData, TArray<uint8>& InOutCompressedData)
+{
+	const int64 CurrentSize = InOutData.Num();
+	const int64 RequestedSize = FMath::Min(InSize, Entry.UncompressedSize);
+	if (CurrentSize >= RequestedSize)
+	{
+		return true;
+	}
 
-	for (uint32 BlockIndex = 0, BlockIndexNum = Entry.CompressionBlocks.Num(); BlockIndex < BlockIndexNum; ++BlockIndex)
+	if (Entry.CompressionMethodIndex == 0)
 	{
-		uint32 CompressedBlockSize = Entry.CompressionBlocks[BlockIndex].CompressedEnd - Entry.CompressionBlocks[BlockIndex].CompressedStart;
-		uint32 UncompressedBlockSize = (uint32)FMath::Min<int64>(Entry.UncompressedSize - Entry.CompressionBlockSize * BlockIndex, Entry.CompressionBlockSize);
-		Source.Seek(Entry.CompressionBlocks[BlockIndex].CompressedStart + (bHasRelativeCompressedChunkOffsets ? Entry.Offset : 0));
-		uint32 SizeToRead = Entry.IsEncrypted() ? Align(CompressedBlockSize, FAES::AESBlockSize) : CompressedBlockSize;
-		Source.Serialize(PersistentBuffer, SizeToRead);
+		// Encrypted data is read in whole AES blocks, the prefix stays aligned until it reaches the end
+		const int64 TargetSize = Entry.IsEncrypted() ? FMath::Min(Align(RequestedSize, FAES::AESBlockSize), Align(Entry.Size, FAES::AESBlockSize)) : RequestedSize;
+		InOutData.SetNumUninitialized(TargetSize, EAllowShrinking::No);
 
+		Source.Seek(InDataOffset + CurrentSize);
+		Source.Serialize(InOutData.GetData() + CurrentSize, TargetSize - CurrentSize);
 		if (Entry.IsEncrypted())
 		{
-			FAES::DecryptData(PersistentBuffer, SizeToRead, InKey);
+			FAES::DecryptData(InOutData.GetData() + CurrentSize, TargetSize - CurrentSize, InKey);
 		}
+		InOutData.SetNum(FMath::Min(TargetSize, Entry.Size), EAllowShrinking::No);
+		return !Source.IsError();
+	}
 
-		if (!FCompression::UncompressMemory(InCompressionMethod, UncompressedBuffer, UncompressedBlockSize, PersistentBuffer, CompressedBlockSize))
+	const int32 BlockCount = Entry.CompressionBlocks.Num();
+	if (Entry.UncompressedSize == 0 || Entry.CompressionBlockSize == 0 || BlockCount == 0)
+	{
+		return false;
+	}
+
+	// A prefix always ends on a block boundary or at the end of the entry
+	const int32 FirstBlock = (int32)(CurrentSize / Entry.CompressionBlockSize);
+	const int32 LastBlock = FMath::Min<int32>((int32)((RequestedSize + Entry.CompressionBlockSize - 1) / Entry.CompressionBlockSize), BlockCount);
+
+	int64 RangeStart = MAX_int64;
+	int64 RangeEnd = 0;
+	for (int32 BlockIndex = FirstBlock; BlockIndex < LastBlock; ++BlockIndex)
+	{
+		const FPakCompressedBlock& Block = Entry.CompressionBlocks[BlockIndex];
+		const int64 CompressedBlockSize = Block.CompressedEnd - Block.CompressedStart;
+		RangeStart = FMath::Min(RangeStart, Block.CompressedStart);
+		RangeEnd = FMath::Max(RangeEnd, Block.CompressedStart + (Entry.IsEncrypted() ? Align(CompressedBlockSize, FAES::AESBlockSize) : CompressedBlockSize));
+	}
+
+	InOutCompressedData.SetNumUninitialized(RangeEnd - RangeStart, EAllowShrinking::No);
+	Source.Seek(RangeStart + (InPakVersion >= FPakInfo::PakFile_Version_RelativeChunkOffsets ? Entry.Offset : 0));
+	Source.Serialize(InOutCompressedData.GetData(), InOutCompressedData.Num());
+	if (Source.IsError())
+	{
+		return false;
+	}
+
+	InOutData.SetNumUninitialized(FMath::Min<int64>((int64)LastBlock * Entry.CompressionBlockSize, Entry.UncompressedSize), EAllowShrinking::No);
+	for (int32 BlockIndex = FirstBlock; BlockIndex < LastBlock; ++BlockIndex)
+	{
+		uint8* BlockData = InOutCompressedData.GetData() + (Entry.CompressionBlocks[BlockIndex].CompressedStart - RangeStart);
+		if (!DecodeBlock(Entry, BlockIndex, BlockData, InOutData.GetData() + (int64)Entry.CompressionBlockSize * BlockIndex, InKey, InCompressionMethod))
 		{
+			InOutData.SetNum((int64)FirstBlock * Entry.CompressionBlockSize, EAllowShrinking::No);
 			return false;
 		}
-
-		Dest.Serialize(UncompressedBuffer, UncompressedBlockSize);
 	}
 
 	return true;
 }
+
+bool FExtractThreadWorker::DecodeBlock(const FPakEntry& Entry, int32 InBlockIndex, uint8* InBlockData, uint8* OutData, const FAES::FAESKey& InKey, FName InCompressionMethod)
+{
+	const FPakCompressedBlock& Block = Entry.CompressionBlocks[InBlockIndex];
+	const uint32 CompressedBlockSize = Block.CompressedEnd - Block.CompressedStart;
+	const uint32 UncompressedBlockSize = (uint32)FMath::Min<int64>(Entry.UncompressedSize - (int64)Entry.CompressionBlockSize * InBlockIndex, Entry.CompressionBlockSize);
+
+	if (Entry.IsEncrypted())
+	{
+		FAES::DecryptData(InBlockData, Align(CompressedBlockSize, FAES::AESBlockSize), InKey);
+	}
+
+	return FCompression::UncompressMemory(InCompressionMethod, OutData, UncompressedBlockSize, InBlockData, CompressedBlockSize);
+}
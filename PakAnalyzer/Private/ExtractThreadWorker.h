@@ -1,19 +1,181 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/Event.h"
 #include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "Misc/AES.h"
 
+#include "CommonDefines.h"
+#include "ExtractJournal.h"
 #include "Misc/Guid.h"
 #include "PakFileEntry.h"
+#include "TarWriter.h"
+
+/**
+ * One unit of extraction work: a whole file, a range of compression blocks of a large file,
+ * or a run of small files which are adjacent in the pak and read with a single read.
+ */
+struct FExtractTask
+{
+	int32 FileIndex = INDEX_NONE;
+	int32 FileCount = 1;
+	int32 BlockStart = 0;
+	int32 BlockEnd = INDEX_NONE;
+	int64 Size = 0;
+
+	// Pak byte range of a coalesced run
+	int64 ReadOffset = 0;
+	int64 ReadSize = 0;
+
+	bool IsWholeFile() const { return BlockEnd == INDEX_NONE; }
+	bool IsCoalesced() const { return FileCount > 1; }
+};
+
+/**
+ * Extraction tasks shared by all pak readers.
+ * Every reader owns a contiguous range of tasks and steals half of the largest remaining range once its own range is empty.
+ */
+class FExtractQueue
+{
+public:
+	/** Builds tasks for files ordered by pak and offset. */
+	static void BuildTasks(const TArray<FPakFileEntry>& InFiles, const TArray<FPakFileSumary>& InSummaries, TArray<FExtractTask>& OutTasks);
+
+	void Initialize(TArray<FPakFileEntry>& InFiles, TArray<FExtractTask>& InTasks, int32 InWorkerCount);
+
+	bool Pop(int32 InWorkerIndex, FExtractTask& OutTask);
+
+	/** Files with the same content as a file of the queue, linked to its output once it is written. */
+	void SetDuplicates(TMap<int32, TArray<FPakFileEntry>>& InDuplicates);
+
+	const FPakFileEntry& GetFile(int32 InFileIndex) const { return Files[InFileIndex]; }
+	int32 GetFileCount() const { return Files.Num(); }
+	const TArray<FPakFileEntry>* GetDuplicates(int32 InFileIndex) const { return Duplicates.Find(InFileIndex); }
+
+protected:
+	struct FTaskRange
+	{
+		int32 Begin = 0;
+		int32 End = 0;
+	};
+
+	FCriticalSection CriticalSection;
+	TArray<FTaskRange> Ranges;
+	TArray<FExtractTask> Tasks;
+	TArray<FPakFileEntry> Files;
+	TMap<int32, TArray<FPakFileEntry>> Duplicates;
+};
+
+/** A range of one file moving through the read, decode and write stages. */
+struct FExtractChunk
+{
+	int32 FileIndex = INDEX_NONE;
+	// Read order, the archive writer restores it after the decoders
+	int64 Sequence = 0;
+
+	// Compression blocks held by Data, BlockEnd is INDEX_NONE for stored data
+	int32 BlockStart = 0;
+	int32 BlockEnd = INDEX_NONE;
+	// Compressed start of the first byte in Data
+	int64 BlockBase = 0;
+
+	int64 OutputOffset = 0;
+	int64 OutputSize = 0;
+	bool bFailed = false;
+
+	TArray<uint8> Data;
+	TArray<uint8> Output;
+};
+
+typedef TUniquePtr<FExtractChunk> FExtractChunkPtr;
+
+/** Bounded blocking queue between two extract stages. */
+class FExtractStageQueue
+{
+public:
+	explicit FExtractStageQueue(int32 InCapacity);
+	~FExtractStageQueue();
+
+	/** Waits while the queue is full, returns false once the extraction is cancelled. */
+	bool Push(FExtractChunkPtr& InChunk);
+
+	/** Waits while the queue is empty, returns false once the producers finished and the queue is drained. */
+	bool Pop(FExtractChunkPtr& OutChunk);
+
+	void Finish();
+	void Cancel();
+
+protected:
+	FCriticalSection CriticalSection;
+	TArray<FExtractChunkPtr> Chunks;
+	int32 Capacity;
+	bool bFinished;
+	bool bCancelled;
+	FEvent* NotEmptyEvent;
+	FEvent* NotFullEvent;
+};
+
+/**
+ * Shared state of one extraction.
+ * Readers pop tasks and push raw chunks, decoders decrypt and decompress them, writers own the output files.
+ * All chunks of a file go to the same writer, chunk buffers are pooled. Writers journal every completed file.
+ * When extracting to an archive, a single reader and the first writer stream all files into it in read order.
+ */
+class FExtractPipeline
+{
+public:
+	FExtractPipeline(int32 InReadCount, int32 InDecodeCount, int32 InWriteCount);
+	~FExtractPipeline();
+
+	/** Waits while the chunk limit is reached, returns null once the extraction is cancelled. */
+	FExtractChunkPtr AcquireChunk();
+	void ReleaseChunk(FExtractChunkPtr& InChunk);
+
+	FExtractStageQueue& GetDecodeQueue() { return DecodeQueue; }
+	FExtractStageQueue& GetWriteQueue(int32 InWriterIndex) { return *WriteQueues[InWriterIndex]; }
+	FExtractStageQueue& GetWriteQueueForFile(int32 InFileIndex) { return *WriteQueues[Archive ? 0 : InFileIndex % WriteQueues.Num()]; }
+
+	bool OpenArchive(const FString& InArchivePath);
+	FTarWriter* GetArchive() const { return Archive.Get(); }
+
+	/** Finishes the next stage once the last worker of a stage is done. */
+	void OnStageFinished(EExtractStage InStage);
+
+	void Cancel();
+	bool IsCancelled() const { return bCancelled; }
+
+public:
+	FExtractQueue Queue;
+	FExtractJournal Journal;
+
+protected:
+	FCriticalSection PoolCriticalSection;
+	TArray<FExtractChunkPtr> FreeChunks;
+	// Chunks handed out and not released yet, bounds the memory of one extraction
+	int32 OutstandingChunks = 0;
+	int32 MaxChunks = 0;
+	FEvent* ChunkReleasedEvent = nullptr;
+
+	FExtractStageQueue DecodeQueue;
+	TArray<TUniquePtr<FExtractStageQueue>> WriteQueues;
+
+	FThreadSafeCounter ActiveReaders;
+	FThreadSafeCounter ActiveDecoders;
+	FThreadSafeCounter ActiveWriters;
+	FThreadSafeBool bCancelled;
+
+	TUniquePtr<FTarWriter> Archive;
+};
 
 class FExtractThreadWorker : public FRunnable
 {
 public:
-	DECLARE_DELEGATE_FourParams(FOnUpdateExtractProgress, const FGuid& /*WorkerGuid*/, int32 /*CompleteCount*/, int32 /*ErrorCount*/, int32 /*TotalCount*/);
+	DECLARE_DELEGATE_TwoParams(FOnUpdateExtractProgress, const FGuid& /*WorkerGuid*/, const FExtractWorkerStats& /*Stats*/);
 
 public:
-	FExtractThreadWorker();
+	FExtractThreadWorker(EExtractStage InStage);
 	~FExtractThreadWorker();
 
 	virtual bool Init() override;
@@ -23,20 +185,52 @@ public:
 
 	void Shutdown();
 	void EnsureCompletion();
-	void StartExtract(const TArray<FPakFileSumary>& InSummaries, const FString& InOutputPath);
-	void InitTaskFiles(TArray<FPakFileEntry>& InFiles);
+	void StartExtract(const TArray<FPakFileSumary>& InSummaries, const FString& InOutputPath, TSharedPtr<FExtractPipeline, ESPMode::ThreadSafe> InPipeline, int32 InWorkerIndex);
 
 	FOnUpdateExtractProgress& GetOnUpdateExtractProgressDelegate();
+	const FGuid& GetGuid() const { return Guid; }
+	EExtractStage GetStage() const { return Stage; }
 
-	static bool BufferedCopyFile(FArchive& Dest, FArchive& Source, const FPakEntry& Entry, void* Buffer, int64 BufferSize, const FAES::FAESKey& InKey);
-	static bool UncompressCopyFile(FArchive& Dest, FArchive& Source, const FPakEntry& Entry, uint8*& PersistentBuffer, int64& BufferSize, const FAES::FAESKey& InKey, FName InCompressionMethod, bool bHasRelativeCompressedChunkOffsets);
+	/**
+	 * Reads the payload of an entry into memory, Source must be positioned right behind the entry header.
+	 * Compression blocks are read at once and decompressed in parallel into their output offsets.
+	 */
+	static bool ReadEntryToMemory(FArchive& Source, const FPakEntry& Entry, int32 InPakVersion, const FAES::FAESKey& InKey, FName InCompressionMethod, TArray<uint8>& OutData);
+
+	/**
+	 * Extends InOutData, a decoded prefix of an entry, until it holds at least InSize bytes or the whole entry.
+	 * Only the compression blocks covering the missing range are read and decoded. InDataOffset is the pak offset right behind the entry header.
+	 * InOutCompressedData holds the compressed blocks and can be reused between calls.
+	 */
+	static bool ReadEntryPrefix(FArchive& Source, const FPakEntry& Entry, int64 InDataOffset, int32 InPakVersion, const FAES::FAESKey& InKey, FName InCompressionMethod, int64 InSize, TArray<uint8>& InOutData, TArray<uint8>& InOutCompressedData);
+
+	/** Decrypts a compression block in place and decompresses it to OutData. */
+	static bool DecodeBlock(const FPakEntry& Entry, int32 InBlockIndex, uint8* InBlockData, uint8* OutData, const FAES::FAESKey& InKey, FName InCompressionMethod);
+
+protected:
+	bool IsStopping() const;
+
+	void RunRead(FExtractWorkerStats& InOutStats);
+	void RunDecode(FExtractWorkerStats& InOutStats);
+	void RunWrite(FExtractWorkerStats& InOutStats);
+	void RunWriteArchive(FExtractWorkerStats& InOutStats);
+
+	bool ReadFile(int32 InFileIndex, const FExtractTask& InTask, FArchive& InReader, FExtractWorkerStats& InOutStats);
+	bool PushFailedChunk(int32 InFileIndex, int64 InOutputOffset, int64 InOutputSize);
+	bool PushReadChunk(FExtractChunkPtr& InChunk);
+	bool DecodeChunk(FExtractChunk& InChunk);
+	void WriteDuplicates(int32 InFileIndex, bool bInSuccess, FExtractWorkerStats& InOutStats);
+	static bool LinkOrCopyFile(const FString& InSourcePath, const FString& InLinkPath);
 
 protected:
 	class FRunnableThread* Thread;
 	FGuid Guid;
 	FThreadSafeCounter StopTaskCounter;
+	EExtractStage Stage;
 
-	TArray<FPakFileEntry> Files;
+	TSharedPtr<FExtractPipeline, ESPMode::ThreadSafe> Pipeline;
+	int32 WorkerIndex;
+	int64 NextSequence;
 	TArray<FPakFileSumary> Summaries;
 	FString OutputPath;
 
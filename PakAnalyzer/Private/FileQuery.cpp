@@ -0,0 +1,257 @@
+#include "FileQuery.h"
+
+FFileQuery FFileQuery::Parse(const FString& InText)
+{
+	FFileQuery Query;
+
+	TArray<FString> Tokens;
+	Tokenize(InText, Tokens);
+
+	for (const FString& Token : Tokens)
+	{
+		FPredicate Predicate;
+		if (ParsePredicate(Token, Predicate))
+		{
+			Query.Predicates.Add(MoveTemp(Predicate));
+		}
+		else
+		{
+			Query.Terms.Add(Token);
+		}
+	}
+
+	return Query;
+}
+
+bool FFileQuery::MatchesPath(const TCHAR* InPath) const
+{
+	for (const FString& Term : Terms)
+	{
+		if (FCString::Stristr(InPath, *Term) == nullptr)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FFileQuery::IsNarrowerThan(const FFileQuery& InOther) const
+{
+	for (const FPredicate& Predicate : InOther.Predicates)
+	{
+		if (!Predicates.Contains(Predicate))
+		{
+			return false;
+		}
+	}
+
+	for (const FString& OtherTerm : InOther.Terms)
+	{
+		const bool bCovered = Terms.ContainsByPredicate([&OtherTerm](const FString& Term) { return Term.Contains(OtherTerm); });
+		if (!bCovered)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool FFileQuery::CompareNumber(double InValue, ECompare InCompare, double InOperand)
+{
+	switch (InCompare)
+	{
+	case ECompare::Less: return InValue < InOperand;
+	case ECompare::LessEqual: return InValue <= InOperand;
+	case ECompare::Greater: return InValue > InOperand;
+	case ECompare::GreaterEqual: return InValue >= InOperand;
+	default: return InValue == InOperand;
+	}
+}
+
+void FFileQuery::Tokenize(const FString& InText, TArray<FString>& OutTokens)
+{
+	FString Token;
+	bool bInQuotes = false;
+
+	for (const TCHAR Char : InText)
+	{
+		if (Char == TEXT('"'))
+		{
+			bInQuotes = !bInQuotes;
+		}
+		else if (!bInQuotes && FChar::IsWhitespace(Char))
+		{
+			if (!Token.IsEmpty())
+			{
+				OutTokens.Add(MoveTemp(Token));
+				Token.Reset();
+			}
+		}
+		else
+		{
+			Token.AppendChar(Char);
+		}
+	}
+
+	if (!Token.IsEmpty())
+	{
+		OutTokens.Add(MoveTemp(Token));
+	}
+}
+
+bool FFileQuery::ParsePredicate(const FString& InToken, FPredicate& OutPredicate)
+{
+	int32 KeyEnd = 0;
+	while (KeyEnd < InToken.Len() && FChar::IsAlpha(InToken[KeyEnd]))
+	{
+		++KeyEnd;
+	}
+
+	if (KeyEnd <= 0 || KeyEnd >= InToken.Len())
+	{
+		return false;
+	}
+
+	const FString Key = InToken.Left(KeyEnd);
+	if (Key.Equals(TEXT("size"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::Size;
+	}
+	else if (Key.Equals(TEXT("csize"), ESearchCase::IgnoreCase) || Key.Equals(TEXT("compressed"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::CompressedSize;
+	}
+	else if (Key.Equals(TEXT("blocks"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::BlockCount;
+	}
+	else if (Key.Equals(TEXT("ratio"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::Ratio;
+	}
+	else if (Key.Equals(TEXT("class"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::Class;
+	}
+	else if (Key.Equals(TEXT("pak"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::Pak;
+	}
+	else if (Key.Equals(TEXT("compression"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::Compression;
+	}
+	else if (Key.Equals(TEXT("encrypted"), ESearchCase::IgnoreCase))
+	{
+		OutPredicate.Field = EField::Encrypted;
+	}
+	else
+	{
+		return false;
+	}
+
+	int32 ValueStart = KeyEnd + 1;
+	const TCHAR Op = InToken[KeyEnd];
+	const bool bOrEqual = ValueStart < InToken.Len() && InToken[ValueStart] == TEXT('=');
+	if (Op == TEXT(':') || Op == TEXT('='))
+	{
+		OutPredicate.Compare = ECompare::Equal;
+	}
+	else if (Op == TEXT('<'))
+	{
+		OutPredicate.Compare = bOrEqual ? ECompare::LessEqual : ECompare::Less;
+	}
+	else if (Op == TEXT('>'))
+	{
+		OutPredicate.Compare = bOrEqual ? ECompare::GreaterEqual : ECompare::Greater;
+	}
+	else
+	{
+		return false;
+	}
+
+	if (bOrEqual && Op != TEXT('='))
+	{
+		++ValueStart;
+	}
+
+	const FString Value = InToken.Mid(ValueStart);
+	if (Value.IsEmpty())
+	{
+		return false;
+	}
+
+	if (OutPredicate.IsNumeric())
+	{
+		const bool bAllowUnit = OutPredicate.Field == EField::Size || OutPredicate.Field == EField::CompressedSize;
+		return ParseNumber(Value, bAllowUnit, OutPredicate.Number);
+	}
+
+	if (OutPredicate.Compare != ECompare::Equal)
+	{
+		return false;
+	}
+
+	if (OutPredicate.Field == EField::Encrypted)
+	{
+		if (Value.Equals(TEXT("true"), ESearchCase::IgnoreCase) || Value.Equals(TEXT("yes"), ESearchCase::IgnoreCase) || Value == TEXT("1"))
+		{
+			OutPredicate.Number = 1.0;
+			return true;
+		}
+
+		if (Value.Equals(TEXT("false"), ESearchCase::IgnoreCase) || Value.Equals(TEXT("no"), ESearchCase::IgnoreCase) || Value == TEXT("0"))
+		{
+			OutPredicate.Number = 0.0;
+			return true;
+		}
+
+		return false;
+	}
+
+	Value.ParseIntoArray(OutPredicate.Values, TEXT(","));
+	return OutPredicate.Values.Num() > 0;
+}
+
+bool FFileQuery::ParseNumber(const FString& InText, bool bInAllowUnit, double& OutNumber)
+{
+	int32 NumberEnd = 0;
+	while (NumberEnd < InText.Len() && (FChar::IsDigit(InText[NumberEnd]) || InText[NumberEnd] == TEXT('.')))
+	{
+		++NumberEnd;
+	}
+
+	const FString Number = InText.Left(NumberEnd);
+	if (Number.IsEmpty() || !Number.IsNumeric())
+	{
+		return false;
+	}
+
+	OutNumber = FCString::Atod(*Number);
+
+	const FString Unit = InText.Mid(NumberEnd);
+	if (Unit.IsEmpty())
+	{
+		return true;
+	}
+
+	if (!bInAllowUnit)
+	{
+		return false;
+	}
+
+	static const TCHAR* Units[] = { TEXT("B"), TEXT("KB"), TEXT("MB"), TEXT("GB") };
+	static const TCHAR* ShortUnits[] = { TEXT(""), TEXT("K"), TEXT("M"), TEXT("G") };
+	for (int32 i = 0; i < UE_ARRAY_COUNT(Units); ++i)
+	{
+		if (Unit.Equals(Units[i], ESearchCase::IgnoreCase) || (i > 0 && Unit.Equals(ShortUnits[i], ESearchCase::IgnoreCase)))
+		{
+			OutNumber *= FMath::Pow(1024.0, (double)i);
+			return true;
+		}
+	}
+
+	return false;
+}
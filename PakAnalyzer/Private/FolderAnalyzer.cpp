@@ -69,26 +69,32 @@ bool FFolderAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArr
 	PlatformFile.FindFilesRecursively(FoundFiles, *InPakPath, TEXT(""));
 
 	int64 TotalSize = 0;
+	TArray<FString> RelativeFilenames;
+	TArray<FPakEntry> Entries;
+	RelativeFilenames.Reserve(FoundFiles.Num());
+	Entries.Reserve(FoundFiles.Num());
+
 	for (const FString& File : FoundFiles)
 	{
-		FPakEntry Entry;
+		FPakEntry& Entry = Entries.AddDefaulted_GetRef();
 		Entry.Offset = 0;
 		Entry.UncompressedSize = PlatformFile.FileSize(*File);
 		Entry.Size = Entry.UncompressedSize;
 
 		TotalSize += Entry.UncompressedSize;
 
-		FString RelativeFilename = File;
+		FString& RelativeFilename = RelativeFilenames.Add_GetRef(File);
 		RelativeFilename.RemoveFromStart(InPakPath);
 
-		InsertFileToTree(TreeRoot, *Summary, RelativeFilename, Entry);
-
 		if (File.Contains(TEXT("DevelopmentAssetRegistry.bin")))
 		{
 			AssetRegistryPath = File;
 		}
 	}
 
+	TArray<FPakTreeEntryPtr> Files;
+	BuildTree(TreeRoot, *Summary, RelativeFilenames, [&Entries](int32 Index) -> const FPakEntry& { return Entries[Index]; }, Files);
+
 	Summary->PakFileSize = TotalSize;
 	Summary->FileCount = TreeRoot->FileCount;
 
@@ -96,12 +102,15 @@ bool FFolderAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArr
 	RefreshTreeNodeSizePercent(TreeRoot, TreeRoot);
 
 	PakTreeRoots.Add(TreeRoot);
+	LogTreeMemoryUsage();
 
 	if (!AssetRegistryPath.IsEmpty())
 	{
 		LoadAssetRegistry(AssetRegistryPath);
 	}
 
+	RefreshFileIndex();
+
 	ParseAssetFile(TreeRoot);
 
 	UE_LOG(LogPakAnalyzer, Log, TEXT("Finish load pak file: %s."), *InPakPath);
@@ -123,6 +132,14 @@ void FFolderAnalyzer::SetExtractThreadCount(int32 InThreadCount)
 {
 }
 
+void FFolderAnalyzer::PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles)
+{
+	if (AssetParseWorker.IsValid())
+	{
+		AssetParseWorker->PrioritizeFiles(InFiles);
+	}
+}
+
 void FFolderAnalyzer::ParseAssetFile(FPakTreeEntryPtr InRoot)
 {
 	if (AssetParseWorker.IsValid())
@@ -144,6 +161,7 @@ void FFolderAnalyzer::InitializeAssetParseWorker()
 		AssetParseWorker = MakeShared<FAssetParseThreadWorker>();
 		AssetParseWorker->OnReadAssetContent.BindRaw(this, &FFolderAnalyzer::OnReadAssetContent);
 		AssetParseWorker->OnParseFinish.BindRaw(this, &FFolderAnalyzer::OnAssetParseFinish);
+		AssetParseWorker->OnAssetParsed.BindRaw(this, &FFolderAnalyzer::OnAssetParsed);
 	}
 }
 
@@ -158,15 +176,33 @@ void FFolderAnalyzer::ShutdownAssetParseWorker()
 void FFolderAnalyzer::OnReadAssetContent(FPakFileEntryPtr InFile, bool& bOutSuccess, TArray<uint8>& OutContent)
 {
 	bOutSuccess = false;
-	OutContent.Empty();
+	OutContent.Reset();
 
 	if (!InFile.IsValid())
 	{
 		return;
 	}
 
-	const FString FilePath = PakFileSummaries[0]->MountPoint / InFile->Path;
-	bOutSuccess = FFileHelper::LoadFileToArray(OutContent, *FilePath);
+	const FString FilePath = PakFileSummaries[0]->MountPoint / *InFile->Path;
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!Reader)
+	{
+		return;
+	}
+
+	const int64 FileSize = Reader->TotalSize();
+	bOutSuccess = FAssetParseThreadWorker::ReadAssetHeader([&Reader, FileSize](int64 InSize, TArray<uint8>& InOutData)
+		{
+			const int64 CurrentSize = InOutData.Num();
+			const int64 TargetSize = FMath::Min(InSize, FileSize);
+			if (TargetSize > CurrentSize)
+			{
+				InOutData.SetNumUninitialized(TargetSize, EAllowShrinking::No);
+				Reader->Seek(CurrentSize);
+				Reader->Serialize(InOutData.GetData() + CurrentSize, TargetSize - CurrentSize);
+			}
+			return !Reader->IsError();
+		}, OutContent);
 }
 
 void FFolderAnalyzer::OnAssetParseFinish(bool bCancel, const TMap<FName, FName>& ClassMap)
@@ -187,9 +223,20 @@ void FFolderAnalyzer::OnAssetParseFinish(bool bCancel, const TMap<FName, FName>&
 				{
 					RefreshClassMap(PakTreeRoot, PakTreeRoot);
 				}
+
+				RefreshFileIndex();
 			}
 
 			FPakAnalyzerDelegates::OnAssetParseFinish.Broadcast();
 		},
 		TStatId(), nullptr, ENamedThreads::GameThread);
 }
+
+void FFolderAnalyzer::OnAssetParsed(FPakFileEntryPtr InFile)
+{
+	FFunctionGraphTask::CreateAndDispatchWhenReady([InFile]()
+		{
+			FPakAnalyzerDelegates::OnAssetParsed.Broadcast(InFile);
+		},
+		TStatId(), nullptr, ENamedThreads::GameThread);
+}
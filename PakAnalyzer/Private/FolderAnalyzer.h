@@ -25,6 +25,7 @@ public:
 	virtual void ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles) override;
 	virtual void CancelExtract() override;
 	virtual void SetExtractThreadCount(int32 InThreadCount) override;
+	virtual void PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles) override;
 
 protected:
 	void ParseAssetFile(FPakTreeEntryPtr InRoot);
@@ -32,6 +33,7 @@ protected:
 	void ShutdownAssetParseWorker();
 	void OnReadAssetContent(FPakFileEntryPtr InFile, bool& bOutSuccess, TArray<uint8>& OutContent);
 	void OnAssetParseFinish(bool bCancel, const TMap<FName, FName>& ClassMap);
+	void OnAssetParsed(FPakFileEntryPtr InFile);
 
 protected:
 	TSharedPtr<class FAssetParseThreadWorker> AssetParseWorker;
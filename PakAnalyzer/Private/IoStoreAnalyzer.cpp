@@ -9,26 +9,84 @@
 #include "HAL/CriticalSection.h"
 #include "HAL/FileManager.h"
 #include "HAL/PlatformFile.h"
+#include "HAL/PlatformTime.h"
 #include "HAL/UnrealMemory.h"
 #include "Misc/Base64.h"
 #include "Misc/Compression.h"
+#include "Misc/Optional.h"
 #include "Misc/Paths.h"
 #include "Misc/ScopeLock.h"
 #include "Serialization/AsyncLoading2.h"
 #include "Serialization/LargeMemoryReader.h"
 #include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
 #include "UObject/NameBatchSerialization.h"
 #include "UObject/ObjectVersion.h"
 #include "IO/PackageStore.h"
 #include "CommonDefines.h"
+#include "TarWriter.h"
+
+// Bump when the layout written by SerializePackageRecord changes
+static const int32 IO_STORE_PACKAGE_RECORD_VERSION = 1;
+
+/** Record of the asset summary cache, the header pass output of one package. */
+static void SerializePackageRecord(FArchive& Ar, FStorePackageInfo& InOutPackageInfo, uint32& InOutPackageFlags, TArray<FName>& InOutNames, bool& bInOutHasExports)
+{
+	Ar << InOutPackageInfo.PackageName;
+	Ar << InOutPackageInfo.CookedHeaderSize;
+	Ar << InOutPackageFlags;
+	Ar << InOutNames;
+	Ar << InOutPackageInfo.ImportedPublicExportHashes;
+
+	int32 ImportCount = InOutPackageInfo.Imports.Num();
+	Ar << ImportCount;
+	if (Ar.IsLoading())
+	{
+		InOutPackageInfo.Imports.SetNum(FMath::Max(ImportCount, 0));
+	}
+	for (FIoStoreImport& Import : InOutPackageInfo.Imports)
+	{
+		Ar << Import.GlobalImportIndex;
+	}
+
+	Ar << bInOutHasExports;
+
+	int32 ExportCount = InOutPackageInfo.Exports.Num();
+	Ar << ExportCount;
+	if (Ar.IsLoading())
+	{
+		InOutPackageInfo.Exports.SetNum(FMath::Max(ExportCount, 0));
+	}
+	for (FIoStoreExport& Export : InOutPackageInfo.Exports)
+	{
+		uint32 ObjectFlags = (uint32)Export.ObjectFlags;
+		uint8 FilterFlags = (uint8)Export.FilterFlags;
+
+		Ar << Export.Name;
+		Ar << Export.PublicExportHash;
+		Ar << Export.OuterIndex;
+		Ar << Export.ClassIndex;
+		Ar << Export.SuperIndex;
+		Ar << Export.TemplateIndex;
+		Ar << Export.SerialSize;
+		Ar << Export.SerialOffset;
+		Ar << ObjectFlags;
+		Ar << FilterFlags;
+
+		Export.ObjectFlags = (EObjectFlags)ObjectFlags;
+		Export.FilterFlags = (EExportFilterFlags)FilterFlags;
+	}
+}
 
 FIoStoreAnalyzer::FIoStoreAnalyzer()
+	: SummaryCache(TEXT("IoStore"), IO_STORE_PACKAGE_RECORD_VERSION)
 {
 
 }
 
 FIoStoreAnalyzer::~FIoStoreAnalyzer()
 {
+	CancelVerify();
 	StopExtract();
 	Reset();
 }
@@ -87,28 +145,65 @@ bool FIoStoreAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TAr
 	{
 		FScopeLock Lock(&CriticalSection);
 
+		// Group packages by container, each container tree is built in one pass
+		TArray<TArray<int32>> ContainerPackages;
+		ContainerPackages.AddDefaulted(StoreContainers.Num());
+
 		for (int32 i = 0; i < PackageInfos.Num(); ++i)
 		{
 			const FStorePackageInfo& Package = PackageInfos[i];
-			if (!Package.PackageId.IsValid())
+			if (!Package.PackageId.IsValid() || !ContainerPackages.IsValidIndex(Package.ContainerIndex))
 			{
 				continue;
 			}
 
-			FPakEntry Entry;
-			Entry.Offset = Package.ChunkInfo.Offset;
-			Entry.UncompressedSize = Package.ChunkInfo.Size;
-			Entry.Size = Package.SerializeSize;
-			Entry.CompressionBlockSize = Package.CompressionBlockSize;
-			Entry.CompressionBlocks.AddZeroed(Package.CompressionBlockCount);
-			HexToBytes(Package.ChunkHash, Entry.Hash);
-			Entry.SetEncrypted(StoreContainers[Package.ContainerIndex].bEncrypted);
-
-			const FString FullPath = Package.PackageName.ToString() + TEXT(".") + Package.Extension.ToString();
-			FPakTreeEntryPtr ResultEntry = InsertFileToTree(PakTreeRoots[Package.ContainerIndex], StoreContainers[Package.ContainerIndex].Summary, FullPath, Entry);
-			if (ResultEntry.IsValid())
+			ContainerPackages[Package.ContainerIndex].Add(i);
+
+			if (!Package.DefaultClassName.IsNone())
+			{
+				DefaultClassMap.Add(Package.PackageName, Package.DefaultClassName);
+			}
+		}
+
+		for (int32 ContainerIndex = 0; ContainerIndex < ContainerPackages.Num(); ++ContainerIndex)
+		{
+			const TArray<int32>& Packages = ContainerPackages[ContainerIndex];
+
+			TArray<FString> FullPaths;
+			TArray<FPakEntry> Entries;
+			FullPaths.Reserve(Packages.Num());
+			Entries.Reserve(Packages.Num());
+
+			for (const int32 PackageIndex : Packages)
 			{
-				ResultEntry->OwnerPakIndex = Package.ContainerIndex + ContainerStartIndex;
+				const FStorePackageInfo& Package = PackageInfos[PackageIndex];
+
+				FPakEntry& Entry = Entries.AddDefaulted_GetRef();
+				Entry.Offset = Package.ChunkInfo.Offset;
+				Entry.UncompressedSize = Package.ChunkInfo.Size;
+				Entry.Size = Package.SerializeSize;
+				Entry.CompressionBlockSize = Package.CompressionBlockSize;
+				Entry.CompressionBlocks.AddZeroed(Package.CompressionBlockCount);
+				HexToBytes(Package.ChunkHash, Entry.Hash);
+				Entry.SetEncrypted(StoreContainers[ContainerIndex].bEncrypted);
+
+				FullPaths.Add(Package.PackageName.ToString() + TEXT(".") + Package.Extension.ToString());
+			}
+
+			TArray<FPakTreeEntryPtr> Files;
+			BuildTree(PakTreeRoots[ContainerIndex], StoreContainers[ContainerIndex].Summary, FullPaths, [&Entries](int32 Index) -> const FPakEntry& { return Entries[Index]; }, Files);
+
+			for (int32 i = 0; i < Packages.Num(); ++i)
+			{
+				const FPakTreeEntryPtr& ResultEntry = Files[i];
+				if (!ResultEntry.IsValid())
+				{
+					continue;
+				}
+
+				const FStorePackageInfo& Package = PackageInfos[Packages[i]];
+
+				ResultEntry->OwnerPakIndex = ContainerIndex + ContainerStartIndex;
 				ResultEntry->CompressionMethod = Package.CompressionMethod;
 
 				if (Package.AssetSummary.IsValid())
@@ -116,13 +211,9 @@ bool FIoStoreAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TAr
 					ResultEntry->AssetSummary = Package.AssetSummary;
 				}
 
-				PakFileSummaries[Package.ContainerIndex]->FileCount += 1;
-			}
+				PakFileSummaries[ContainerIndex]->FileCount += 1;
 
-			FileToPackageIndex.Add(FullPath, i);
-			if (!Package.DefaultClassName.IsNone())
-			{
-				DefaultClassMap.Add(Package.PackageName, Package.DefaultClassName);
+				FileToPackageIndex.Add(ResultEntry.Get(), Packages[i]);
 			}
 		}
 	}
@@ -134,7 +225,10 @@ bool FIoStoreAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TAr
 		RefreshClassMap(TreeRoot, TreeRoot);
 	}
 
+	RefreshFileIndex();
+
 	UE_LOG(LogPakAnalyzer, Log, TEXT("Finish load iostore file count: %d."), UcasFiles.Num());
+	LogTreeMemoryUsage();
 
 	//FPakAnalyzerDelegates::OnPakLoadFinish.Broadcast();
 
@@ -143,27 +237,45 @@ bool FIoStoreAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TAr
 
 void FIoStoreAnalyzer::ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles)
 {
-	StopExtract();
+	StartExtract(InOutputPath, InFiles, false);
+}
 
-	FPakAnalyzerDelegates::OnExtractStart.ExecuteIfBound();
+bool FIoStoreAnalyzer::ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles)
+{
+	StartExtract(InArchivePath, InFiles, true);
+	return true;
+}
+
+void FIoStoreAnalyzer::StartExtract(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles, bool bInArchive)
+{
+	StopExtract();
 
-	TArray<int32> Packages;
 	for (FPakFileEntryPtr File : InFiles)
 	{
-		const int32* Index = FileToPackageIndex.Find(TEXT("/") / File->Path);
+		const int32* Index = FileToPackageIndex.Find(File.Get());
 		if (Index)
 		{
 			PendingExtracePackages.AddUnique(*Index);
 		}
 	}
 
+	// Pak files of a mixed selection are extracted by the pak analyzer
 	if (PendingExtracePackages.Num() <= 0)
 	{
 		return;
 	}
 
+	FPakAnalyzerDelegates::OnExtractStart.ExecuteIfBound();
+
 	ExtractOutputPath = InOutputPath;
-	ExtractThread.Add(Async(EAsyncExecution::Thread, [this]() { OnExtractFiles(); }));
+	if (bInArchive)
+	{
+		ExtractThread.Add(Async(EAsyncExecution::Thread, [this]() { OnExtractFilesToArchive(); }));
+	}
+	else
+	{
+		ExtractThread.Add(Async(EAsyncExecution::Thread, [this]() { OnExtractFiles(); }));
+	}
 }
 
 void FIoStoreAnalyzer::CancelExtract()
@@ -171,6 +283,43 @@ void FIoStoreAnalyzer::CancelExtract()
 	StopExtract();
 }
 
+void FIoStoreAnalyzer::VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles)
+{
+	CancelVerify();
+
+	TArray<int32> Packages;
+	for (const FPakFileEntryPtr& File : InFiles)
+	{
+		const int32* Index = FileToPackageIndex.Find(File.Get());
+		if (Index)
+		{
+			Packages.AddUnique(*Index);
+		}
+	}
+
+	if (Packages.Num() <= 0)
+	{
+		FinishEmptyVerify();
+		return;
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Start verify %d packages."), Packages.Num());
+
+	VerifyTask = Async(EAsyncExecution::Thread, [this, Packages = MoveTemp(Packages)]() { OnVerifyPackages(Packages); });
+}
+
+void FIoStoreAnalyzer::CancelVerify()
+{
+	if (VerifyTask.IsValid())
+	{
+		IsStopVerify.AtomicSet(true);
+		VerifyTask.Wait();
+		VerifyTask.Reset();
+	}
+
+	IsStopVerify.AtomicSet(false);
+}
+
 void FIoStoreAnalyzer::SetExtractThreadCount(int32 InThreadCount)
 {
 
@@ -178,6 +327,7 @@ void FIoStoreAnalyzer::SetExtractThreadCount(int32 InThreadCount)
 
 void FIoStoreAnalyzer::Reset()
 {
+	CancelVerify();
 	FBaseAnalyzer::Reset();
 
 	GlobalIoStoreReader.Reset();
@@ -515,7 +665,11 @@ bool FIoStoreAnalyzer::InitializeReaders(const TArray<FString>& InPaks, const TA
 
 	UE_LOG(LogPakAnalyzer, Display, TEXT("IoStore loading package FNames..."));
 
-	ParallelFor(PackageInfos.Num(), [this](int32 Index)
+	SummaryCache.Load();
+
+	// Records of new packages are collected per task and appended once the pass is done
+	TArray<FAssetSummaryCache::FNewRecords> NewRecords;
+	ParallelForWithTaskContext(NewRecords, PackageInfos.Num(), [this](FAssetSummaryCache::FNewRecords& OutNewRecords, int32 Index)
 	{
 		FStorePackageInfo& PackageInfo = PackageInfos[Index];
 		if (!PackageInfo.PackageId.IsValid())
@@ -537,6 +691,13 @@ bool FIoStoreAnalyzer::InitializeReaders(const TArray<FString>& InPaks, const TA
 
 		if (PackageInfo.ChunkType == EIoChunkType::ExportBundleData)
 		{
+			// Unchanged packages are restored from the cache without reading the container
+			const FPackageStoreExportEntry* ExportEntry = ContainerInfo.StoreEntryMap.Find(PackageInfo.PackageId);
+			if (LoadPackageRecord(ExportEntry, PackageInfo))
+			{
+				return;
+			}
+
 			FIoReadOptions ReadOptions;
 			TIoStatusOr<FIoBuffer> IoBuffer = Reader->Read(PackageInfo.ChunkId, ReadOptions);
 
@@ -588,7 +749,6 @@ bool FIoStoreAnalyzer::InitializeReaders(const TArray<FString>& InPaks, const TA
 				Import.GlobalImportIndex = ImportMap[ImportIndex];
 			}
 			
-			const FPackageStoreExportEntry* ExportEntry = ContainerInfo.StoreEntryMap.Find(PackageInfo.PackageId);
 			if (ExportEntry)
 			{
 				PackageInfo.DependencyPackages = ExportEntry->DependencyPackages;
@@ -613,33 +773,15 @@ bool FIoStoreAnalyzer::InitializeReaders(const TArray<FString>& InPaks, const TA
 				}
 			}
 
-			PackageInfo.AssetSummary = MakeShared<FAssetSummary>();
-			FPackageFileSummary& AssetPackageSummary = PackageInfo.AssetSummary->PackageSummary;
-			FMemory::Memzero(&AssetPackageSummary, sizeof(AssetPackageSummary));
-
-			AssetPackageSummary.Tag = PACKAGE_FILE_TAG;
-			//AssetPackageSummary.PackageFlags = PackageSummary->PackageFlags;
-			AssetPackageSummary.SetPackageFlags(PackageSummary->PackageFlags);
-			AssetPackageSummary.TotalHeaderSize = PackageSummary->_Unused; // was CookedHeaderSize;
-
-			// FNames
-			PackageInfo.AssetSummary->Names.SetNum(PackageNameMap.Num());
-			AssetPackageSummary.NameCount = PackageNameMap.Num();
-			AssetPackageSummary.NameOffset = 0;
-			for (int32 i = 0; i < PackageNameMap.Num(); ++i)
+			TArray<FName> Names;
+			Names.Reserve(PackageNameMap.Num());
+			for (const FDisplayNameEntryId& Name : PackageNameMap)
 			{
-				PackageInfo.AssetSummary->Names[i] = MakeShared<FName>(PackageNameMap[i].ToName(0));
+				Names.Add(Name.ToName(0));
 			}
 
-			// Imports
-			AssetPackageSummary.ImportCount = PackageInfo.Imports.Num();
-			AssetPackageSummary.ImportOffset = 0;
-			PackageInfo.AssetSummary->ObjectImports.SetNum(AssetPackageSummary.ImportCount);
-
-			// Exports
-			AssetPackageSummary.ExportCount = PackageInfo.Exports.Num();
-			AssetPackageSummary.ExportOffset = 0;
-			PackageInfo.AssetSummary->ObjectExports.SetNum(AssetPackageSummary.ExportCount);
+			PackageInfo.AssetSummary = MakeAssetSummary(PackageInfo, PackageSummary->PackageFlags, Names);
+			SavePackageRecord(PackageInfo, PackageSummary->PackageFlags, Names, ExportEntry != nullptr, OutNewRecords);
 
 			//const FExportBundleHeader* ExportBundleHeaders = reinterpret_cast<const FExportBundleHeader*>(PackageSummaryData + PackageSummary->ExportBundlesOffset);
 			//const FExportBundleEntry* ExportBundleEntries = reinterpret_cast<const FExportBundleEntry*>(ExportBundleHeaders + Job.PackageDesc->ExportBundleCount);
@@ -674,6 +816,18 @@ bool FIoStoreAnalyzer::InitializeReaders(const TArray<FString>& InPaks, const TA
 		}
 	}, ParallelForFlags);
 
+	for (FAssetSummaryCache::FNewRecords& TaskNewRecords : NewRecords)
+	{
+		SummaryCache.Append(MoveTemp(TaskNewRecords));
+	}
+	NewRecords.Empty();
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("IoStore restored %d package headers from the summary cache, %d packages added."), SummaryCache.GetHitCount(), SummaryCache.GetAddCount());
+	if (SummaryCache.GetHitCount() > 0 || SummaryCache.GetAddCount() > 0)
+	{
+		SummaryCache.Save();
+	}
+
 	UE_LOG(LogPakAnalyzer, Display, TEXT("IoStore assigning package name..."));
 
 	TMap<FPackageId, FName> PackageNameMap;
@@ -1254,6 +1408,94 @@ bool FIoStoreAnalyzer::TryDecryptIoStore(const FIoStoreTocResourceInfo& TocResou
 	return true;
 }
 
+FAssetSummaryPtr FIoStoreAnalyzer::MakeAssetSummary(const FStorePackageInfo& InPackageInfo, uint32 InPackageFlags, const TArray<FName>& InNames)
+{
+	FAssetSummaryPtr AssetSummary = MakeShared<FAssetSummary>();
+	FPackageFileSummary& AssetPackageSummary = AssetSummary->PackageSummary;
+	FMemory::Memzero(&AssetPackageSummary, sizeof(AssetPackageSummary));
+
+	AssetPackageSummary.Tag = PACKAGE_FILE_TAG;
+	//AssetPackageSummary.PackageFlags = PackageSummary->PackageFlags;
+	AssetPackageSummary.SetPackageFlags(InPackageFlags);
+	AssetPackageSummary.TotalHeaderSize = InPackageInfo.CookedHeaderSize;
+
+	// FNames
+	AssetSummary->Names.SetNum(InNames.Num());
+	AssetPackageSummary.NameCount = InNames.Num();
+	AssetPackageSummary.NameOffset = 0;
+	for (int32 i = 0; i < InNames.Num(); ++i)
+	{
+		AssetSummary->Names[i] = MakeShared<FName>(InNames[i]);
+	}
+
+	// Imports
+	AssetPackageSummary.ImportCount = InPackageInfo.Imports.Num();
+	AssetPackageSummary.ImportOffset = 0;
+	AssetSummary->ObjectImports.SetNum(AssetPackageSummary.ImportCount);
+
+	// Exports
+	AssetPackageSummary.ExportCount = InPackageInfo.Exports.Num();
+	AssetPackageSummary.ExportOffset = 0;
+	AssetSummary->ObjectExports.SetNum(AssetPackageSummary.ExportCount);
+
+	return AssetSummary;
+}
+
+bool FIoStoreAnalyzer::LoadPackageRecord(const FPackageStoreExportEntry* InExportEntry, FStorePackageInfo& InOutPackageInfo)
+{
+	const TArray<uint8>* Record = InOutPackageInfo.ChunkHash.IsEmpty() ? nullptr : SummaryCache.Find(InOutPackageInfo.ChunkHash);
+	if (!Record)
+	{
+		return false;
+	}
+
+	uint32 PackageFlags = 0;
+	TArray<FName> Names;
+	bool bHasExports = false;
+
+	FMemoryReader Reader(*Record);
+	SerializePackageRecord(Reader, InOutPackageInfo, PackageFlags, Names, bHasExports);
+
+	// Exports are only read for packages in the store, a record written without them is parsed again
+	if (Reader.IsError() || (InExportEntry && !bHasExports))
+	{
+		InOutPackageInfo.Imports.Empty();
+		InOutPackageInfo.Exports.Empty();
+		return false;
+	}
+
+	if (InExportEntry)
+	{
+		InOutPackageInfo.DependencyPackages = InExportEntry->DependencyPackages;
+		for (FIoStoreExport& Export : InOutPackageInfo.Exports)
+		{
+			Export.Package = &InOutPackageInfo;
+		}
+	}
+	else
+	{
+		InOutPackageInfo.Exports.Empty();
+	}
+
+	InOutPackageInfo.AssetSummary = MakeAssetSummary(InOutPackageInfo, PackageFlags, Names);
+
+	return true;
+}
+
+void FIoStoreAnalyzer::SavePackageRecord(const FStorePackageInfo& InPackageInfo, uint32 InPackageFlags, const TArray<FName>& InNames, bool bInHasExports, FAssetSummaryCache::FNewRecords& OutNewRecords)
+{
+	if (InPackageInfo.ChunkHash.IsEmpty())
+	{
+		return;
+	}
+
+	TArray<uint8> Record;
+	FMemoryWriter Writer(Record);
+	SerializePackageRecord(Writer, const_cast<FStorePackageInfo&>(InPackageInfo), InPackageFlags, const_cast<TArray<FName>&>(InNames), bInHasExports);
+
+	OutNewRecords.Emplace(InPackageInfo.ChunkHash, MoveTemp(Record));
+}
+
 bool FIoStoreAnalyzer::FillPackageInfo(const FIoStoreTocResourceInfo& TocResource, FStorePackageInfo& OutPackageInfo)
 {
 	OutPackageInfo.SerializeSize = 0;
@@ -1323,7 +1565,23 @@ void FIoStoreAnalyzer::OnExtractFiles()
 	TAtomic<int32> TotalCompleteCount{ 0 };
 	const int32 TotalTotalCount = PendingExtracePackages.Num();
 
-	ParallelFor(PendingExtracePackages.Num(), [this, TotalTotalCount, &TotalErrorCount, &TotalCompleteCount](int32 Index)
+	auto GetOutputFilePath = [this](const FStorePackageInfo& PackageInfo)
+	{
+		return ExtractOutputPath / PackageInfo.PackageName.ToString() + TEXT(".") + PackageInfo.Extension.ToString();
+	};
+
+	TArray<FString> OutputFilePaths;
+	OutputFilePaths.Reserve(TotalTotalCount);
+	for (int32 PackageIndex : PendingExtracePackages)
+	{
+		if (PackageInfos.IsValidIndex(PackageIndex))
+		{
+			OutputFilePaths.Add(GetOutputFilePath(PackageInfos[PackageIndex]));
+		}
+	}
+	MakeOutputDirectories(OutputFilePaths);
+
+	ParallelFor(PendingExtracePackages.Num(), [this, TotalTotalCount, &TotalErrorCount, &TotalCompleteCount, &GetOutputFilePath](int32 Index)
 	{
 		if (IsStopExtract)
 		{
@@ -1359,12 +1617,7 @@ void FIoStoreAnalyzer::OnExtractFiles()
 			return;
 		}
 
-		const FString OutputFilePath = ExtractOutputPath / PackageInfo.PackageName.ToString() + TEXT(".") + PackageInfo.Extension.ToString();
-		const FString BasePath = FPaths::GetPath(OutputFilePath);
-		if (!FPaths::DirectoryExists(BasePath))
-		{
-			IFileManager::Get().MakeDirectory(*BasePath, true);
-		}
+		const FString OutputFilePath = GetOutputFilePath(PackageInfo);
 
 		IPlatformFile& PlatformFile = IPlatformFile::GetPlatformPhysical();
 		TUniquePtr<IFileHandle>	FileHandle(PlatformFile.OpenWrite(*OutputFilePath));
@@ -1418,6 +1671,164 @@ void FIoStoreAnalyzer::OnExtractFiles()
 	}, EParallelForFlags::Unbalanced);
 }
 
+void FIoStoreAnalyzer::OnExtractFilesToArchive()
+{
+	// Packages are read in parallel batches and streamed into the archive in selection order
+	static const int32 BatchSize = 64;
+
+	const int32 TotalCount = PendingExtracePackages.Num();
+	int32 CompleteCount = 0;
+	int32 ErrorCount = 0;
+
+	FTarWriter Archive;
+	if (!Archive.Open(ExtractOutputPath))
+	{
+		UpdateExtractProgress(TotalCount, TotalCount, TotalCount);
+		return;
+	}
+
+	TArray<TOptional<FIoBuffer>> Buffers;
+	for (int32 BatchStart = 0; BatchStart < TotalCount && !IsStopExtract; BatchStart += BatchSize)
+	{
+		const int32 BatchCount = FMath::Min(BatchSize, TotalCount - BatchStart);
+
+		Buffers.Reset();
+		Buffers.SetNum(BatchCount);
+		ParallelFor(BatchCount, [this, BatchStart, &Buffers](int32 Index)
+		{
+			const int32 PackageIndex = PendingExtracePackages[BatchStart + Index];
+			if (IsStopExtract || !PackageInfos.IsValidIndex(PackageIndex))
+			{
+				return;
+			}
+
+			const FStorePackageInfo& PackageInfo = PackageInfos[PackageIndex];
+			TSharedPtr<FIoStoreReader>& Reader = StoreContainers[PackageInfo.ContainerIndex].Reader;
+			if (Reader.IsValid())
+			{
+				TIoStatusOr<FIoBuffer> IoBuffer = Reader->Read(PackageInfo.ChunkId, FIoReadOptions());
+				if (IoBuffer.IsOk())
+				{
+					Buffers[Index] = IoBuffer.ConsumeValueOrDie();
+				}
+			}
+		}, EParallelForFlags::Unbalanced);
+
+		for (int32 Index = 0; Index < BatchCount && !IsStopExtract; ++Index)
+		{
+			++CompleteCount;
+
+			// The header holds the size, a package which failed to read is left out of the archive
+			if (!Buffers[Index].IsSet())
+			{
+				++ErrorCount;
+				continue;
+			}
+
+			const FStorePackageInfo& PackageInfo = PackageInfos[PendingExtracePackages[BatchStart + Index]];
+			const FIoBuffer& Buffer = Buffers[Index].GetValue();
+
+			Archive.BeginFile(PackageInfo.PackageName.ToString() + TEXT(".") + PackageInfo.Extension.ToString(), Buffer.DataSize());
+			Archive.Write(Buffer.Data(), Buffer.DataSize());
+			Archive.EndFile();
+
+			if (Archive.IsError())
+			{
+				++ErrorCount;
+			}
+		}
+
+		UpdateExtractProgress(TotalCount, CompleteCount, ErrorCount);
+	}
+
+	// An interrupted archive is left without the end marker
+	if (!Archive.Close(!IsStopExtract))
+	{
+		UE_LOG(LogPakAnalyzer, Error, TEXT("Write archive failed! Archive: %s"), *ExtractOutputPath);
+	}
+}
+
+void FIoStoreAnalyzer::OnVerifyPackages(const TArray<int32>& InPackages)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	FVerifyResult Result;
+	Result.TotalCount = InPackages.Num();
+
+	FCriticalSection FailureCriticalSection;
+	TAtomic<int32> VerifiedCount{ 0 };
+	TAtomic<int64> VerifiedBytes{ 0 };
+
+	// Signed containers have their block signatures checked by the reader, the chunk hash is checked here
+	ParallelFor(InPackages.Num(), [this, &InPackages, &Result, &FailureCriticalSection, &VerifiedCount, &VerifiedBytes](int32 Index)
+	{
+		if (IsStopVerify || !PackageInfos.IsValidIndex(InPackages[Index]))
+		{
+			return;
+		}
+
+		const FStorePackageInfo& PackageInfo = PackageInfos[InPackages[Index]];
+		const FContainerInfo& Container = StoreContainers[PackageInfo.ContainerIndex];
+
+		FVerifyFailure Failure;
+		Failure.Path = PackageInfo.PackageName.ToString() + TEXT(".") + PackageInfo.Extension.ToString();
+		Failure.PakName = FPaths::GetCleanFilename(Container.Summary.PakFilePath);
+		Failure.Offset = PackageInfo.ChunkInfo.Offset;
+
+		if (PackageInfo.CompressionBlockSize > 0)
+		{
+			Failure.BlockIndex = int32(PackageInfo.ChunkInfo.Offset / PackageInfo.CompressionBlockSize);
+			const FIoStoreTocResourceInfo* TocResource = TocResources.Find(Container.Id.Value());
+			if (TocResource && TocResource->CompressionBlocks.IsValidIndex(Failure.BlockIndex))
+			{
+				Failure.BlockOffset = TocResource->CompressionBlocks[Failure.BlockIndex].GetOffset();
+			}
+		}
+
+		if (!Container.Reader.IsValid())
+		{
+			Failure.Reason = TEXT("Open container failed");
+		}
+		else
+		{
+			FIoReadOptions ReadOptions;
+			TIoStatusOr<FIoBuffer> IoBuffer = Container.Reader->Read(PackageInfo.ChunkId, ReadOptions);
+			if (!IoBuffer.IsOk())
+			{
+				Failure.Reason = FString::Printf(TEXT("Read failed, %s"), *IoBuffer.Status().ToString());
+			}
+			else if (!PackageInfo.ChunkHash.IsEmpty() && LexToString(FIoHash::HashBuffer(IoBuffer.ValueOrDie().Data(), IoBuffer.ValueOrDie().DataSize())) != PackageInfo.ChunkHash)
+			{
+				Failure.Reason = TEXT("Chunk hash mismatch");
+			}
+			else
+			{
+				VerifiedCount.IncrementExchange();
+				VerifiedBytes.AddExchange(PackageInfo.SerializeSize);
+				return;
+			}
+		}
+
+		UE_LOG(LogPakAnalyzer, Error, TEXT("Verify failed! %s, container: %s, offset: %lld, block: %d, block offset: %lld, file: %s"), *Failure.Reason, *Failure.PakName, Failure.Offset, Failure.BlockIndex, Failure.BlockOffset, *Failure.Path);
+
+		FScopeLock Lock(&FailureCriticalSection);
+		Result.Failures.Add(MoveTemp(Failure));
+	}, EParallelForFlags::Unbalanced);
+
+	Result.VerifiedCount = VerifiedCount;
+	Result.VerifiedBytes = VerifiedBytes;
+	Result.Seconds = FPlatformTime::Seconds() - StartTime;
+	Result.bCancelled = IsStopVerify;
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Verify %s: %d of %d packages verified, %d failures, %.2f MB in %.2fs, %.2f MB/s."), Result.bCancelled ? TEXT("cancelled") : TEXT("finished"),
+		Result.VerifiedCount, Result.TotalCount, Result.Failures.Num(), Result.VerifiedBytes / 1024.0 / 1024.0, Result.Seconds, Result.GetBytesPerSecond() / 1024.0 / 1024.0);
+
+	if (!Result.bCancelled)
+	{
+		FinishVerify(Result);
+	}
+}
+
 void FIoStoreAnalyzer::StopExtract()
 {
 	IsStopExtract.AtomicSet(true);
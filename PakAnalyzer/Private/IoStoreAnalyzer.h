@@ -17,6 +17,7 @@
 #include "IO/PackageId.h"
 #include "Templates/SharedPointer.h"
 
+#include "AssetSummaryCache.h"
 #include "BaseAnalyzer.h"
 #include "IoStoreDefines.h"
 
@@ -28,7 +29,10 @@ public:
 
 	virtual bool LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<FString>& InDefaultAESKeys, int32 ContainerStartIndex = 0) override;
 	virtual void ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles) override;
+	virtual bool ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles) override;
 	virtual void CancelExtract() override;
+	virtual void VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles) override;
+	virtual void CancelVerify() override;
 	virtual void SetExtractThreadCount(int32 InThreadCount) override;
 	virtual void Reset() override;
 	
@@ -40,7 +44,14 @@ protected:
 	bool PreLoadIoStore(const FString& InTocPath, const FString& InCasPath, const FString& InDefaultAESKey, TMap<FGuid, FAES::FAESKey>& OutKeys, FString& OutDecryptKey);
 	bool TryDecryptIoStore(const FIoStoreTocResourceInfo& TocResource, const FIoOffsetAndLength& OffsetAndLength, const FIoStoreTocEntryMeta& Meta, const FString& InCasPath, const FString& InKey, FAES::FAESKey& OutAESKey);
 	bool FillPackageInfo(const FIoStoreTocResourceInfo& TocResource, FStorePackageInfo& OutPackageInfo);
+	static FAssetSummaryPtr MakeAssetSummary(const FStorePackageInfo& InPackageInfo, uint32 InPackageFlags, const TArray<FName>& InNames);
+	/** Restores the header pass output of a package from the summary cache, keyed by its chunk hash. */
+	bool LoadPackageRecord(const FPackageStoreExportEntry* InExportEntry, FStorePackageInfo& InOutPackageInfo);
+	void SavePackageRecord(const FStorePackageInfo& InPackageInfo, uint32 InPackageFlags, const TArray<FName>& InNames, bool bInHasExports, FAssetSummaryCache::FNewRecords& OutNewRecords);
+	void StartExtract(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles, bool bInArchive);
 	void OnExtractFiles();
+	void OnExtractFilesToArchive();
+	void OnVerifyPackages(const TArray<int32>& InPackages);
 	void StopExtract();
 	void UpdateExtractProgress(int32 InTotal, int32 InComplete, int32 InError);
 	void ParseChunkInfo(const FIoChunkId& InChunkId, FPackageId& OutPackageId, EIoChunkType& OutChunkType);
@@ -51,7 +62,8 @@ protected:
 	TArray<FDisplayNameEntryId> GlobalNameMap;
 	TArray<FContainerInfo> StoreContainers;
 	TArray<FStorePackageInfo> PackageInfos;
-	TMap<FString, int32> FileToPackageIndex;
+	// Keyed by tree entry instead of full path to avoid a second copy of every path
+	TMap<const FPakFileEntry*, int32> FileToPackageIndex;
 
 	TArray<FString> DefaultAESKeys;
 
@@ -60,9 +72,14 @@ protected:
 	FThreadSafeBool IsStopExtract;
 	FString ExtractOutputPath;
 
+	TFuture<void> VerifyTask;
+	FThreadSafeBool IsStopVerify;
+
 	TMap<FPackageObjectIndex, FScriptObjectDesc> ScriptObjectByGlobalIdMap;
 	TMap<uint64, FIoStoreTocResourceInfo> TocResources;
 	TMap<FPackageObjectIndex, const FIoStoreExport*> ExportByGlobalIdMap;
+
+	FAssetSummaryCache SummaryCache;
 };
 
 #endif // ENABLE_IO_STORE_ANALYZER
@@ -5,24 +5,44 @@
 #include "AssetRegistry/ARFilter.h"
 #include "AssetRegistry/AssetData.h"
 #include "AssetRegistry/AssetRegistryState.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
 #include "HAL/FileManager.h"
 #include "HAL/PlatformFile.h"
 #include "HAL/PlatformMisc.h"
+#include "HAL/PlatformTime.h"
 #include "Json.h"
 #include "Misc/Base64.h"
 #include "Misc/Paths.h"
 #include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
 // #include "Serialization/Archive.h"
 // #include "Serialization/MemoryWriter.h"
 
 #include "AssetParseThreadWorker.h"
 #include "CommonDefines.h"
 #include "ExtractThreadWorker.h"
+#include "PakIndexCache.h"
+#include "PakVerifier.h"
 
 typedef FPakFile::FPakEntryIterator RecordIterator;
 
+static bool DecodeAESKey(const FString& InKey, FAES::FAESKey& OutKey)
+{
+	TArray<uint8> DecodedBuffer;
+	if (InKey.IsEmpty() || !FBase64::Decode(InKey, DecodedBuffer) || DecodedBuffer.Num() != FAES::FAESKey::KeySize)
+	{
+		return false;
+	}
+
+	FMemory::Memcpy(OutKey.Key, DecodedBuffer.GetData(), FAES::FAESKey::KeySize);
+	return true;
+}
+
 FPakAnalyzer::FPakAnalyzer()
 	: ExtractWorkerCount(DEFAULT_EXTRACT_THREAD_COUNT)
+	, ExtractReadWorkerCount(DEFAULT_EXTRACT_READ_THREAD_COUNT)
+	, ExtractWriteWorkerCount(DEFAULT_EXTRACT_WRITE_THREAD_COUNT)
 {
 	Reset();
 	InitializeExtractWorker();
@@ -31,68 +51,115 @@ FPakAnalyzer::FPakAnalyzer()
 
 FPakAnalyzer::~FPakAnalyzer()
 {
+	CancelVerify();
 	ShutdownAssetParseWorker();
 	ShutdownAllExtractWorker();
 	Reset();
 }
 
-FPakTreeEntryPtr FPakAnalyzer::LoadPakFile(const FString& InPakPath, const FString& InDefaultAESKey/* = TEXT("")*/)
+bool FPakAnalyzer::LoadPakFile(FPakLoadContext& InContext)
 {
-	if (InPakPath.IsEmpty())
-	{
-		UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Pak path is empty!"));
-		return nullptr;
-	}
+	const FString& InPakPath = InContext.PakPath;
 
 	UE_LOG(LogPakAnalyzer, Log, TEXT("Start load pak file: %s."), *InPakPath);
 
-	IPlatformFile& PlatformFile = IPlatformFile::GetPlatformPhysical();
-	if (!PlatformFile.FileExists(*InPakPath))
+	FAES::FAESKey DecryptAESKey;
+	if (!DecodeAESKey(InContext.DecryptAESKey, DecryptAESKey))
 	{
-		FPakAnalyzerDelegates::OnLoadPakFailed.ExecuteIfBound(FString::Printf(TEXT("Load pak file failed! Pak file not exists! Path: %s."), *InPakPath));
-		UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Pak file not exists! Path: %s."), *InPakPath);
-		return nullptr;
+		DecryptAESKey.Reset();
 	}
 
-	FString DecryptAESKey;
-	if (!PreLoadPak(InPakPath, InDefaultAESKey, DecryptAESKey))
+	FPakFileSumaryPtr Summary = MakeShared<FPakFileSumary>();
+	TArray<FPakIndexRecord> Records;
+
+	// Cache is only trusted with the same key it was written with
+	const bool bUseIndexCache = InContext.bIndexCached && InContext.IndexCache.KeyHash == FPakIndexCache::HashKey(DecryptAESKey);
+	if (bUseIndexCache)
 	{
-		UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Pre load pak file failed! Path: %s."), *InPakPath);
-		return nullptr;
+		UE_LOG(LogPakAnalyzer, Log, TEXT("Load all file info from pak index cache."));
+
+		Summary->MountPoint = InContext.IndexCache.MountPoint;
+		Summary->PakInfo = InContext.PakInfo;
+		Summary->PakFileSize = IFileManager::Get().FileSize(*InPakPath);
+
+		Records = MoveTemp(InContext.IndexCache.Records);
 	}
-	
-	TRefCountPtr<FPakFile> PakFile = new FPakFile(*InPakPath, false);
-	FPakFile* PakFilePtr = PakFile.GetReference();
-	if (!PakFilePtr)
+	else
 	{
-		FPakAnalyzerDelegates::OnLoadPakFailed.ExecuteIfBound(FString::Printf(TEXT("Load pak file failed! Create PakFile failed! Path: %s."), *InPakPath));
-		UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Create PakFile failed! Path: %s."), *InPakPath);
+		TRefCountPtr<FPakFile> PakFile;
+		if (DecryptAESKey.IsValid())
+		{
+			// Encrypted index is decrypted in FPakFile constructor by the global key delegate
+			FScopeLock KeyLock(&DecryptKeyCriticalSection);
 
-		return nullptr;
-	}
+			RegisterDecryptKey(InContext.PakInfo, DecryptAESKey);
+			PakFile = new FPakFile(*InPakPath, false);
+		}
+		else
+		{
+			PakFile = new FPakFile(*InPakPath, false);
+		}
 
-	if (!PakFilePtr->IsValid())
-	{
-		FPakAnalyzerDelegates::OnLoadPakFailed.ExecuteIfBound(FString::Printf(TEXT("Load pak file failed! Unable to open pak file! Path: %s."), *InPakPath));
-		UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Unable to open pak file! Path: %s."), *InPakPath);
+		FPakFile* PakFilePtr = PakFile.GetReference();
+		if (!PakFilePtr)
+		{
+			InContext.Errors.Add(FString::Printf(TEXT("Load pak file failed! Create PakFile failed! Path: %s."), *InPakPath));
+			UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Create PakFile failed! Path: %s."), *InPakPath);
+
+			return false;
+		}
+
+		if (!PakFilePtr->IsValid())
+		{
+			InContext.Errors.Add(FString::Printf(TEXT("Load pak file failed! Unable to open pak file! Path: %s."), *InPakPath));
+			UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Unable to open pak file! Path: %s."), *InPakPath);
+
+			return false;
+		}
+
+		Summary->MountPoint = PakFilePtr->GetMountPoint();
+		Summary->PakInfo = PakFilePtr->GetInfo();
+		Summary->PakFileSize = PakFilePtr->TotalSize();
+
+		UE_LOG(LogPakAnalyzer, Log, TEXT("Load all file info from pak."));
+
+		// Iterate Files
+		for (RecordIterator It(*PakFilePtr, true); It; ++It)
+		{
+			FPakIndexRecord& Record = Records.AddDefaulted_GetRef();
+			Record.Filename = *It.TryGetFilename();
+			Record.Entry = It.Info();
 
-		return nullptr;
+			FPakEntry& PakEntry = Record.Entry;
+			if (PakEntry.CompressionBlocks.Num() == 1)
+			{
+				PakEntry.CompressionBlockSize = PakEntry.UncompressedSize;
+			}
+		}
+
+		// Index walk never touches payload, hashes are read from entry headers in batches
+		if (ReadEntryHashes(InPakPath, Summary->PakInfo.Version, Records))
+		{
+			FPakIndexCacheData CacheData;
+			CacheData.MountPoint = Summary->MountPoint;
+			CacheData.KeyHash = FPakIndexCache::HashKey(DecryptAESKey);
+			CacheData.Records = MoveTemp(Records);
+
+			FPakIndexCache::Save(InPakPath, Summary->PakInfo, CacheData);
+
+			Records = MoveTemp(CacheData.Records);
+		}
+		else
+		{
+			// Zero hashes would be trusted by every later load, read the index again next time
+			UE_LOG(LogPakAnalyzer, Warning, TEXT("Skip saving pak index cache, some entry hashes are missing: %s."), *InPakPath);
+		}
 	}
 
 	// Save pak sumary
-	FPakFileSumaryPtr Summary = MakeShared<FPakFileSumary>();
-	PakFileSummaries.Add(Summary);
-	const int32 SummaryIndex = PakFileSummaries.Num() - 1;
-
-	Summary->MountPoint = PakFilePtr->GetMountPoint();
-	Summary->PakInfo = PakFilePtr->GetInfo();
 	Summary->PakFilePath = InPakPath;
-	Summary->PakFileSize = PakFilePtr->TotalSize();
-	Summary->DecryptAESKeyStr = DecryptAESKey;
-	if (!FBase64::Decode(*DecryptAESKey, DecryptAESKey.Len(), Summary->DecryptAESKey.Key))
-	{
-		Summary->DecryptAESKey.Reset();
-	}
+	Summary->DecryptAESKeyStr = InContext.DecryptAESKey;
+	Summary->DecryptAESKey = DecryptAESKey;
 
 	TArray<FString> Methods;
 	for (const FName& Name : Summary->PakInfo.CompressionMethods)
@@ -104,59 +171,154 @@ FPakTreeEntryPtr FPakAnalyzer::LoadPakFile(const FString& InPakPath, const FStri
 	// Make tree root
 	FPakTreeEntryPtr PakTreeRoot = MakeShared<FPakTreeEntry>(*FPaths::GetCleanFilename(InPakPath), Summary->MountPoint, true);
 
-	UE_LOG(LogPakAnalyzer, Log, TEXT("Load all file info from pak."));
+	TArray<FString> FullFilePaths;
+	FullFilePaths.Reserve(Records.Num());
+	for (const FPakIndexRecord& Record : Records)
+	{
+		FString& FullFilePath = FullFilePaths.Add_GetRef(Summary->MountPoint / Record.Filename);
+		FullFilePath.ReplaceInline(TEXT("../"), TEXT(""));
+		FullFilePath.ReplaceInline(TEXT("..\\"), TEXT(""));
+	}
+
+	TArray<FPakTreeEntryPtr> Files;
+	BuildTree(PakTreeRoot, *Summary, FullFilePaths, [&Records](int32 Index) -> const FPakEntry& { return Records[Index].Entry; }, Files);
+
+	for (const FPakTreeEntryPtr& Child : Files)
+	{
+		if (Child.IsValid())
+		{
+			Child->OwnerPakIndex = InContext.PakIndex;
+			if (Child->Filename.ToString().EndsWith(TEXT("AssetRegistry.bin")))
+			{
+				// Asset registry is shared analyzer state, load it when merging
+				InContext.AssetRegistryEntry = Child;
+			}
+		}
+	}
+
+	RefreshTreeNode(PakTreeRoot);
+	RefreshTreeNodeSizePercent(PakTreeRoot, PakTreeRoot);
+
+	Summary->FileCount = PakTreeRoot->FileCount;
+
+	InContext.Summary = Summary;
+	InContext.PakTreeRoot = PakTreeRoot;
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Finish load pak file: %s, file count: %d."), *InPakPath, Summary->FileCount);
+
+	return true;
+}
+
+bool FPakAnalyzer::ReadEntryHashes(const FString& InPakPath, int32 InPakVersion, TArray<FPakIndexRecord>& InOutRecords)
+{
+	// Entry headers between close payloads are read with one request
+	static const int64 MaxGapSize = 64 * 1024;
+	static const int64 MaxBatchSize = 4 * 1024 * 1024;
 
-	// Iterate Files
-	struct FPakEntryWithFilename
+	struct FHeaderReadBatch
 	{
-		FPakEntry Entry;
-		FString Filename;
+		int64 Start;
+		int64 End;
+		int32 First;
+		int32 Num;
 	};
 
-	TArray<FPakEntryWithFilename> Records;
-	for (RecordIterator It(*PakFilePtr, true); It; ++It)
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<int32> SortedIndices;
+	SortedIndices.Reserve(InOutRecords.Num());
+	for (int32 i = 0; i < InOutRecords.Num(); ++i)
 	{
-		const FString& Filename = *It.TryGetFilename();
-		Records.Add({ It.Info(), Filename });
+		if (!InOutRecords[i].Entry.IsDeleteRecord())
+		{
+			SortedIndices.Add(i);
+		}
 	}
 
+	SortedIndices.Sort([&InOutRecords](int32 A, int32 B)
+		{
+			return InOutRecords[A].Entry.Offset < InOutRecords[B].Entry.Offset;
+		});
+
+	TArray<FHeaderReadBatch> Batches;
+	for (int32 i = 0; i < SortedIndices.Num(); ++i)
 	{
-		FScopeLock Lock(&CriticalSection);
+		const FPakEntry& Entry = InOutRecords[SortedIndices[i]].Entry;
+		const int64 HeaderEnd = Entry.Offset + Entry.GetSerializedSize(InPakVersion);
 
-		for (FPakEntryWithFilename& Record : Records)
+		FHeaderReadBatch* Batch = Batches.Num() > 0 ? &Batches.Last() : nullptr;
+		if (Batch && Entry.Offset - Batch->End <= MaxGapSize && HeaderEnd - Batch->Start <= MaxBatchSize)
+		{
+			Batch->End = FMath::Max(Batch->End, HeaderEnd);
+			++Batch->Num;
+		}
+		else
 		{
-			FPakTreeEntryPtr Child = nullptr;
+			Batches.Add({ Entry.Offset, HeaderEnd, i, 1 });
+		}
+	}
 
-			FPakEntry& PakEntry = Record.Entry;
+	if (Batches.Num() <= 0)
+	{
+		return true;
+	}
 
-			if (PakEntry.CompressionBlocks.Num() == 1)
-			{
-				PakEntry.CompressionBlockSize = PakEntry.UncompressedSize;
-			}
-			
-			PakFilePtr->ReadHashFromPayload(PakEntry, PakEntry.Hash);
+	// Paks already load in parallel, one reader walking the offset sorted batches keeps this pak's reads sequential
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*InPakPath));
+	if (!Reader)
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Read entry hash failed! Unable to open pak: %s."), *InPakPath);
+		return false;
+	}
+
+	int32 ErrorCount = 0;
+	int32 MismatchCount = 0;
+
+	TArray<uint8> Buffer;
+	for (const FHeaderReadBatch& Batch : Batches)
+	{
+		Buffer.SetNumUninitialized(Batch.End - Batch.Start);
+		Reader->Seek(Batch.Start);
+		Reader->Serialize(Buffer.GetData(), Buffer.Num());
+		if (Reader->IsError())
+		{
+			++ErrorCount;
+			Reader->ClearError();
+			continue;
+		}
+
+		FMemoryReader HeaderReader(Buffer);
+		for (int32 i = Batch.First; i < Batch.First + Batch.Num; ++i)
+		{
+			FPakEntry& Entry = InOutRecords[SortedIndices[i]].Entry;
 
-			FString FullFilePath = Summary->MountPoint / Record.Filename;
-			FullFilePath.ReplaceInline(TEXT("../"), TEXT(""));
-			FullFilePath.ReplaceInline(TEXT("..\\"), TEXT(""));
+			FPakEntry HeaderEntry;
+			HeaderReader.Seek(Entry.Offset - Batch.Start);
+			HeaderEntry.Serialize(HeaderReader, InPakVersion);
 
-			Child = InsertFileToTree(PakTreeRoot, *Summary, FullFilePath, PakEntry);
-			Child->OwnerPakIndex = SummaryIndex;
-			if (Child.IsValid() && Child->Filename.ToString().EndsWith(TEXT("AssetRegistry.bin")))
+			// A header which does not describe the index entry holds some other hash
+			if (HeaderReader.IsError() ||
+				HeaderEntry.Size != Entry.Size ||
+				HeaderEntry.UncompressedSize != Entry.UncompressedSize ||
+				HeaderEntry.CompressionMethodIndex != Entry.CompressionMethodIndex)
 			{
-				LoadAssetRegistryFromPak(PakFilePtr, Child, Summary->DecryptAESKey);
+				++MismatchCount;
+				HeaderReader.ClearError();
+				continue;
 			}
+
+			FMemory::Memcpy(Entry.Hash, HeaderEntry.Hash, sizeof(Entry.Hash));
 		}
 	}
 
-	RefreshTreeNode(PakTreeRoot);
-	RefreshTreeNodeSizePercent(PakTreeRoot, PakTreeRoot);
-
-	Summary->FileCount = PakTreeRoot->FileCount;
+	if (ErrorCount > 0 || MismatchCount > 0)
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Read entry hash failed! Pak: %s, failed read count: %d, mismatched header count: %d."), *InPakPath, ErrorCount, MismatchCount);
+	}
 
-	UE_LOG(LogPakAnalyzer, Log, TEXT("Finish load pak file: %s."), *InPakPath);
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Read %d entry hashes with %d reads in %.3fs."), SortedIndices.Num(), Batches.Num(), FPlatformTime::Seconds() - StartTime);
 
-	return PakTreeRoot;
+	return ErrorCount == 0 && MismatchCount == 0;
 }
 
 bool FPakAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<FString>& InDefaultAESKeys, int32 ContainerStartIndex)
@@ -185,15 +347,100 @@ bool FPakAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<
 	Reset();
 	DefaultAESKeys = UsedDefaultAESKeys;
 
+	const double StartTime = FPlatformTime::Seconds();
+	static const EParallelForFlags ParallelForFlags = FPlatformMisc::IsDebuggerPresent() ? EParallelForFlags::ForceSingleThread : EParallelForFlags::Unbalanced;
+
+	TArray<FPakLoadContext> Contexts;
+	Contexts.SetNum(PakFiles.Num());
 	for (int32 i = 0; i < PakFiles.Num(); ++i)
 	{
-		FPakTreeEntryPtr PakTreeRoot = LoadPakFile(PakFiles[i], DefaultAESKeys.IsValidIndex(i) ? DefaultAESKeys[i] : TEXT(""));
-		if (PakTreeRoot.IsValid())
+		Contexts[i].PakPath = PakFiles[i];
+		Contexts[i].DefaultAESKey = DefaultAESKeys[i];
+	}
+
+	auto ReportLoadErrors = [](FPakLoadContext& Context)
+	{
+		for (const FString& Error : Context.Errors)
+		{
+			FPakAnalyzerDelegates::OnLoadPakFailed.ExecuteIfBound(Error);
+		}
+		Context.Errors.Empty();
+	};
+
+	// Read pak info and validate default keys in parallel
+	ParallelFor(Contexts.Num(), [this, &Contexts](int32 Index)
+	{
+		PreLoadPak(Contexts[Index], false);
+	}, ParallelForFlags);
+
+	// Asking for missing keys needs user interaction, do it in order on this thread
+	int32 PreLoadedCount = 0;
+	for (FPakLoadContext& Context : Contexts)
+	{
+		ReportLoadErrors(Context);
+
+		if (Context.bNeedAESKey)
+		{
+			PreLoadPak(Context, true);
+			ReportLoadErrors(Context);
+		}
+
+		if (Context.bPreLoaded)
+		{
+			Context.PakIndex = PreLoadedCount++;
+		}
+		else
+		{
+			UE_LOG(LogPakAnalyzer, Error, TEXT("Load pak file failed! Pre load pak file failed! Path: %s."), *Context.PakPath);
+		}
+	}
+
+	// Read pak index and build file tree in parallel
+	ParallelFor(Contexts.Num(), [this, &Contexts](int32 Index)
+	{
+		if (Contexts[Index].bPreLoaded)
+		{
+			LoadPakFile(Contexts[Index]);
+		}
+	}, ParallelForFlags);
+
+	// Merge in input order, pak index never depends on which task finished first
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		for (FPakLoadContext& Context : Contexts)
 		{
-			PakTreeRoots.Add(PakTreeRoot);
+			ReportLoadErrors(Context);
+
+			if (!Context.PakTreeRoot.IsValid())
+			{
+				continue;
+			}
+
+			const int32 PakIndex = PakFileSummaries.Add(Context.Summary);
+			PakTreeRoots.Add(Context.PakTreeRoot);
+
+			if (PakIndex != Context.PakIndex)
+			{
+				// An earlier pak failed to open after pre load
+				RefreshOwnerPakIndex(Context.PakTreeRoot, PakIndex);
+			}
+
+			if (Context.AssetRegistryEntry.IsValid())
+			{
+				LoadAssetRegistryFromPak(*Context.Summary, Context.AssetRegistryEntry);
+			}
 		}
 	}
 
+	Contexts.Empty();
+
+	// Every Save finished, prune once without evicting the paks just loaded
+	FPakIndexCache::Prune(PakFiles);
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Load %d/%d pak files in %.3fs."), PakTreeRoots.Num(), PakFiles.Num(), FPlatformTime::Seconds() - StartTime);
+	LogTreeMemoryUsage();
+
 	if (!AssetRegistryPath.IsEmpty())
 	{
 		for (const FPakTreeEntryPtr& PakTreeRoot : PakTreeRoots)
@@ -203,6 +450,8 @@ bool FPakAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<
 		}
 	}
 
+	RefreshFileIndex();
+
 	ParseAssetFile();
 
 	//FPakAnalyzerDelegates::OnPakLoadFinish.Broadcast();
@@ -212,46 +461,201 @@ bool FPakAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<
 
 void FPakAnalyzer::ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles)
 {
-	const int32 WorkerCount = ExtractWorkers.Num();
-	const int32 FileCount = InFiles.Num();
+	StartExtract(InOutputPath, InFiles, false);
+}
+
+bool FPakAnalyzer::ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles)
+{
+	StartExtract(InArchivePath, InFiles, true);
+	return true;
+}
+
+void FPakAnalyzer::StartExtract(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles, bool bInArchive)
+{
+	// Files of other containers (IoStore under FUnrealAnalyzer) have no summary here and are extracted by their own analyzer
+	TArray<FPakFileEntryPtr> Files = InFiles.FilterByPredicate([this](const FPakFileEntryPtr& File)
+		{
+			return File.IsValid() && PakFileSummaries.IsValidIndex(File->OwnerPakIndex);
+		});
 
-	if (FileCount <= 0 || WorkerCount <= 0)
+	const int32 FileCount = Files.Num();
+
+	if (FileCount <= 0 || ExtractWorkers.Num() <= 0)
 	{
 		return;
 	}
 
 	FPakAnalyzerDelegates::OnExtractStart.ExecuteIfBound();
 
-	if (!FPaths::DirectoryExists(InOutputPath))
+	const FString OutputDirectory = bInArchive ? FPaths::GetPath(InOutputPath) : InOutputPath;
+	if (!OutputDirectory.IsEmpty() && !FPaths::DirectoryExists(OutputDirectory))
 	{
-		IFileManager::Get().MakeDirectory(*InOutputPath, true);
+		IFileManager::Get().MakeDirectory(*OutputDirectory, true);
 	}
 
 	ShutdownAllExtractWorker();
 
-	// Sort by original size
-	InFiles.Sort([](const FPakFileEntryPtr& A, const FPakFileEntryPtr& B) -> bool
+	// Order by pak and offset, every worker reads a contiguous range of the pak sequentially
+	Files.Sort([](const FPakFileEntryPtr& A, const FPakFileEntryPtr& B) -> bool
 		{
-			return A->PakEntry.UncompressedSize > B->PakEntry.UncompressedSize;
+			if (A->OwnerPakIndex != B->OwnerPakIndex)
+			{
+				return A->OwnerPakIndex < B->OwnerPakIndex;
+			}
+			return A->PakEntry.Offset < B->PakEntry.Offset;
 		});
 
-	// dispatch files to workers
-	TArray<TArray<FPakFileEntry>> TaskFiles;
-	TaskFiles.AddZeroed(WorkerCount);
+	TArray<FPakFileSumary> Summaries;
+	Summaries.AddDefaulted(PakFileSummaries.Num());
+	for (int32 i = 0; i < PakFileSummaries.Num(); ++i)
+	{
+		Summaries[i] = *PakFileSummaries[i];
+	}
 
-	TArray<int64> WorkerSize;
-	WorkerSize.AddZeroed(WorkerCount);
+	ExtractPipeline = MakeShared<FExtractPipeline, ESPMode::ThreadSafe>(ExtractReadWorkerCount, ExtractWorkerCount, ExtractWriteWorkerCount);
 
-	for (int32 i = 0; i < FileCount; ++i)
+	ResetProgress();
+	ExtractTotalCount = FileCount;
+	ExtractStartTime = FPlatformTime::Seconds();
+
+	// The archive is streamed in read order, so it is fed by a single reader
+	const int32 ReadWorkerCount = bInArchive ? 1 : ExtractReadWorkerCount;
+	if (bInArchive && !ExtractPipeline->OpenArchive(InOutputPath))
 	{
-		int32 MinIndex = 0;
-		FMath::Min(WorkerSize, &MinIndex);
+		ExtractPipeline.Reset();
+		FPakAnalyzerDelegates::OnUpdateExtractProgress.ExecuteIfBound(0, FileCount, ExtractTotalCount);
+		return;
+	}
 
-		TaskFiles[MinIndex].Add(*InFiles[i]);
-		WorkerSize[MinIndex] += InFiles[i]->PakEntry.UncompressedSize;
+	// Archives are always written from scratch, the journal only tracks directory outputs
+	const EExtractMode Mode = bInArchive ? EExtractMode::Full : ExtractMode;
+	FExtractJournal& Journal = ExtractPipeline->Journal;
+	if (!bInArchive)
+	{
+		Journal.Load(InOutputPath);
 	}
 
-	ResetProgress();
+	TArray<FPakFileEntry> TaskFiles;
+	TSet<FString> ExtractPaths;
+	TaskFiles.Reserve(FileCount);
+	for (const FPakFileEntryPtr& File : Files)
+	{
+		if (Mode != EExtractMode::Full)
+		{
+			const FExtractJournalRecord* Previous = Journal.Find(File->Path.ToString());
+			const FExtractJournalRecord Current = FExtractJournal::MakeRecord(*File, FPaths::GetCleanFilename(Summaries[File->OwnerPakIndex].PakFilePath));
+			if (Previous && Previous->Hash == Current.Hash && Previous->Size == Current.Size &&
+				(Mode == EExtractMode::Incremental || IFileManager::Get().FileSize(*(InOutputPath / *File->Path)) == Current.Size))
+			{
+				continue;
+			}
+		}
+
+		TaskFiles.Add(*File);
+		ExtractPaths.Add(File->Path.ToString());
+	}
+
+	ExtractSkippedCount = FileCount - TaskFiles.Num();
+
+	if (!bInArchive)
+	{
+		// Outputs hardlinked by an earlier run are removed, so rewriting one of them leaves the others intact
+		TSet<FString> LinkedPaths;
+		Journal.GetLinkedPaths(LinkedPaths);
+		for (const FString& LinkedPath : LinkedPaths)
+		{
+			if (ExtractPaths.Contains(LinkedPath))
+			{
+				IFileManager::Get().Delete(*(InOutputPath / LinkedPath), false, true, true);
+			}
+		}
+
+		Journal.Open(InOutputPath, ExtractPaths);
+	}
+
+	TMap<int32, TArray<FPakFileEntry>> Duplicates;
+	if (bExtractDeduplicate)
+	{
+		FindDuplicateFiles(TaskFiles, Duplicates);
+	}
+
+	if (TaskFiles.Num() <= 0)
+	{
+		UE_LOG(LogPakAnalyzer, Log, TEXT("Extract skipped all %d files, output is up to date."), FileCount);
+
+		Journal.Close();
+		FPakAnalyzerDelegates::OnUpdateExtractProgress.ExecuteIfBound(ExtractSkippedCount, 0, ExtractTotalCount);
+		return;
+	}
+
+	if (!bInArchive)
+	{
+		TArray<FString> OutputFilePaths;
+		OutputFilePaths.Reserve(TaskFiles.Num() + ExtractDuplicateCount);
+		for (const FPakFileEntry& File : TaskFiles)
+		{
+			OutputFilePaths.Add(InOutputPath / *File.Path);
+		}
+		for (const auto& It : Duplicates)
+		{
+			for (const FPakFileEntry& Duplicate : It.Value)
+			{
+				OutputFilePaths.Add(InOutputPath / *Duplicate.Path);
+			}
+		}
+
+		MakeOutputDirectories(OutputFilePaths);
+	}
+
+	TArray<FExtractTask> Tasks;
+	FExtractQueue::BuildTasks(TaskFiles, Summaries, Tasks);
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Extract %d files (%d skipped) in %d tasks with %d read, %d decode and %d write workers%s."), TaskFiles.Num(), ExtractSkippedCount, Tasks.Num(), ReadWorkerCount, ExtractWorkerCount, bInArchive ? 1 : ExtractWriteWorkerCount, bInArchive ? TEXT(" into archive") : TEXT(""));
+
+	ExtractPipeline->Queue.Initialize(TaskFiles, Tasks, ReadWorkerCount);
+	ExtractPipeline->Queue.SetDuplicates(Duplicates);
+
+	// Workers are numbered per stage
+	int32 StageWorkerIndices[3] = { 0, 0, 0 };
+	for (const TSharedPtr<FExtractThreadWorker>& Worker : ExtractWorkers)
+	{
+		Worker->StartExtract(Summaries, InOutputPath, ExtractPipeline, StageWorkerIndices[(int32)Worker->GetStage()]++);
+	}
+}
+
+void FPakAnalyzer::CancelExtract()
+{
+	ShutdownAllExtractWorker();
+}
+
+void FPakAnalyzer::VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles)
+{
+	CancelVerify();
+
+	TArray<FPakFileEntry> Files;
+	Files.Reserve(InFiles.Num());
+	for (const FPakFileEntryPtr& File : InFiles)
+	{
+		if (PakFileSummaries.IsValidIndex(File->OwnerPakIndex))
+		{
+			Files.Add(*File);
+		}
+	}
+
+	if (Files.Num() <= 0)
+	{
+		FinishEmptyVerify();
+		return;
+	}
+
+	Files.Sort([](const FPakFileEntry& A, const FPakFileEntry& B) -> bool
+		{
+			if (A.OwnerPakIndex != B.OwnerPakIndex)
+			{
+				return A.OwnerPakIndex < B.OwnerPakIndex;
+			}
+			return A.PakEntry.Offset < B.PakEntry.Offset;
+		});
 
 	TArray<FPakFileSumary> Summaries;
 	Summaries.AddDefaulted(PakFileSummaries.Num());
@@ -260,16 +664,42 @@ void FPakAnalyzer::ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntr
 		Summaries[i] = *PakFileSummaries[i];
 	}
 
-	for (int32 i = 0; i < WorkerCount; ++i)
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Start verify %d files."), Files.Num());
+
+	VerifyTask = Async(EAsyncExecution::Thread, [this, Files = MoveTemp(Files), Summaries = MoveTemp(Summaries)]()
+		{
+			FVerifyResult Result;
+			FPakVerifier Verifier(Summaries, bStopVerify);
+			Verifier.Verify(Files, Result);
+
+			UE_LOG(LogPakAnalyzer, Log, TEXT("Verify %s: %d of %d files verified, %d failures, %.2f MB in %.2fs, %.2f MB/s."), Result.bCancelled ? TEXT("cancelled") : TEXT("finished"),
+				Result.VerifiedCount, Result.TotalCount, Result.Failures.Num(), Result.VerifiedBytes / 1024.0 / 1024.0, Result.Seconds, Result.GetBytesPerSecond() / 1024.0 / 1024.0);
+
+			if (!Result.bCancelled)
+			{
+				FinishVerify(Result);
+			}
+		});
+}
+
+void FPakAnalyzer::CancelVerify()
+{
+	if (VerifyTask.IsValid())
 	{
-		ExtractWorkers[i]->InitTaskFiles(TaskFiles[i]);
-		ExtractWorkers[i]->StartExtract(Summaries, InOutputPath);
+		bStopVerify = true;
+		VerifyTask.Wait();
+		VerifyTask.Reset();
 	}
+
+	bStopVerify = false;
 }
 
-void FPakAnalyzer::CancelExtract()
+void FPakAnalyzer::PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles)
 {
-	ShutdownAllExtractWorker();
+	if (AssetParseWorker.IsValid())
+	{
+		AssetParseWorker->PrioritizeFiles(InFiles);
+	}
 }
 
 void FPakAnalyzer::SetExtractThreadCount(int32 InThreadCount)
@@ -284,55 +714,61 @@ void FPakAnalyzer::SetExtractThreadCount(int32 InThreadCount)
 	}
 }
 
+void FPakAnalyzer::SetExtractIOThreadCount(int32 InReadThreadCount, int32 InWriteThreadCount)
+{
+	const int32 ClampReadThreadCount = FMath::Clamp(InReadThreadCount, 1, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	const int32 ClampWriteThreadCount = FMath::Clamp(InWriteThreadCount, 1, FPlatformMisc::NumberOfCoresIncludingHyperthreads());
+	if (ClampReadThreadCount != ExtractReadWorkerCount || ClampWriteThreadCount != ExtractWriteWorkerCount)
+	{
+		UE_LOG(LogPakAnalyzer, Log, TEXT("Set extract read worker count: %d, write worker count: %d."), ClampReadThreadCount, ClampWriteThreadCount);
+
+		ExtractReadWorkerCount = ClampReadThreadCount;
+		ExtractWriteWorkerCount = ClampWriteThreadCount;
+		InitializeExtractWorker();
+	}
+}
+
+void FPakAnalyzer::SetExtractMode(EExtractMode InMode)
+{
+	ExtractMode = InMode;
+}
+
+void FPakAnalyzer::SetExtractDeduplicate(bool bInDeduplicate)
+{
+	bExtractDeduplicate = bInDeduplicate;
+}
+
 void FPakAnalyzer::Reset()
 {
+	CancelVerify();
 	ShutdownAssetParseWorker();
 	DefaultAESKeys.Empty();
 
 	FBaseAnalyzer::Reset();
 }
 
-bool FPakAnalyzer::LoadAssetRegistryFromPak(FPakFile* InPakFile, FPakFileEntryPtr InPakFileEntry, const FAES::FAESKey& DecryptAESKey)
+bool FPakAnalyzer::LoadAssetRegistryFromPak(const FPakFileSumary& InSummary, FPakFileEntryPtr InPakFileEntry)
 {
-	if (!InPakFile || !InPakFile->IsValid() || !InPakFileEntry.IsValid())
+	if (!InPakFileEntry.IsValid())
 	{
 		return false;
 	}
-	
-	const bool bHasRelativeCompressedChunkOffsets = InPakFile->GetInfo().Version >= FPakInfo::PakFile_Version_RelativeChunkOffsets;
-	
-	const int64 BufferSize = 8 * 1024 * 1024; // 8MB buffer for extracting
-	void* Buffer = FMemory::Malloc(BufferSize);
-	uint8* PersistantCompressionBuffer = NULL;
-	int64 CompressionBufferSize = 0;
-	
-	bool bReadResult = true;
-	const FPakEntry& EntryInfo = InPakFileEntry->PakEntry;
-	
-	FArrayReader ContentReader;
-	ContentReader.AddZeroed(InPakFileEntry->PakEntry.UncompressedSize);
-	
-	FMemoryWriter ContentWriter(ContentReader);
-	
-	if (EntryInfo.CompressionMethodIndex == 0)
-	{
-		if (!FExtractThreadWorker::BufferedCopyFile(ContentWriter, InPakFile->GetSharedReader(nullptr).GetArchive(), EntryInfo, Buffer, BufferSize, DecryptAESKey))
-		{
-			bReadResult = false;
-		}
-	}
-	else
+
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*InSummary.PakFilePath));
+	if (!Reader)
 	{
-		if (!FExtractThreadWorker::UncompressCopyFile(ContentWriter, InPakFile->GetSharedReader(nullptr).GetArchive(), EntryInfo, PersistantCompressionBuffer, CompressionBufferSize, DecryptAESKey, InPakFileEntry->CompressionMethod, bHasRelativeCompressedChunkOffsets))
-		{
-			bReadResult = false;
-		}
+		return false;
 	}
 	
-	FMemory::Free(Buffer);
-	FMemory::Free(PersistantCompressionBuffer);
+	const FPakEntry& EntryInfo = InPakFileEntry->PakEntry;
+
+	// Skip entry header in front of payload
+	FPakEntry HeaderEntry;
+	Reader->Seek(EntryInfo.Offset);
+	HeaderEntry.Serialize(*Reader, InSummary.PakInfo.Version);
 	
-	if (!bReadResult)
+	FArrayReader ContentReader;
+	if (!FExtractThreadWorker::ReadEntryToMemory(*Reader, EntryInfo, InSummary.PakInfo.Version, InSummary.DecryptAESKey, InPakFileEntry->CompressionMethod, ContentReader))
 	{
 		return false;
 	}
@@ -340,23 +776,44 @@ bool FPakAnalyzer::LoadAssetRegistryFromPak(FPakFile* InPakFile, FPakFileEntryPt
 	const bool bLoadResult = LoadAssetRegistry(ContentReader);
 	if (bLoadResult)
 	{
-		AssetRegistryPath = InPakFileEntry->Path;
+		AssetRegistryPath = InPakFileEntry->Path.ToString();
 	}
 	
 	return bLoadResult;
 }
 
-bool FPakAnalyzer::PreLoadPak(const FString& InPakPath, const FString& InDefaultAESKey, FString& OutDecryptKey)
+void FPakAnalyzer::RefreshOwnerPakIndex(FPakTreeEntryPtr InRoot, int32 InPakIndex)
+{
+	for (auto& Pair : InRoot->GetChildrenMap())
+	{
+		FPakTreeEntryPtr Child = Pair.Value;
+		if (Child->bIsDirectory)
+		{
+			RefreshOwnerPakIndex(Child, InPakIndex);
+		}
+		else
+		{
+			Child->OwnerPakIndex = InPakIndex;
+		}
+	}
+}
+
+bool FPakAnalyzer::PreLoadPak(FPakLoadContext& InContext, bool bAllowKeyPrompt)
 {
+	const FString& InPakPath = InContext.PakPath;
+
 	UE_LOG(LogPakAnalyzer, Log, TEXT("Pre load pak file: %s and check file hash."), *InPakPath);
 
+	InContext.bPreLoaded = false;
+	InContext.bNeedAESKey = false;
+
 	FArchive* Reader = IFileManager::Get().CreateFileReader(*InPakPath);
 	if (!Reader)
 	{
 		return false;
 	}
 
-	FPakInfo Info;
+	FPakInfo& Info = InContext.PakInfo;
 	const int64 CachedTotalSize = Reader->TotalSize();
 	bool bShouldLoad = false;
 	int32 CompatibleVersion = FPakInfo::PakFile_Version_Latest;
@@ -387,42 +844,61 @@ bool FPakAnalyzer::PreLoadPak(const FString& InPakPath, const FString& InDefault
 	if (!bShouldLoad)
 	{
 		UE_LOG(LogPakAnalyzer, Error, TEXT("%s is not a valid pak file!"), *InPakPath);
-		FPakAnalyzerDelegates::OnLoadPakFailed.ExecuteIfBound(FString::Printf(TEXT("%s is not a valid pak file!"), *InPakPath));
+		InContext.Errors.Add(FString::Printf(TEXT("%s is not a valid pak file!"), *InPakPath));
 
 		Reader->Close();
 		delete Reader;
 		return false;
 	}
 
-	if (Info.EncryptionKeyGuid.IsValid() || Info.bEncryptedIndex)
+	if (!bAllowKeyPrompt)
 	{
-		OutDecryptKey = InDefaultAESKey;
-		bShouldLoad = InDefaultAESKey.IsEmpty() ? false : TryDecryptPak(Reader, Info, InDefaultAESKey, false);
+		InContext.bIndexCached = FPakIndexCache::Load(InPakPath, Info, InContext.IndexCache);
+	}
 
-		if (!bShouldLoad)
+	if (Info.EncryptionKeyGuid.IsValid() || Info.bEncryptedIndex)
+	{
+		if (!bAllowKeyPrompt)
 		{
-			if (FPakAnalyzerDelegates::OnGetAESKey.IsBound())
-			{
-				bool bCancel = true;
-				do
-				{
-					OutDecryptKey = FPakAnalyzerDelegates::OnGetAESKey.Execute(InPakPath, Info.EncryptionKeyGuid, bCancel);
+			InContext.DecryptAESKey = InContext.DefaultAESKey;
 
-					bShouldLoad = !bCancel ? TryDecryptPak(Reader, Info, OutDecryptKey, true) : false;
-				} while (!bShouldLoad && !bCancel);
+			FAES::FAESKey DefaultKey;
+			if (InContext.bIndexCached && DecodeAESKey(InContext.DefaultAESKey, DefaultKey) && FPakIndexCache::HashKey(DefaultKey) == InContext.IndexCache.KeyHash)
+			{
+				// Cache is written after the key was validated against index hash
+				bShouldLoad = true;
 			}
 			else
 			{
-				UE_LOG(LogPakAnalyzer, Error, TEXT("Can't open encrypt pak without OnGetAESKey bound!"));
-				FPakAnalyzerDelegates::OnLoadPakFailed.ExecuteIfBound(FString::Printf(TEXT("Can't open encrypt pak without OnGetAESKey bound!")));
-				bShouldLoad = false;
+				bShouldLoad = InContext.DefaultAESKey.IsEmpty() ? false : TryDecryptPak(Reader, Info, InContext.DefaultAESKey, false);
 			}
+
+			// Let the loading thread ask for a key
+			InContext.bNeedAESKey = !bShouldLoad;
+		}
+		else if (FPakAnalyzerDelegates::OnGetAESKey.IsBound())
+		{
+			bool bCancel = true;
+			do
+			{
+				InContext.DecryptAESKey = FPakAnalyzerDelegates::OnGetAESKey.Execute(InPakPath, Info.EncryptionKeyGuid, bCancel);
+
+				bShouldLoad = !bCancel ? TryDecryptPak(Reader, Info, InContext.DecryptAESKey, true) : false;
+			} while (!bShouldLoad && !bCancel);
+		}
+		else
+		{
+			UE_LOG(LogPakAnalyzer, Error, TEXT("Can't open encrypt pak without OnGetAESKey bound!"));
+			InContext.Errors.Add(FString::Printf(TEXT("Can't open encrypt pak without OnGetAESKey bound!")));
+			bShouldLoad = false;
 		}
 	}
 
 	Reader->Close();
 	delete Reader;
 
+	InContext.bPreLoaded = bShouldLoad;
+
 	return bShouldLoad;
 }
 
@@ -492,46 +968,64 @@ bool FPakAnalyzer::TryDecryptPak(FArchive* InReader, const FPakInfo& InPakInfo,
 		else
 		{
 			UE_LOG(LogPakAnalyzer, Log, TEXT("Use AES encryption key base64[%s]."), *KeyString);
-			FCoreDelegates::GetPakEncryptionKeyDelegate().BindLambda(
-				[AESKey](uint8 OutKey[32])
-				{
-					FMemory::Memcpy(OutKey, AESKey.Key, 32);
-				});
-
-			if (InPakInfo.EncryptionKeyGuid.IsValid())
-			{
-				FCoreDelegates::GetRegisterEncryptionKeyMulticastDelegate().Broadcast(InPakInfo.EncryptionKeyGuid, AESKey);
-			}
 		}
 	}
 
 	return bShouldLoad;
 }
 
+void FPakAnalyzer::RegisterDecryptKey(const FPakInfo& InPakInfo, const FAES::FAESKey& InAESKey)
+{
+	FCoreDelegates::GetPakEncryptionKeyDelegate().BindLambda(
+		[InAESKey](uint8 OutKey[32])
+		{
+			FMemory::Memcpy(OutKey, InAESKey.Key, 32);
+		});
+
+	if (InPakInfo.EncryptionKeyGuid.IsValid())
+	{
+		FCoreDelegates::GetRegisterEncryptionKeyMulticastDelegate().Broadcast(InPakInfo.EncryptionKeyGuid, InAESKey);
+	}
+}
+
 void FPakAnalyzer::InitializeExtractWorker()
 {
-	UE_LOG(LogPakAnalyzer, Log, TEXT("Initialize extract worker count: %d."), ExtractWorkerCount);
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Initialize extract worker count, read: %d, decode: %d, write: %d."), ExtractReadWorkerCount, ExtractWorkerCount, ExtractWriteWorkerCount);
 
 	ShutdownAllExtractWorker();
 
-	ExtractWorkers.Empty();
-	for (int32 i = 0; i < ExtractWorkerCount; ++i)
+	auto AddWorkers = [this](EExtractStage InStage, int32 InCount)
 	{
-		TSharedPtr<FExtractThreadWorker> Worker = MakeShared<FExtractThreadWorker>();
-		Worker->GetOnUpdateExtractProgressDelegate().BindRaw(this, &FPakAnalyzer::OnUpdateExtractProgress);
+		for (int32 i = 0; i < InCount; ++i)
+		{
+			TSharedPtr<FExtractThreadWorker> Worker = MakeShared<FExtractThreadWorker>(InStage);
+			Worker->GetOnUpdateExtractProgressDelegate().BindRaw(this, &FPakAnalyzer::OnUpdateExtractProgress);
 
-		ExtractWorkers.Add(Worker);
-	}
+			ExtractWorkers.Add(Worker);
+		}
+	};
+
+	ExtractWorkers.Empty();
+	AddWorkers(EExtractStage::Read, ExtractReadWorkerCount);
+	AddWorkers(EExtractStage::Decode, ExtractWorkerCount);
+	AddWorkers(EExtractStage::Write, ExtractWriteWorkerCount);
 
 	ResetProgress();
 }
 
 void FPakAnalyzer::ShutdownAllExtractWorker()
 {
+	if (ExtractPipeline.IsValid())
+	{
+		ExtractPipeline->Cancel();
+	}
+
 	for (TSharedPtr<FExtractThreadWorker> Worker : ExtractWorkers)
 	{
 		Worker->Shutdown();
 	}
+
+	ExtractPipeline.Reset();
 }
 
 void FPakAnalyzer::ParseAssetFile()
@@ -567,6 +1061,7 @@ void FPakAnalyzer::InitializeAssetParseWorker()
 	{
 		AssetParseWorker = MakeShared<FAssetParseThreadWorker>();
 		AssetParseWorker->OnParseFinish.BindRaw(this, &FPakAnalyzer::OnAssetParseFinish);
+		AssetParseWorker->OnAssetParsed.BindRaw(this, &FPakAnalyzer::OnAssetParsed);
 	}
 }
 
@@ -596,6 +1091,8 @@ void FPakAnalyzer::OnAssetParseFinish(bool bCancel, const TMap<FName, FName>& Cl
 				{
 					RefreshClassMap(PakTreeRoot, PakTreeRoot);
 				}
+
+				RefreshFileIndex();
 			}
 
 			FPakAnalyzerDelegates::OnAssetParseFinish.Broadcast();
@@ -603,32 +1100,118 @@ void FPakAnalyzer::OnAssetParseFinish(bool bCancel, const TMap<FName, FName>& Cl
 		TStatId(), nullptr, ENamedThreads::GameThread);
 }
 
-void FPakAnalyzer::OnUpdateExtractProgress(const FGuid& WorkerGuid, int32 CompleteCount, int32 ErrorCount, int32 TotalCount)
+void FPakAnalyzer::OnAssetParsed(FPakFileEntryPtr InFile)
 {
-	FFunctionGraphTask::CreateAndDispatchWhenReady([this, &WorkerGuid, CompleteCount, ErrorCount, TotalCount]()
+	FFunctionGraphTask::CreateAndDispatchWhenReady([InFile]()
 		{
-			FExtractProgress& Progress = ExtractWorkerProgresses.FindOrAdd(WorkerGuid);
+			FPakAnalyzerDelegates::OnAssetParsed.Broadcast(InFile);
+		},
+		TStatId(), nullptr, ENamedThreads::GameThread);
+}
 
-			Progress.CompleteCount = CompleteCount;
-			Progress.ErrorCount = ErrorCount;
-			Progress.TotalCount = TotalCount;
+void FPakAnalyzer::OnUpdateExtractProgress(const FGuid& WorkerGuid, const FExtractWorkerStats& Stats)
+{
+	FFunctionGraphTask::CreateAndDispatchWhenReady([this, WorkerGuid, Stats]()
+		{
+			ExtractWorkerStats.FindOrAdd(WorkerGuid) = Stats;
 
-			int32 TotalCompleteCount = 0;
+			int32 TotalCompleteCount = ExtractSkippedCount;
 			int32 TotalErrorCount = 0;
-			int32 TotalTotalCount = 0;
-			for (const auto& It : ExtractWorkerProgresses)
+			bool bAllFinished = true;
+			double LastFinishTime = 0.0;
+			for (const auto& It : ExtractWorkerStats)
 			{
 				TotalCompleteCount += It.Value.CompleteCount;
 				TotalErrorCount += It.Value.ErrorCount;
-				TotalTotalCount += It.Value.TotalCount;
+				bAllFinished &= It.Value.bFinished;
+				LastFinishTime = FMath::Max(LastFinishTime, It.Value.FinishTime);
+			}
+
+			// A worker is idle from the moment it ran out of tasks until the last worker finished
+			const double Now = bAllFinished ? LastFinishTime : FPlatformTime::Seconds();
+			TArray<FExtractWorkerStats> AllStats;
+			for (const TSharedPtr<FExtractThreadWorker>& Worker : ExtractWorkers)
+			{
+				FExtractWorkerStats& WorkerStats = AllStats.AddDefaulted_GetRef();
+				if (const FExtractWorkerStats* Found = ExtractWorkerStats.Find(Worker->GetGuid()))
+				{
+					WorkerStats = *Found;
+					WorkerStats.IdleSeconds = WorkerStats.bFinished ? Now - WorkerStats.FinishTime : 0.0;
+				}
+			}
+
+			if (bAllFinished && ExtractWorkerStats.Num() == ExtractWorkers.Num() && !bExtractReported)
+			{
+				bExtractReported = true;
+
+				int64 WrittenBytes = 0;
+				for (const FExtractWorkerStats& WorkerStats : AllStats)
+				{
+					WrittenBytes += WorkerStats.Stage == EExtractStage::Write ? WorkerStats.ExtractedBytes : 0;
+				}
+
+				const double ElapsedSeconds = LastFinishTime - ExtractStartTime;
+				UE_LOG(LogPakAnalyzer, Log, TEXT("Extract finished: %d files, %d errors, %.2f MB written in %.2fs."), TotalCompleteCount, TotalErrorCount, WrittenBytes / 1024.0 / 1024.0, ElapsedSeconds);
+
+				if (ExtractDuplicateCount > 0)
+				{
+					// Estimated with the write rate of this run
+					const double SavedSeconds = WrittenBytes > 0 ? ExtractDuplicateBytes * ElapsedSeconds / WrittenBytes : 0.0;
+					UE_LOG(LogPakAnalyzer, Log, TEXT("Extract deduplicate: %d files linked, %.2f MB and about %.2fs saved."), ExtractDuplicateCount, ExtractDuplicateBytes / 1024.0 / 1024.0, SavedSeconds);
+				}
 			}
 
-			FPakAnalyzerDelegates::OnUpdateExtractProgress.ExecuteIfBound(TotalCompleteCount, TotalErrorCount, TotalTotalCount);
+			FPakAnalyzerDelegates::OnUpdateExtractProgress.ExecuteIfBound(TotalCompleteCount, TotalErrorCount, ExtractTotalCount);
+			FPakAnalyzerDelegates::OnUpdateExtractWorkerStats.ExecuteIfBound(AllStats);
 		},
 		TStatId(), nullptr, ENamedThreads::GameThread);
 }
 
 void FPakAnalyzer::ResetProgress()
 {
-	ExtractWorkerProgresses.Empty(ExtractWorkers.Num());
+	ExtractWorkerStats.Empty(ExtractWorkers.Num());
+	ExtractTotalCount = 0;
+	ExtractSkippedCount = 0;
+	ExtractDuplicateCount = 0;
+	ExtractDuplicateBytes = 0;
+	bExtractReported = false;
+}
+
+void FPakAnalyzer::FindDuplicateFiles(TArray<FPakFileEntry>& InOutFiles, TMap<int32, TArray<FPakFileEntry>>& OutDuplicates)
+{
+	// The first file of every hash is extracted, later ones are removed from the list and linked to it
+	TMap<FSHAHash, int32> FirstFiles;
+	TArray<FPakFileEntry> UniqueFiles;
+	UniqueFiles.Reserve(InOutFiles.Num());
+
+	const FSHAHash EmptyHash;
+	for (FPakFileEntry& File : InOutFiles)
+	{
+		FSHAHash Hash;
+		FMemory::Memcpy(Hash.Hash, File.PakEntry.Hash, sizeof(Hash.Hash));
+
+		if (Hash != EmptyHash)
+		{
+			const int32* FirstIndex = FirstFiles.Find(Hash);
+			if (FirstIndex && UniqueFiles[*FirstIndex].PakEntry.UncompressedSize == File.PakEntry.UncompressedSize)
+			{
+				ExtractDuplicateBytes += File.PakEntry.UncompressedSize;
+				++ExtractDuplicateCount;
+
+				OutDuplicates.FindOrAdd(*FirstIndex).Add(MoveTemp(File));
+				continue;
+			}
+
+			if (!FirstIndex)
+			{
+				FirstFiles.Add(Hash, UniqueFiles.Num());
+			}
+		}
+
+		UniqueFiles.Add(MoveTemp(File));
+	}
+
+	InOutFiles = MoveTemp(UniqueFiles);
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Extract deduplicate: %d files with %.2f MB are linked to %d unique files."), ExtractDuplicateCount, ExtractDuplicateBytes / 1024.0 / 1024.0, OutDuplicates.Num());
 }
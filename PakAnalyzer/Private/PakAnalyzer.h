@@ -4,7 +4,9 @@
 
 #include "CoreMinimal.h"
 
+#include "Async/Future.h"
 #include "HAL/CriticalSection.h"
+#include "HAL/ThreadSafeBool.h"
 #include "IPlatformFilePak.h"
 #include "Misc/AES.h"
 #include "Misc/Guid.h"
@@ -12,6 +14,8 @@
 #include "Serialization/ArrayReader.h"
 
 #include "BaseAnalyzer.h"
+#include "CommonDefines.h"
+#include "PakIndexCache.h"
 
 struct FPakEntry;
 
@@ -23,18 +27,52 @@ public:
 
 	virtual bool LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<FString>& InDefaultAESKeys, int32 ContainerStartIndex = 0) override;
 	virtual void ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles) override;
+	virtual bool ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles) override;
 	virtual void CancelExtract() override;
+	virtual void VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles) override;
+	virtual void CancelVerify() override;
+	virtual void PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles) override;
 	virtual void SetExtractThreadCount(int32 InThreadCount) override;
+	virtual void SetExtractIOThreadCount(int32 InReadThreadCount, int32 InWriteThreadCount) override;
+	virtual void SetExtractMode(EExtractMode InMode) override;
+	virtual void SetExtractDeduplicate(bool bInDeduplicate) override;
 	virtual void Reset() override;
 
 protected:
-	FPakTreeEntryPtr LoadPakFile(const FString& InPakPath, const FString& InDefaultAESKey = TEXT(""));
-	bool LoadAssetRegistryFromPak(FPakFile* InPakFile, FPakFileEntryPtr InPakFileEntry, const FAES::FAESKey& DecryptAESKey);
+	// Per pak load state, filled by load tasks and merged in input order
+	struct FPakLoadContext
+	{
+		FString PakPath;
+		FString DefaultAESKey;
+		FString DecryptAESKey;
+		FPakInfo PakInfo;
+		int32 PakIndex = INDEX_NONE;
+		bool bPreLoaded = false;
+		bool bNeedAESKey = false;
+		bool bIndexCached = false;
+
+		FPakIndexCacheData IndexCache;
+		FPakFileSumaryPtr Summary;
+		FPakTreeEntryPtr PakTreeRoot;
+		FPakTreeEntryPtr AssetRegistryEntry;
+
+		// Errors raised on worker threads, reported by the loading thread
+		TArray<FString> Errors;
+	};
 
-	bool PreLoadPak(const FString& InPakPath, const FString& InDefaultAESKey, FString& OutDecryptKey);
+	bool LoadPakFile(FPakLoadContext& InContext);
+	/** Returns false when any header could not be read or does not match its index entry, the hashes of those entries stay zero. */
+	bool ReadEntryHashes(const FString& InPakPath, int32 InPakVersion, TArray<FPakIndexRecord>& InOutRecords);
+	bool LoadAssetRegistryFromPak(const FPakFileSumary& InSummary, FPakFileEntryPtr InPakFileEntry);
+	void RefreshOwnerPakIndex(FPakTreeEntryPtr InRoot, int32 InPakIndex);
+
+	bool PreLoadPak(FPakLoadContext& InContext, bool bAllowKeyPrompt);
 	bool ValidateEncryptionKey(TArray<uint8>& IndexData, const FSHAHash& InExpectedHash, const FAES::FAESKey& InAESKey);
 	bool TryDecryptPak(FArchive* InReader, const FPakInfo& InPakInfo, const FString& InKey, bool bShowWarning);
+	void RegisterDecryptKey(const FPakInfo& InPakInfo, const FAES::FAESKey& InAESKey);
 
+	/** Output is a directory, or a tar archive path when bInArchive is set. */
+	void StartExtract(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles, bool bInArchive);
 	void InitializeExtractWorker();
 	void ShutdownAllExtractWorker();
 
@@ -42,25 +80,41 @@ protected:
 	void InitializeAssetParseWorker();
 	void ShutdownAssetParseWorker();
 	void OnAssetParseFinish(bool bCancel, const TMap<FName, FName>& ClassMap);
+	void OnAssetParsed(FPakFileEntryPtr InFile);
 
 	// Extract progress
-	void OnUpdateExtractProgress(const FGuid& WorkerGuid, int32 CompleteCount, int32 ErrorCount, int32 TotalCount);
-
-	struct FExtractProgress
-	{
-		int32 CompleteCount;
-		int32 ErrorCount;
-		int32 TotalCount;
-	};
-
+	void OnUpdateExtractProgress(const FGuid& WorkerGuid, const FExtractWorkerStats& Stats);
 	void ResetProgress();
+	void FindDuplicateFiles(TArray<FPakFileEntry>& InOutFiles, TMap<int32, TArray<FPakFileEntry>>& OutDuplicates);
 
 protected:
+	// Decode workers, readers and writers are configured separately
 	int32 ExtractWorkerCount;
+	int32 ExtractReadWorkerCount;
+	int32 ExtractWriteWorkerCount;
+	// Ordered by stage: readers, decoders, writers
 	TArray<TSharedPtr<class FExtractThreadWorker>> ExtractWorkers;
-	TMap<FGuid, FExtractProgress> ExtractWorkerProgresses;
+	TSharedPtr<class FExtractPipeline, ESPMode::ThreadSafe> ExtractPipeline;
+	TMap<FGuid, FExtractWorkerStats> ExtractWorkerStats;
+	int32 ExtractTotalCount = 0;
+	// Files skipped by resume or incremental extraction, counted as complete
+	int32 ExtractSkippedCount = 0;
+	EExtractMode ExtractMode = EExtractMode::Full;
+
+	// Files with the same hash are written once and hardlinked
+	bool bExtractDeduplicate = false;
+	int32 ExtractDuplicateCount = 0;
+	int64 ExtractDuplicateBytes = 0;
+	double ExtractStartTime = 0.0;
+	bool bExtractReported = false;
+
+	TFuture<void> VerifyTask;
+	FThreadSafeBool bStopVerify;
 
 	TArray<FString> DefaultAESKeys;
 
+	// Guards the global pak encryption key delegate while a pak index is opened
+	FCriticalSection DecryptKeyCriticalSection;
+
 	TSharedPtr<class FAssetParseThreadWorker> AssetParseWorker;
 };
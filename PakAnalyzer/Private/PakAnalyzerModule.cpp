@@ -18,8 +18,11 @@ DEFINE_LOG_CATEGORY(LogPakAnalyzer);
 FPakAnalyzerDelegates::FOnGetAESKey FPakAnalyzerDelegates::OnGetAESKey;
 FPakAnalyzerDelegates::FOnLoadPakFailed FPakAnalyzerDelegates::OnLoadPakFailed;
 FPakAnalyzerDelegates::FOnUpdateExtractProgress FPakAnalyzerDelegates::OnUpdateExtractProgress;
+FPakAnalyzerDelegates::FOnUpdateExtractWorkerStats FPakAnalyzerDelegates::OnUpdateExtractWorkerStats;
 FPakAnalyzerDelegates::FOnExtractStart FPakAnalyzerDelegates::OnExtractStart;
+FPakAnalyzerDelegates::FOnVerifyFinish FPakAnalyzerDelegates::OnVerifyFinish;
 FPakAnalyzerDelegates::FOnAssetParseFinish FPakAnalyzerDelegates::OnAssetParseFinish;
+FPakAnalyzerDelegates::FOnAssetParsed FPakAnalyzerDelegates::OnAssetParsed;
 FPakAnalyzerDelegates::FOnPakLoadFinish FPakAnalyzerDelegates::OnPakLoadFinish;
 
 class FPakAnalyzerModule : public IPakAnalyzerModule
@@ -1 +1,30 @@
-#include "PakFileEntry.h"
\ No newline at end of file
+#include "PakFileEntry.h"
+
+#include "PakTreeArena.h"
+
+FPakTreeEntry::FDirectoryData::~FDirectoryData()
+{
+	// Only roots hold the arena, children alias its reference count and would keep it alive forever
+	if (Arena.IsValid())
+	{
+		Arena->Release();
+	}
+}
+
+void FPakTreeEntry::ReleaseTree()
+{
+	if (!DirectoryData.IsValid())
+	{
+		return;
+	}
+
+	// Keep the arena alive until every node dropped its children
+	TSharedPtr<FPakTreeArena> Arena = DirectoryData->Arena;
+	if (Arena.IsValid())
+	{
+		Arena->Release();
+	}
+
+	DirectoryData->ChildrenMap.Empty();
+	DirectoryData->Arena.Reset();
+}
@@ -0,0 +1,234 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "PakIndexCache.h"
+
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+#include "CacheFile.h"
+#include "CommonDefines.h"
+
+static const uint32 PAK_INDEX_CACHE_MAGIC = 0x50494358;
+static const int32 PAK_INDEX_CACHE_VERSION = 1;
+
+static const int32 PAK_INDEX_CACHE_MAX_FILE_COUNT = 256;
+static const double PAK_INDEX_CACHE_MAX_AGE_DAYS = 30.0;
+
+bool FPakIndexCache::Load(const FString& InPakPath, const FPakInfo& InPakInfo, FPakIndexCacheData& OutData)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	if (InPakInfo.bEncryptedIndex)
+	{
+		return false;
+	}
+
+	const FString CachePath = GetCachePath(InPakPath);
+
+	const bool bLoaded = FCacheFile::Load(CachePath, PAK_INDEX_CACHE_MAGIC, PAK_INDEX_CACHE_VERSION, MAX_int64, [&InPakPath, &InPakInfo, &OutData](FArchive& Reader)
+		{
+			FString PakPath;
+			int64 PakFileSize = 0;
+			FDateTime PakTimeStamp;
+			FSHAHash PakInfoHash;
+
+			Reader << PakPath;
+			Reader << PakFileSize;
+			Reader << PakTimeStamp;
+			Reader << PakInfoHash;
+
+			IFileManager& FileManager = IFileManager::Get();
+			if (!PakPath.Equals(InPakPath, ESearchCase::IgnoreCase) ||
+				PakFileSize != FileManager.FileSize(*InPakPath) ||
+				PakTimeStamp != FileManager.GetTimeStamp(*InPakPath) ||
+				PakInfoHash != HashPakInfo(InPakInfo))
+			{
+				UE_LOG(LogPakAnalyzer, Log, TEXT("Pak index cache is out of date: %s."), *InPakPath);
+				return false;
+			}
+
+			Reader << OutData.MountPoint;
+			Reader << OutData.KeyHash;
+
+			int32 RecordCount = 0;
+			Reader << RecordCount;
+			if (RecordCount < 0)
+			{
+				return false;
+			}
+
+			OutData.Records.SetNum(RecordCount);
+			for (FPakIndexRecord& Record : OutData.Records)
+			{
+				SerializeRecord(Reader, Record);
+			}
+
+			return true;
+		});
+
+	if (!bLoaded)
+	{
+		OutData.Records.Empty();
+		return false;
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Load pak index cache: %s, record count: %d, %.3fs."), *CachePath, OutData.Records.Num(), FPlatformTime::Seconds() - StartTime);
+
+	return true;
+}
+
+bool FPakIndexCache::Save(const FString& InPakPath, const FPakInfo& InPakInfo, const FPakIndexCacheData& InData)
+{
+	const FString CachePath = GetCachePath(InPakPath);
+
+	IFileManager& FileManager = IFileManager::Get();
+
+	if (InPakInfo.bEncryptedIndex)
+	{
+		// Removes caches written before encrypted indices were skipped
+		FileManager.Delete(*CachePath, false, true, true);
+		return false;
+	}
+
+	const bool bSaved = FCacheFile::Save(CachePath, PAK_INDEX_CACHE_MAGIC, PAK_INDEX_CACHE_VERSION, [&InPakPath, &InPakInfo, &InData, &FileManager](FArchive& Writer)
+		{
+			FString PakPath = InPakPath;
+			int64 PakFileSize = FileManager.FileSize(*InPakPath);
+			FDateTime PakTimeStamp = FileManager.GetTimeStamp(*InPakPath);
+			FSHAHash PakInfoHash = HashPakInfo(InPakInfo);
+			FString MountPoint = InData.MountPoint;
+			FSHAHash KeyHash = InData.KeyHash;
+			int32 RecordCount = InData.Records.Num();
+
+			Writer << PakPath;
+			Writer << PakFileSize;
+			Writer << PakTimeStamp;
+			Writer << PakInfoHash;
+			Writer << MountPoint;
+			Writer << KeyHash;
+			Writer << RecordCount;
+
+			for (const FPakIndexRecord& Record : InData.Records)
+			{
+				SerializeRecord(Writer, const_cast<FPakIndexRecord&>(Record));
+			}
+		});
+
+	if (!bSaved)
+	{
+		return false;
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Save pak index cache: %s, record count: %d."), *CachePath, InData.Records.Num());
+
+	return true;
+}
+
+void FPakIndexCache::Prune(const TArray<FString>& InKeepPakPaths)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	const FString CacheDir = GetCacheDir();
+
+	TSet<FString> KeepCacheFiles;
+	for (const FString& KeepPakPath : InKeepPakPaths)
+	{
+		KeepCacheFiles.Add(FPaths::GetCleanFilename(GetCachePath(KeepPakPath)));
+	}
+
+	const int32 MaxFileCount = FMath::Max(PAK_INDEX_CACHE_MAX_FILE_COUNT, KeepCacheFiles.Num());
+
+	TArray<FString> CacheFiles;
+	FileManager.FindFiles(CacheFiles, *(CacheDir / TEXT("*.bin")), true, false);
+
+	TArray<TPair<FDateTime, FString>> CacheFileTimes;
+	const FDateTime Now = FDateTime::UtcNow();
+	for (const FString& CacheFile : CacheFiles)
+	{
+		if (KeepCacheFiles.Contains(CacheFile))
+		{
+			continue;
+		}
+
+		const FString CacheFilePath = CacheDir / CacheFile;
+		const FDateTime TimeStamp = FileManager.GetTimeStamp(*CacheFilePath);
+		if ((Now - TimeStamp).GetTotalDays() > PAK_INDEX_CACHE_MAX_AGE_DAYS)
+		{
+			FileManager.Delete(*CacheFilePath, false, true, true);
+		}
+		else
+		{
+			CacheFileTimes.Emplace(TimeStamp, CacheFilePath);
+		}
+	}
+
+	// Kept caches use part of the limit, the rest goes to the newest other caches
+	const int32 OtherFileCount = MaxFileCount - KeepCacheFiles.Num();
+	if (CacheFileTimes.Num() <= OtherFileCount)
+	{
+		return;
+	}
+
+	// Newest first, everything past the limit is deleted
+	CacheFileTimes.Sort([](const TPair<FDateTime, FString>& A, const TPair<FDateTime, FString>& B) { return A.Key > B.Key; });
+	for (int32 i = OtherFileCount; i < CacheFileTimes.Num(); ++i)
+	{
+		FileManager.Delete(*CacheFileTimes[i].Value, false, true, true);
+	}
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Pruned %d pak index cache files."), CacheFileTimes.Num() - OtherFileCount);
+}
+
+FSHAHash FPakIndexCache::HashKey(const FAES::FAESKey& InKey)
+{
+	FSHAHash KeyHash;
+	if (InKey.IsValid())
+	{
+		FSHA1::HashBuffer(InKey.Key, FAES::FAESKey::KeySize, KeyHash.Hash);
+	}
+
+	return KeyHash;
+}
+
+FString FPakIndexCache::GetCacheDir()
+{
+	return FPaths::ProjectSavedDir() / TEXT("PakIndexCache");
+}
+
+FString FPakIndexCache::GetCachePath(const FString& InPakPath)
+{
+	const FString PathHash = FMD5::HashAnsiString(*FPaths::ConvertRelativePathToFull(InPakPath).ToLower());
+	return GetCacheDir() / FString::Printf(TEXT("%s_%s.bin"), *FPaths::GetBaseFilename(InPakPath), *PathHash);
+}
+
+FSHAHash FPakIndexCache::HashPakInfo(const FPakInfo& InPakInfo)
+{
+	FSHA1 HashState;
+	HashState.Update((const uint8*)&InPakInfo.Magic, sizeof(InPakInfo.Magic));
+	HashState.Update((const uint8*)&InPakInfo.Version, sizeof(InPakInfo.Version));
+	HashState.Update((const uint8*)&InPakInfo.IndexOffset, sizeof(InPakInfo.IndexOffset));
+	HashState.Update((const uint8*)&InPakInfo.IndexSize, sizeof(InPakInfo.IndexSize));
+	HashState.Update(InPakInfo.IndexHash.Hash, sizeof(InPakInfo.IndexHash.Hash));
+	HashState.Update((const uint8*)&InPakInfo.EncryptionKeyGuid, sizeof(InPakInfo.EncryptionKeyGuid));
+	HashState.Final();
+
+	FSHAHash Hash;
+	HashState.GetHash(Hash.Hash);
+	return Hash;
+}
+
+void FPakIndexCache::SerializeRecord(FArchive& Ar, FPakIndexRecord& Record)
+{
+	FPakEntry& Entry = Record.Entry;
+
+	Ar << Record.Filename;
+	Ar << Entry.Offset;
+	Ar << Entry.Size;
+	Ar << Entry.UncompressedSize;
+	Ar << Entry.CompressionMethodIndex;
+	Ar.Serialize(Entry.Hash, sizeof(Entry.Hash));
+	Ar << Entry.CompressionBlocks;
+	Ar << Entry.Flags;
+	Ar << Entry.CompressionBlockSize;
+}
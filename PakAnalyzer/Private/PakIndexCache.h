@@ -0,0 +1,48 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "IPlatformFilePak.h"
+#include "Misc/AES.h"
+#include "Misc/SecureHash.h"
+
+struct FPakIndexRecord
+{
+	FString Filename;
+	FPakEntry Entry;
+};
+
+struct FPakIndexCacheData
+{
+	FString MountPoint;
+	FSHAHash KeyHash;
+	TArray<FPakIndexRecord> Records;
+};
+
+/**
+ * On disk cache of pak index records under Saved/PakIndexCache.
+ * A cache file is only valid for the same pak path, size, timestamp and footer.
+ * Paks with an encrypted index are never cached, the records would be stored in plain text.
+ */
+class FPakIndexCache
+{
+public:
+	static bool Load(const FString& InPakPath, const FPakInfo& InPakInfo, FPakIndexCacheData& OutData);
+	static bool Save(const FString& InPakPath, const FPakInfo& InPakInfo, const FPakIndexCacheData& InData);
+
+	/**
+	 * Deletes cache files older than a month and the oldest ones above the file count limit.
+	 * Caches of InKeepPakPaths are never deleted and the limit grows to hold all of them.
+	 * Call it once per load after every Save finished, it is not safe to run beside Save.
+	 */
+	static void Prune(const TArray<FString>& InKeepPakPaths);
+
+	static FSHAHash HashKey(const FAES::FAESKey& InKey);
+
+protected:
+	static FString GetCacheDir();
+	static FString GetCachePath(const FString& InPakPath);
+	static FSHAHash HashPakInfo(const FPakInfo& InPakInfo);
+	static void SerializeRecord(FArchive& Ar, FPakIndexRecord& Record);
+};
@@ -0,0 +1,96 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "PakTreeArena.h"
+
+FPakTreeArena::~FPakTreeArena()
+{
+	ForEachNode([](FPakTreeEntry& Node)
+		{
+			Node.~FPakTreeEntry();
+		});
+
+	for (FPakTreeEntry* Block : NodeBlocks)
+	{
+		FMemory::Free(Block);
+	}
+
+	for (const FPathBlock& Block : PathBlocks)
+	{
+		FMemory::Free(Block.Data);
+	}
+}
+
+FPakTreeEntryPtr FPakTreeArena::NewNode(FName InFilename, const TCHAR* InPath, int32 InLength, bool bInIsDirectory)
+{
+	if (NodeCount == NodeBlocks.Num() * NodesPerBlock)
+	{
+		NodeBlocks.Add((FPakTreeEntry*)FMemory::Malloc(NodesPerBlock * sizeof(FPakTreeEntry), alignof(FPakTreeEntry)));
+	}
+
+	FPakTreeEntry* Node = NodeBlocks.Last() + NodeCount % NodesPerBlock;
+	new (Node) FPakTreeEntry(InFilename, FPakPath::MakeView(AllocatePath(InPath, InLength), InLength), bInIsDirectory);
+	++NodeCount;
+
+	return FPakTreeEntryPtr(AsShared(), Node);
+}
+
+void FPakTreeArena::Release()
+{
+	ForEachNode([](FPakTreeEntry& Node)
+		{
+			if (Node.bIsDirectory)
+			{
+				Node.GetMutableChildrenMap().Empty();
+			}
+		});
+}
+
+SIZE_T FPakTreeArena::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = NodeBlocks.GetAllocatedSize() + PathBlocks.GetAllocatedSize() + (SIZE_T)NodeBlocks.Num() * NodesPerBlock * sizeof(FPakTreeEntry);
+	for (const FPathBlock& Block : PathBlocks)
+	{
+		AllocatedSize += Block.Capacity * sizeof(TCHAR);
+	}
+	return AllocatedSize;
+}
+
+SIZE_T FPakTreeArena::GetNodeAllocatedSize() const
+{
+	SIZE_T AllocatedSize = 0;
+	ForEachNode([&AllocatedSize](const FPakTreeEntry& Node)
+		{
+			AllocatedSize += Node.GetAllocatedSize();
+		});
+	return AllocatedSize;
+}
+
+const TCHAR* FPakTreeArena::AllocatePath(const TCHAR* InPath, int32 InLength)
+{
+	const int32 Required = InLength + 1;
+
+	TCHAR* Path = nullptr;
+	if (Required > PathCharsPerBlock)
+	{
+		// Too long to share a block, keep it alone and start a new shared block for the next path
+		Path = (TCHAR*)FMemory::Malloc(Required * sizeof(TCHAR));
+		PathBlocks.Add({ Path, Required });
+		PathBlockUsed = Required;
+	}
+	else
+	{
+		if (PathBlocks.Num() == 0 || PathBlockUsed + Required > PathBlocks.Last().Capacity)
+		{
+			PathBlocks.Add({ (TCHAR*)FMemory::Malloc(PathCharsPerBlock * sizeof(TCHAR)), PathCharsPerBlock });
+			PathBlockUsed = 0;
+		}
+
+		Path = PathBlocks.Last().Data + PathBlockUsed;
+		PathBlockUsed += Required;
+	}
+
+	FMemory::Memcpy(Path, InPath, InLength * sizeof(TCHAR));
+	Path[InLength] = TEXT('\0');
+
+	return Path;
+}
@@ -0,0 +1,64 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "PakFileEntry.h"
+
+/**
+ * Owns every node and path of one pak tree in a few large blocks instead of one allocation per node and path.
+ * Nodes share the reference count of the arena, so a node handed out keeps the whole arena alive.
+ * Directory nodes reference their children, so the arena references itself until Release empties them.
+ * The tree root owns the arena and calls Release from ReleaseTree or when it is destroyed.
+ */
+class FPakTreeArena : public TSharedFromThis<FPakTreeArena>
+{
+public:
+	FPakTreeArena() {}
+	~FPakTreeArena();
+
+	FPakTreeArena(const FPakTreeArena&) = delete;
+	FPakTreeArena& operator=(const FPakTreeArena&) = delete;
+
+	/** Copies the first InLength characters of InPath into the path pool. */
+	FPakTreeEntryPtr NewNode(FName InFilename, const TCHAR* InPath, int32 InLength, bool bInIsDirectory);
+
+	/** Empties the children of every directory node. */
+	void Release();
+
+	int32 GetNodeCount() const { return NodeCount; }
+	int32 GetBlockCount() const { return NodeBlocks.Num() + PathBlocks.Num(); }
+	/** Bytes of all node and path blocks. */
+	SIZE_T GetAllocatedSize() const;
+	/** Heap memory owned by nodes outside of the arena, directory maps and compression blocks. */
+	SIZE_T GetNodeAllocatedSize() const;
+
+protected:
+	const TCHAR* AllocatePath(const TCHAR* InPath, int32 InLength);
+
+	template <typename FunctionType>
+	void ForEachNode(FunctionType Function) const
+	{
+		for (int32 i = 0; i < NodeCount; ++i)
+		{
+			Function(NodeBlocks[i / NodesPerBlock][i % NodesPerBlock]);
+		}
+	}
+
+protected:
+	static const int32 NodesPerBlock = 1024;
+	static const int32 PathCharsPerBlock = 64 * 1024;
+
+	TArray<FPakTreeEntry*> NodeBlocks;
+	int32 NodeCount = 0;
+
+	struct FPathBlock
+	{
+		TCHAR* Data;
+		int32 Capacity;
+	};
+
+	TArray<FPathBlock> PathBlocks;
+	int32 PathBlockUsed = 0;
+};
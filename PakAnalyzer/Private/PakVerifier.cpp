@@ -0,0 +1,271 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "PakVerifier.h"
+
+#include "Async/ParallelFor.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformTime.h"
+#include "IPlatformFilePak.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+
+#include "ExtractThreadWorker.h"
+
+FPakVerifier::FPakVerifier(const TArray<FPakFileSumary>& InSummaries, const FThreadSafeBool& InStopFlag)
+	: Summaries(InSummaries)
+	, bStop(InStopFlag)
+{
+
+}
+
+void FPakVerifier::Verify(const TArray<FPakFileEntry>& InFiles, FVerifyResult& OutResult)
+{
+	// Every batch is read sequentially by one task
+	static const int32 BatchFileCount = 256;
+	static const int64 BatchSize = 64 * 1024 * 1024;
+
+	const double StartTime = FPlatformTime::Seconds();
+	OutResult.TotalCount = InFiles.Num();
+
+	TArray<TPair<int32, int32>> Batches;
+	int32 BatchBegin = 0;
+	int64 BatchBytes = 0;
+	for (int32 i = 0; i < InFiles.Num(); ++i)
+	{
+		if (i > BatchBegin && (i - BatchBegin >= BatchFileCount || BatchBytes >= BatchSize || InFiles[i].OwnerPakIndex != InFiles[BatchBegin].OwnerPakIndex))
+		{
+			Batches.Emplace(BatchBegin, i);
+			BatchBegin = i;
+			BatchBytes = 0;
+		}
+		BatchBytes += InFiles[i].PakEntry.Size;
+	}
+	if (BatchBegin < InFiles.Num())
+	{
+		Batches.Emplace(BatchBegin, InFiles.Num());
+	}
+
+	TAtomic<int32> VerifiedCount{ 0 };
+	TAtomic<int64> VerifiedBytes{ 0 };
+	ParallelFor(Batches.Num(), [this, &InFiles, &Batches, &VerifiedCount, &VerifiedBytes, &OutResult](int32 BatchIndex)
+		{
+			if (bStop)
+			{
+				return;
+			}
+
+			const TPair<int32, int32>& Batch = Batches[BatchIndex];
+			const int32 PakIndex = InFiles[Batch.Key].OwnerPakIndex;
+			TUniquePtr<FArchive> Reader(Summaries.IsValidIndex(PakIndex) ? IFileManager::Get().CreateFileReader(*Summaries[PakIndex].PakFilePath) : nullptr);
+
+			TArray<uint8> Data;
+			TArray<uint8> Scratch;
+			for (int32 i = Batch.Key; i < Batch.Value && !bStop; ++i)
+			{
+				const FPakFileEntry& File = InFiles[i];
+
+				FVerifyFailure Failure;
+				Failure.Path = File.Path.ToString();
+				Failure.PakName = Summaries.IsValidIndex(PakIndex) ? FPaths::GetCleanFilename(Summaries[PakIndex].PakFilePath) : FString();
+				Failure.Offset = File.PakEntry.Offset;
+
+				if (!Reader)
+				{
+					Failure.Reason = TEXT("Open pak failed");
+				}
+				else if (VerifyEntry(*Reader, File, Data, Scratch, Failure))
+				{
+					VerifiedCount.IncrementExchange();
+					VerifiedBytes.AddExchange(File.PakEntry.Size);
+					continue;
+				}
+
+				AddFailure(OutResult, Failure);
+			}
+		}, EParallelForFlags::Unbalanced);
+
+	OutResult.VerifiedCount = VerifiedCount;
+	OutResult.VerifiedBytes = VerifiedBytes;
+
+	TSet<int32> PakIndices;
+	for (const FPakFileEntry& File : InFiles)
+	{
+		PakIndices.Add(File.OwnerPakIndex);
+	}
+
+	for (int32 PakIndex : PakIndices)
+	{
+		if (!bStop && Summaries.IsValidIndex(PakIndex))
+		{
+			VerifySignature(PakIndex, OutResult);
+		}
+	}
+
+	OutResult.Seconds = FPlatformTime::Seconds() - StartTime;
+	OutResult.bCancelled = bStop;
+}
+
+bool FPakVerifier::VerifyEntry(FArchive& InReader, const FPakFileEntry& InFile, TArray<uint8>& InOutData, TArray<uint8>& InOutScratch, FVerifyFailure& OutFailure) const
+{
+	const FPakFileSumary& Summary = Summaries[InFile.OwnerPakIndex];
+	const FPakEntry& Entry = InFile.PakEntry;
+
+	InReader.Seek(Entry.Offset);
+
+	FPakEntry EntryInfo;
+	EntryInfo.Serialize(InReader, Summary.PakInfo.Version);
+	if (InReader.IsError() || !(Entry == EntryInfo))
+	{
+		OutFailure.Reason = TEXT("Entry header mismatch");
+		return false;
+	}
+
+	const int64 PayloadOffset = InReader.Tell();
+	const int64 SizeToRead = Entry.IsEncrypted() ? Align(Entry.Size, FAES::AESBlockSize) : Entry.Size;
+	InOutData.SetNumUninitialized(SizeToRead, EAllowShrinking::No);
+	InReader.Serialize(InOutData.GetData(), SizeToRead);
+	if (InReader.IsError())
+	{
+		OutFailure.BlockOffset = PayloadOffset;
+		OutFailure.Reason = TEXT("Read failed");
+		return false;
+	}
+
+	// The entry hash covers the payload as stored, entries without a hash are only decoded
+	bool bHashMatch = true;
+	FSHAHash ExpectedHash;
+	FMemory::Memcpy(ExpectedHash.Hash, Entry.Hash, sizeof(ExpectedHash.Hash));
+	if (ExpectedHash != FSHAHash())
+	{
+		FSHAHash ActualHash;
+		FSHA1::HashBuffer(InOutData.GetData(), Entry.Size, ActualHash.Hash);
+		bHashMatch = ActualHash == ExpectedHash;
+	}
+
+	if (Entry.CompressionMethodIndex != 0)
+	{
+		if (Entry.CompressionBlockSize == 0 || Entry.CompressionBlocks.Num() <= 0)
+		{
+			OutFailure.Reason = TEXT("Invalid compression blocks");
+			return false;
+		}
+
+		const int64 BaseOffset = Summary.PakInfo.Version >= FPakInfo::PakFile_Version_RelativeChunkOffsets ? Entry.Offset : 0;
+		InOutScratch.SetNumUninitialized(Entry.CompressionBlockSize, EAllowShrinking::No);
+
+		// Blocks are decrypted in place, so this runs after hashing
+		for (int32 BlockIndex = 0; BlockIndex < Entry.CompressionBlocks.Num(); ++BlockIndex)
+		{
+			const FPakCompressedBlock& Block = Entry.CompressionBlocks[BlockIndex];
+			const int64 BlockStart = Block.CompressedStart + BaseOffset - PayloadOffset;
+			const int64 BlockSize = Block.CompressedEnd - Block.CompressedStart;
+			const int64 ReadBlockSize = Entry.IsEncrypted() ? Align(BlockSize, FAES::AESBlockSize) : BlockSize;
+
+			const bool bInRange = BlockStart >= 0 && BlockSize >= 0 && BlockStart + ReadBlockSize <= InOutData.Num();
+			if (!bInRange || !FExtractThreadWorker::DecodeBlock(Entry, BlockIndex, InOutData.GetData() + BlockStart, InOutScratch.GetData(), Summary.DecryptAESKey, InFile.CompressionMethod))
+			{
+				OutFailure.BlockIndex = BlockIndex;
+				OutFailure.BlockOffset = Block.CompressedStart + BaseOffset;
+				OutFailure.Reason = !bInRange ? TEXT("Block out of range") : bHashMatch ? TEXT("Decompress failed") : TEXT("Hash mismatch, decompress failed");
+				return false;
+			}
+		}
+	}
+
+	if (!bHashMatch)
+	{
+		OutFailure.BlockOffset = PayloadOffset;
+		OutFailure.Reason = TEXT("Hash mismatch");
+		return false;
+	}
+
+	return true;
+}
+
+void FPakVerifier::VerifySignature(int32 InPakIndex, FVerifyResult& OutResult)
+{
+	// Chunks hashed per task, every task reads its range sequentially
+	static const int32 TaskChunkCount = 256;
+
+	const FPakFileSumary& Summary = Summaries[InPakIndex];
+	const FString PakName = FPaths::GetCleanFilename(Summary.PakFilePath);
+	const FString SignaturePath = FPaths::ChangeExtension(Summary.PakFilePath, TEXT("sig"));
+
+	TUniquePtr<FArchive> SignatureReader(IFileManager::Get().CreateFileReader(*SignaturePath));
+	if (!SignatureReader)
+	{
+		return;
+	}
+
+	FVerifyFailure SignatureFailure;
+	SignatureFailure.Path = PakName;
+	SignatureFailure.PakName = PakName;
+
+	// Only the chunk table is checked, validating its RSA signature needs the public key of the project
+	FPakSignatureFile Signature;
+	Signature.Serialize(*SignatureReader);
+	if (SignatureReader->IsError() || Signature.ChunkHashes.Num() <= 0)
+	{
+		SignatureFailure.Reason = TEXT("Invalid signature file");
+		AddFailure(OutResult, SignatureFailure);
+		return;
+	}
+
+	const int64 PakSize = IFileManager::Get().FileSize(*Summary.PakFilePath);
+	const int64 ChunkSize = FPakInfo::MaxChunkDataSize;
+	const int32 ChunkCount = (int32)((PakSize + ChunkSize - 1) / ChunkSize);
+	if (ChunkCount != Signature.ChunkHashes.Num())
+	{
+		SignatureFailure.Reason = FString::Printf(TEXT("Signature chunk count mismatch, %d chunks signed, %d chunks in pak"), Signature.ChunkHashes.Num(), ChunkCount);
+		AddFailure(OutResult, SignatureFailure);
+		return;
+	}
+
+	TAtomic<int64> VerifiedBytes{ 0 };
+	const int32 TaskCount = (ChunkCount + TaskChunkCount - 1) / TaskChunkCount;
+	ParallelFor(TaskCount, [&](int32 TaskIndex)
+		{
+			TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*Summary.PakFilePath));
+			TArray<uint8> Buffer;
+			Buffer.SetNumUninitialized(ChunkSize);
+
+			const int32 ChunkEnd = FMath::Min((TaskIndex + 1) * TaskChunkCount, ChunkCount);
+			for (int32 ChunkIndex = TaskIndex * TaskChunkCount; ChunkIndex < ChunkEnd && !bStop; ++ChunkIndex)
+			{
+				const int64 ChunkOffset = ChunkIndex * ChunkSize;
+				const int64 Size = FMath::Min(ChunkSize, PakSize - ChunkOffset);
+
+				bool bMatch = false;
+				if (Reader)
+				{
+					Reader->Seek(ChunkOffset);
+					Reader->Serialize(Buffer.GetData(), Size);
+					bMatch = !Reader->IsError() && ComputePakChunkHash(Buffer.GetData(), Size) == Signature.ChunkHashes[ChunkIndex];
+					VerifiedBytes.AddExchange(Size);
+				}
+
+				if (!bMatch)
+				{
+					FVerifyFailure Failure;
+					Failure.Path = PakName;
+					Failure.PakName = PakName;
+					Failure.Offset = ChunkOffset;
+					Failure.BlockIndex = ChunkIndex;
+					Failure.BlockOffset = ChunkOffset;
+					Failure.Reason = TEXT("Signed chunk hash mismatch");
+					AddFailure(OutResult, Failure);
+				}
+			}
+		}, EParallelForFlags::Unbalanced);
+
+	OutResult.VerifiedBytes += VerifiedBytes;
+}
+
+void FPakVerifier::AddFailure(FVerifyResult& OutResult, FVerifyFailure& InFailure)
+{
+	UE_LOG(LogPakAnalyzer, Error, TEXT("Verify failed! %s, pak: %s, offset: %lld, block: %d, block offset: %lld, file: %s"), *InFailure.Reason, *InFailure.PakName, InFailure.Offset, InFailure.BlockIndex, InFailure.BlockOffset, *InFailure.Path);
+
+	FScopeLock Lock(&CriticalSection);
+	OutResult.Failures.Add(MoveTemp(InFailure));
+}
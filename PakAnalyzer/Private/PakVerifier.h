@@ -0,0 +1,35 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+
+#include "CommonDefines.h"
+#include "PakFileEntry.h"
+
+/**
+ * Checks pak entries without extracting them.
+ * The stored payload of every entry is hashed like UnrealPak -Test does, then every compression block is decrypted and decompressed.
+ * Paks with a .sig file also get their signed chunk hashes checked.
+ */
+class FPakVerifier
+{
+public:
+	FPakVerifier(const TArray<FPakFileSumary>& InSummaries, const FThreadSafeBool& InStopFlag);
+
+	/** Files must be ordered by pak and offset, they are verified in parallel batches read sequentially. */
+	void Verify(const TArray<FPakFileEntry>& InFiles, FVerifyResult& OutResult);
+
+protected:
+	bool VerifyEntry(FArchive& InReader, const FPakFileEntry& InFile, TArray<uint8>& InOutData, TArray<uint8>& InOutScratch, FVerifyFailure& OutFailure) const;
+	void VerifySignature(int32 InPakIndex, FVerifyResult& OutResult);
+
+	void AddFailure(FVerifyResult& OutResult, FVerifyFailure& InFailure);
+
+protected:
+	const TArray<FPakFileSumary>& Summaries;
+	const FThreadSafeBool& bStop;
+
+	FCriticalSection CriticalSection;
+};
@@ -0,0 +1,199 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "PathTrigramIndex.h"
+
+#include "Algo/Sort.h"
+#include "Algo/Unique.h"
+#include "HAL/PlatformTime.h"
+
+#include "CommonDefines.h"
+
+FPathTrigramIndex::FPathTrigramIndex(uint32 InFileListSerial)
+	: FileListSerial(InFileListSerial)
+{
+
+}
+
+bool FPathTrigramIndex::Build(const TArray<FPakFileEntryPtr>& InFiles, const TAtomic<bool>& bInCancel)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	TArray<uint64> Keys;
+	for (int32 i = 0; i < InFiles.Num(); ++i)
+	{
+		if ((i & 4095) == 0 && bInCancel.Load(EMemoryOrder::Relaxed))
+		{
+			UE_LOG(LogPakAnalyzer, Log, TEXT("Build path trigram index cancelled."));
+			return false;
+		}
+
+		const FPakPath& Path = InFiles[i]->Path;
+		GetTrigramKeys(*Path, Path.Len(), Keys);
+
+		for (const uint64 Key : Keys)
+		{
+			FPostingList& List = Postings.FindOrAdd(Key);
+			AppendVarInt(List.Bytes, (uint32)(i - List.LastIndex));
+			List.LastIndex = i;
+			++List.Count;
+		}
+	}
+
+	for (auto& Pair : Postings)
+	{
+		Pair.Value.Bytes.Shrink();
+	}
+	Postings.Shrink();
+
+	UE_LOG(LogPakAnalyzer, Log, TEXT("Build path trigram index: %d files, %d trigrams, %.2f MB in %.3fs."),
+		InFiles.Num(), Postings.Num(), GetAllocatedSize() / 1024.f / 1024.f, FPlatformTime::Seconds() - StartTime);
+
+	return true;
+}
+
+bool FPathTrigramIndex::FindCandidates(const FString& InQuery, TArray<int32>& OutCandidates) const
+{
+	OutCandidates.Reset();
+
+	if (InQuery.Len() < 3)
+	{
+		return false;
+	}
+
+	// Case folding of other characters may not match the case insensitive compare used for verification
+	for (const TCHAR Char : InQuery)
+	{
+		if (!FChar::IsAscii(Char))
+		{
+			return false;
+		}
+	}
+
+	TArray<uint64> Keys;
+	GetTrigramKeys(*InQuery, InQuery.Len(), Keys);
+
+	TArray<const FPostingList*> Lists;
+	for (const uint64 Key : Keys)
+	{
+		const FPostingList* List = Postings.Find(Key);
+		if (!List)
+		{
+			// No path contains this trigram
+			return true;
+		}
+
+		Lists.Add(List);
+	}
+
+	Algo::Sort(Lists, [](const FPostingList* A, const FPostingList* B) { return A->Count < B->Count; });
+
+	DecodePostingList(*Lists[0], OutCandidates);
+	for (int32 i = 1; i < Lists.Num() && OutCandidates.Num() > 0; ++i)
+	{
+		IntersectPostingList(*Lists[i], OutCandidates);
+	}
+
+	return true;
+}
+
+SIZE_T FPathTrigramIndex::GetAllocatedSize() const
+{
+	SIZE_T AllocatedSize = Postings.GetAllocatedSize();
+	for (const auto& Pair : Postings)
+	{
+		AllocatedSize += Pair.Value.Bytes.GetAllocatedSize();
+	}
+
+	return AllocatedSize;
+}
+
+uint64 FPathTrigramIndex::MakeKey(TCHAR A, TCHAR B, TCHAR C)
+{
+	static const uint64 CharMask = (1 << 21) - 1;
+	return ((uint64(FChar::ToLower(A)) & CharMask) << 42) | ((uint64(FChar::ToLower(B)) & CharMask) << 21) | (uint64(FChar::ToLower(C)) & CharMask);
+}
+
+void FPathTrigramIndex::GetTrigramKeys(const TCHAR* InText, int32 InLen, TArray<uint64>& OutKeys)
+{
+	OutKeys.Reset();
+	for (int32 i = 0; i + 2 < InLen; ++i)
+	{
+		OutKeys.Add(MakeKey(InText[i], InText[i + 1], InText[i + 2]));
+	}
+
+	Algo::Sort(OutKeys);
+	OutKeys.SetNum(Algo::Unique(OutKeys));
+}
+
+void FPathTrigramIndex::AppendVarInt(TArray<uint8>& OutBytes, uint32 InValue)
+{
+	while (InValue >= 0x80)
+	{
+		OutBytes.Add((uint8)(InValue | 0x80));
+		InValue >>= 7;
+	}
+	OutBytes.Add((uint8)InValue);
+}
+
+void FPathTrigramIndex::DecodePostingList(const FPostingList& InList, TArray<int32>& OutIndices)
+{
+	OutIndices.Reset(InList.Count);
+
+	const uint8* Data = InList.Bytes.GetData();
+	const uint8* End = Data + InList.Bytes.Num();
+
+	int32 Index = -1;
+	while (Data < End)
+	{
+		uint32 Delta = 0;
+		uint32 Shift = 0;
+		uint8 Byte = 0;
+		do
+		{
+			Byte = *Data++;
+			Delta |= uint32(Byte & 0x7F) << Shift;
+			Shift += 7;
+		} while ((Byte & 0x80) && Data < End);
+
+		Index += Delta;
+		OutIndices.Add(Index);
+	}
+}
+
+void FPathTrigramIndex::IntersectPostingList(const FPostingList& InList, TArray<int32>& InOutIndices)
+{
+	const uint8* Data = InList.Bytes.GetData();
+	const uint8* End = Data + InList.Bytes.Num();
+
+	int32 Index = -1;
+	int32 ReadPos = 0;
+	int32 WritePos = 0;
+
+	while (Data < End && ReadPos < InOutIndices.Num())
+	{
+		uint32 Delta = 0;
+		uint32 Shift = 0;
+		uint8 Byte = 0;
+		do
+		{
+			Byte = *Data++;
+			Delta |= uint32(Byte & 0x7F) << Shift;
+			Shift += 7;
+		} while ((Byte & 0x80) && Data < End);
+
+		Index += Delta;
+
+		while (ReadPos < InOutIndices.Num() && InOutIndices[ReadPos] < Index)
+		{
+			++ReadPos;
+		}
+
+		if (ReadPos < InOutIndices.Num() && InOutIndices[ReadPos] == Index)
+		{
+			InOutIndices[WritePos++] = Index;
+			++ReadPos;
+		}
+	}
+
+	InOutIndices.SetNum(WritePos);
+}
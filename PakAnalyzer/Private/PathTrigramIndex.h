@@ -0,0 +1,45 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Atomic.h"
+
+#include "PakFileEntry.h"
+
+/**
+ * Trigram posting lists over lower-cased file paths.
+ * Posting lists hold ascending file indices as delta encoded var ints.
+ */
+class FPathTrigramIndex
+{
+public:
+	FPathTrigramIndex(uint32 InFileListSerial);
+
+	/** Builds posting lists for all file paths, returns false when cancelled. */
+	bool Build(const TArray<FPakFileEntryPtr>& InFiles, const TAtomic<bool>& bInCancel);
+
+	/** Finds sorted indices of files which may contain the query, returns false when the query can't use the index. */
+	bool FindCandidates(const FString& InQuery, TArray<int32>& OutCandidates) const;
+
+	uint32 GetFileListSerial() const { return FileListSerial; }
+	SIZE_T GetAllocatedSize() const;
+
+protected:
+	struct FPostingList
+	{
+		TArray<uint8> Bytes;
+		int32 Count = 0;
+		int32 LastIndex = -1;
+	};
+
+	static uint64 MakeKey(TCHAR A, TCHAR B, TCHAR C);
+	static void GetTrigramKeys(const TCHAR* InText, int32 InLen, TArray<uint64>& OutKeys);
+	static void AppendVarInt(TArray<uint8>& OutBytes, uint32 InValue);
+	static void DecodePostingList(const FPostingList& InList, TArray<int32>& OutIndices);
+	static void IntersectPostingList(const FPostingList& InList, TArray<int32>& InOutIndices);
+
+protected:
+	uint32 FileListSerial;
+	TMap<uint64, FPostingList> Postings;
+};
@@ -0,0 +1,235 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#include "TarWriter.h"
+
+#include "HAL/FileManager.h"
+#include "Misc/DateTime.h"
+#include "Misc/Paths.h"
+
+#include "CommonDefines.h"
+
+static const int64 TAR_BLOCK_SIZE = 512;
+static const int32 TAR_NAME_SIZE = 100;
+
+namespace TarWriter
+{
+	struct FHeader
+	{
+		char Name[100];
+		char Mode[8];
+		char Uid[8];
+		char Gid[8];
+		char Size[12];
+		char MTime[12];
+		char Checksum[8];
+		char TypeFlag;
+		char LinkName[100];
+		char Magic[8];
+		char UserName[32];
+		char GroupName[32];
+		char DevMajor[8];
+		char DevMinor[8];
+		char Prefix[155];
+		char Padding[12];
+	};
+	static_assert(sizeof(FHeader) == TAR_BLOCK_SIZE, "Tar header must be one block");
+
+	static void WriteOctal(char* OutField, int32 InFieldSize, int64 InValue)
+	{
+		// Octal digits followed by a terminator, values too large for the field use the GNU base-256 encoding
+		const int32 DigitCount = InFieldSize - 1;
+		if (InValue >= 0 && InValue < (1ll << (3 * DigitCount)))
+		{
+			for (int32 i = DigitCount - 1; i >= 0; --i)
+			{
+				OutField[i] = '0' + (InValue & 7);
+				InValue >>= 3;
+			}
+			OutField[DigitCount] = '\0';
+		}
+		else
+		{
+			for (int32 i = InFieldSize - 1; i > 0; --i)
+			{
+				OutField[i] = (char)(InValue & 0xff);
+				InValue >>= 8;
+			}
+			OutField[0] = (char)0x80;
+		}
+	}
+
+	static void CopyName(char* OutField, int32 InFieldSize, const FTCHARToUTF8& InName)
+	{
+		FMemory::Memcpy(OutField, InName.Get(), FMath::Min(InName.Length(), InFieldSize));
+	}
+}
+
+FTarWriter::~FTarWriter()
+{
+	Close(false);
+}
+
+bool FTarWriter::Open(const FString& InArchivePath)
+{
+	Writer.Reset(IFileManager::Get().CreateFileWriter(*InArchivePath));
+	if (!Writer)
+	{
+		UE_LOG(LogPakAnalyzer, Error, TEXT("Open archive to write failed! Archive: %s"), *InArchivePath);
+		return false;
+	}
+
+	UnixTime = FDateTime::UtcNow().ToUnixTimestamp();
+	return true;
+}
+
+void FTarWriter::BeginFile(const FString& InPath, int64 InSize)
+{
+	FileSize = InSize;
+	WriteHeader(MakeEntryName(InPath), FString(), '0', InSize);
+}
+
+void FTarWriter::Write(const uint8* InData, int64 InSize)
+{
+	if (Writer && InSize > 0)
+	{
+		Writer->Serialize((void*)InData, InSize);
+	}
+}
+
+void FTarWriter::WriteZeros(int64 InSize)
+{
+	static const uint8 Zeros[TAR_BLOCK_SIZE] = { 0 };
+
+	while (Writer && InSize > 0)
+	{
+		const int64 Size = FMath::Min(InSize, TAR_BLOCK_SIZE);
+		Writer->Serialize((void*)Zeros, Size);
+		InSize -= Size;
+	}
+}
+
+void FTarWriter::EndFile()
+{
+	WritePadding(FileSize);
+	FileSize = 0;
+}
+
+void FTarWriter::AddHardLink(const FString& InPath, const FString& InTargetPath)
+{
+	WriteHeader(MakeEntryName(InPath), MakeEntryName(InTargetPath), '1', 0);
+}
+
+bool FTarWriter::Close(bool bInFinalize)
+{
+	if (!Writer)
+	{
+		return false;
+	}
+
+	if (bInFinalize)
+	{
+		WriteZeros(TAR_BLOCK_SIZE * 2);
+	}
+
+	const bool bSuccess = Writer->Close();
+	Writer.Reset();
+
+	return bSuccess;
+}
+
+bool FTarWriter::IsError() const
+{
+	return !Writer || Writer->IsError();
+}
+
+FString FTarWriter::MakeEntryName(const FString& InPath)
+{
+	FString Name = InPath.Replace(TEXT("\\"), TEXT("/"));
+
+	// Resolves "Dir/../File", stops at a ".." which would climb above the first directory
+	FPaths::CollapseRelativeDirectories(Name);
+
+	// Whatever is left must not point outside the extraction directory
+	TArray<FString> Components;
+	Name.ParseIntoArray(Components, TEXT("/"), true);
+	Components.RemoveAll([](const FString& Component)
+		{
+			return Component == TEXT(".") || Component == TEXT("..");
+		});
+
+	if (Components.Num() > 0 && Components[0].EndsWith(TEXT(":")))
+	{
+		// Drive of an absolute windows path
+		Components.RemoveAt(0);
+	}
+
+	return FString::Join(Components, TEXT("/"));
+}
+
+void FTarWriter::WriteHeader(const FString& InName, const FString& InLinkName, char InTypeFlag, int64 InSize)
+{
+	if (!Writer)
+	{
+		return;
+	}
+
+	FTCHARToUTF8 Name(*InName);
+	FTCHARToUTF8 LinkName(*InLinkName);
+
+	// Names which do not fit the header are stored in a preceding GNU long name entry
+	if (Name.Length() >= TAR_NAME_SIZE)
+	{
+		WriteLongName(InName, 'L');
+	}
+	if (LinkName.Length() >= TAR_NAME_SIZE)
+	{
+		WriteLongName(InLinkName, 'K');
+	}
+
+	TarWriter::FHeader Header;
+	FMemory::Memzero(Header);
+
+	TarWriter::CopyName(Header.Name, TAR_NAME_SIZE - 1, Name);
+	TarWriter::CopyName(Header.LinkName, TAR_NAME_SIZE - 1, LinkName);
+	TarWriter::WriteOctal(Header.Mode, sizeof(Header.Mode), 0644);
+	TarWriter::WriteOctal(Header.Uid, sizeof(Header.Uid), 0);
+	TarWriter::WriteOctal(Header.Gid, sizeof(Header.Gid), 0);
+	TarWriter::WriteOctal(Header.Size, sizeof(Header.Size), InSize);
+	TarWriter::WriteOctal(Header.MTime, sizeof(Header.MTime), UnixTime);
+	Header.TypeFlag = InTypeFlag;
+	FMemory::Memcpy(Header.Magic, "ustar  ", 8);
+
+	// Checksum is computed with its own field filled with spaces
+	FMemory::Memset(Header.Checksum, ' ', sizeof(Header.Checksum));
+	uint32 Checksum = 0;
+	const uint8* HeaderBytes = (const uint8*)&Header;
+	for (int32 i = 0; i < sizeof(Header); ++i)
+	{
+		Checksum += HeaderBytes[i];
+	}
+	TarWriter::WriteOctal(Header.Checksum, 7, Checksum);
+	Header.Checksum[7] = ' ';
+
+	Writer->Serialize(&Header, sizeof(Header));
+}
+
+void FTarWriter::WriteLongName(const FString& InName, char InTypeFlag)
+{
+	FTCHARToUTF8 Name(*InName);
+
+	// Size includes the terminator
+	const int64 Size = Name.Length() + 1;
+	WriteHeader(TEXT("././@LongLink"), FString(), InTypeFlag, Size);
+	Write((const uint8*)Name.Get(), Name.Length());
+	WriteZeros(1);
+	WritePadding(Size);
+}
+
+void FTarWriter::WritePadding(int64 InSize)
+{
+	const int64 Remainder = InSize % TAR_BLOCK_SIZE;
+	if (Remainder > 0)
+	{
+		WriteZeros(TAR_BLOCK_SIZE - Remainder);
+	}
+}
@@ -0,0 +1,44 @@
+// Copyright 1998-2019 Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Sequential writer of an uncompressed tar archive (GNU format).
+ * Entries are streamed, the size of every file must be known when it begins.
+ */
+class FTarWriter
+{
+public:
+	~FTarWriter();
+
+	bool Open(const FString& InArchivePath);
+
+	/** Writes the header of a regular file, followed by exactly InSize bytes of Write/WriteZeros. */
+	void BeginFile(const FString& InPath, int64 InSize);
+	void Write(const uint8* InData, int64 InSize);
+	void WriteZeros(int64 InSize);
+	void EndFile();
+
+	/** Adds an entry sharing the content of an earlier file of the archive. */
+	void AddHardLink(const FString& InPath, const FString& InTargetPath);
+
+	/** Writes the end of archive marker when bInFinalize is set and closes the file. */
+	bool Close(bool bInFinalize);
+
+	bool IsError() const;
+
+protected:
+	/** Pak paths may hold relative mount points or ".." anywhere, archive names never leave the extraction directory. */
+	static FString MakeEntryName(const FString& InPath);
+
+	void WriteHeader(const FString& InName, const FString& InLinkName, char InTypeFlag, int64 InSize);
+	void WriteLongName(const FString& InName, char InTypeFlag);
+	void WritePadding(int64 InSize);
+
+protected:
+	TUniquePtr<FArchive> Writer;
+	int64 FileSize = 0;
+	int64 UnixTime = 0;
+};
@@ -2,16 +2,25 @@
 
 #include "UnrealAnalyzer.h"
 
+#include "CommonDefines.h"
+
 FUnrealAnalyzer::FUnrealAnalyzer()
 {
 	IoStoreAnalyzer = MakeShared<FIoStoreAnalyzer>();
 	PakAnalyzer = MakeShared<FPakAnalyzer>();
+
+	IoStoreAnalyzer->SetTrigramIndexEnabled(false);
+	PakAnalyzer->SetTrigramIndexEnabled(false);
 	
 	Reset();
+
+	FPakAnalyzerDelegates::OnAssetParseFinish.AddRaw(this, &FUnrealAnalyzer::OnAssetParseFinish);
 }
 
 FUnrealAnalyzer::~FUnrealAnalyzer()
 {
+	FPakAnalyzerDelegates::OnAssetParseFinish.RemoveAll(this);
+
 	Reset();
 
 	IoStoreAnalyzer.Reset();
@@ -20,6 +29,9 @@ FUnrealAnalyzer::~FUnrealAnalyzer()
 
 bool FUnrealAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<FString>& InDefaultAESKeys, int32 ContainerStartIndex)
 {
+	// Drop the previous file index before the inner analyzers load, it keeps every old arena alive
+	Reset();
+
 	bool bResult = true;
 
 	if (PakAnalyzer)
@@ -36,6 +48,8 @@ bool FUnrealAnalyzer::LoadPakFiles(const TArray<FString>& InPakPaths, const TArr
 		PakFileSummaries += IoStoreAnalyzer->GetPakFileSumary();
 	}
 
+	RefreshFileIndex();
+
 	FPakAnalyzerDelegates::OnPakLoadFinish.Broadcast();
 	
 	return bResult;
@@ -54,6 +68,42 @@ void FUnrealAnalyzer::ExtractFiles(const FString& InOutputPath, TArray<FPakFileE
 	}
 }
 
+bool FUnrealAnalyzer::ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles)
+{
+	// IoStore containers are indexed after the paks
+	const int32 PakCount = PakAnalyzer ? PakAnalyzer->GetPakFileSumary().Num() : 0;
+
+	bool bHasPakFiles = false;
+	bool bHasIoStoreFiles = false;
+	for (const FPakFileEntryPtr& File : InFiles)
+	{
+		if (File.IsValid())
+		{
+			bHasPakFiles |= File->OwnerPakIndex < PakCount;
+			bHasIoStoreFiles |= File->OwnerPakIndex >= PakCount;
+		}
+	}
+
+	// Every analyzer streams its own archive, both can not write into the same file
+	if (bHasPakFiles && bHasIoStoreFiles)
+	{
+		UE_LOG(LogPakAnalyzer, Warning, TEXT("Extract to archive refused, selection mixes pak and IoStore files: %s."), *InArchivePath);
+		return false;
+	}
+
+	if (bHasIoStoreFiles && IoStoreAnalyzer)
+	{
+		return IoStoreAnalyzer->ExtractFilesToArchive(InArchivePath, InFiles);
+	}
+
+	if (bHasPakFiles && PakAnalyzer)
+	{
+		return PakAnalyzer->ExtractFilesToArchive(InArchivePath, InFiles);
+	}
+
+	return true;
+}
+
 void FUnrealAnalyzer::CancelExtract()
 {
 	if (IoStoreAnalyzer)
@@ -67,6 +117,58 @@ void FUnrealAnalyzer::CancelExtract()
 	}
 }
 
+void FUnrealAnalyzer::VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles)
+{
+	CancelVerify();
+
+	// Results of an earlier verify still queued on the game thread carry an old generation
+	++VerifyGeneration;
+	PendingVerifyCount = (IoStoreAnalyzer ? 1 : 0) + (PakAnalyzer ? 1 : 0);
+	MergedVerifyResult = FVerifyResult();
+
+	const FPakAnalyzerDelegates::FOnVerifyFinish Handler = FPakAnalyzerDelegates::FOnVerifyFinish::CreateRaw(this, &FUnrealAnalyzer::OnInnerVerifyFinish, VerifyGeneration);
+
+	if (IoStoreAnalyzer)
+	{
+		IoStoreAnalyzer->SetVerifyFinishHandler(Handler);
+		IoStoreAnalyzer->VerifyFiles(InFiles);
+	}
+
+	if (PakAnalyzer)
+	{
+		PakAnalyzer->SetVerifyFinishHandler(Handler);
+		PakAnalyzer->VerifyFiles(InFiles);
+	}
+}
+
+void FUnrealAnalyzer::CancelVerify()
+{
+	if (IoStoreAnalyzer)
+	{
+		IoStoreAnalyzer->CancelVerify();
+	}
+
+	if (PakAnalyzer)
+	{
+		PakAnalyzer->CancelVerify();
+	}
+
+	PendingVerifyCount = 0;
+}
+
+void FUnrealAnalyzer::PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles)
+{
+	if (IoStoreAnalyzer)
+	{
+		IoStoreAnalyzer->PrioritizeAssetParse(InFiles);
+	}
+
+	if (PakAnalyzer)
+	{
+		PakAnalyzer->PrioritizeAssetParse(InFiles);
+	}
+}
+
 void FUnrealAnalyzer::SetExtractThreadCount(int32 InThreadCount)
 {
 	if (IoStoreAnalyzer)
@@ -80,6 +182,45 @@ void FUnrealAnalyzer::SetExtractThreadCount(int32 InThreadCount)
 	}
 }
 
+void FUnrealAnalyzer::SetExtractIOThreadCount(int32 InReadThreadCount, int32 InWriteThreadCount)
+{
+	if (IoStoreAnalyzer)
+	{
+		IoStoreAnalyzer->SetExtractIOThreadCount(InReadThreadCount, InWriteThreadCount);
+	}
+
+	if (PakAnalyzer)
+	{
+		PakAnalyzer->SetExtractIOThreadCount(InReadThreadCount, InWriteThreadCount);
+	}
+}
+
+void FUnrealAnalyzer::SetExtractMode(EExtractMode InMode)
+{
+	if (IoStoreAnalyzer)
+	{
+		IoStoreAnalyzer->SetExtractMode(InMode);
+	}
+
+	if (PakAnalyzer)
+	{
+		PakAnalyzer->SetExtractMode(InMode);
+	}
+}
+
+void FUnrealAnalyzer::SetExtractDeduplicate(bool bInDeduplicate)
+{
+	if (IoStoreAnalyzer)
+	{
+		IoStoreAnalyzer->SetExtractDeduplicate(bInDeduplicate);
+	}
+
+	if (PakAnalyzer)
+	{
+		PakAnalyzer->SetExtractDeduplicate(bInDeduplicate);
+	}
+}
+
 void FUnrealAnalyzer::Reset()
 {
 	if (IoStoreAnalyzer)
@@ -91,4 +232,33 @@ void FUnrealAnalyzer::Reset()
 	{
 		PakAnalyzer->Reset();
 	}
-}
\ No newline at end of file
+
+	// Wrapper keeps its own copies of roots and summaries and its own file index
+	FBaseAnalyzer::Reset();
+}
+
+void FUnrealAnalyzer::OnInnerVerifyFinish(const FVerifyResult& InResult, uint32 InGeneration)
+{
+	if (InGeneration != VerifyGeneration || PendingVerifyCount <= 0)
+	{
+		return;
+	}
+
+	MergedVerifyResult.TotalCount += InResult.TotalCount;
+	MergedVerifyResult.VerifiedCount += InResult.VerifiedCount;
+	MergedVerifyResult.VerifiedBytes += InResult.VerifiedBytes;
+	// Both analyzers verify at the same time
+	MergedVerifyResult.Seconds = FMath::Max(MergedVerifyResult.Seconds, InResult.Seconds);
+	MergedVerifyResult.Failures.Append(InResult.Failures);
+
+	if (--PendingVerifyCount <= 0 && MergedVerifyResult.TotalCount > 0)
+	{
+		FPakAnalyzerDelegates::OnVerifyFinish.ExecuteIfBound(MergedVerifyResult);
+	}
+}
+
+void FUnrealAnalyzer::OnAssetParseFinish()
+{
+	// Classes of the shared tree nodes were refreshed by the inner analyzers
+	RefreshFileIndex();
+}
@@ -25,11 +25,26 @@ public:
 
 	virtual bool LoadPakFiles(const TArray<FString>& InPakPaths, const TArray<FString>& InDefaultAESKeys, int32 ContainerStartIndex = 0) override;
 	virtual void ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles) override;
+	virtual bool ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles) override;
 	virtual void CancelExtract() override;
+	virtual void VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles) override;
+	virtual void CancelVerify() override;
+	virtual void PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles) override;
 	virtual void SetExtractThreadCount(int32 InThreadCount) override;
+	virtual void SetExtractIOThreadCount(int32 InReadThreadCount, int32 InWriteThreadCount) override;
+	virtual void SetExtractMode(EExtractMode InMode) override;
+	virtual void SetExtractDeduplicate(bool bInDeduplicate) override;
 	virtual void Reset() override;
 
 protected:
+	void OnAssetParseFinish();
+	void OnInnerVerifyFinish(const FVerifyResult& InResult, uint32 InGeneration);
+
 	TSharedPtr<FPakAnalyzer> PakAnalyzer;
 	TSharedPtr<FIoStoreAnalyzer> IoStoreAnalyzer;
+
+	// Results of the inner analyzers are merged into one OnVerifyFinish
+	uint32 VerifyGeneration = 0;
+	int32 PendingVerifyCount = 0;
+	FVerifyResult MergedVerifyResult;
 };
@@ -9,21 +9,88 @@
 
 DECLARE_LOG_CATEGORY_EXTERN(LogPakAnalyzer, Log, All);
 
+enum class EExtractStage : uint8
+{
+	Read,
+	Decode,
+	Write,
+};
+
+enum class EExtractMode : uint8
+{
+	// Extract every file
+	Full,
+	// Skip files the journal lists with the same hash and which exist with the same size
+	Resume,
+	// Skip files the journal lists with the same hash without checking the output
+	Incremental,
+};
+
+struct FExtractWorkerStats
+{
+	EExtractStage Stage = EExtractStage::Decode;
+	// Files written, only counted by the write stage
+	int32 CompleteCount = 0;
+	int32 ErrorCount = 0;
+	// Bytes read, decoded or written depending on the stage
+	int64 ExtractedBytes = 0;
+	double BusySeconds = 0.0;
+	// Time spent without work while other workers were still extracting
+	double IdleSeconds = 0.0;
+	double FinishTime = 0.0;
+	bool bFinished = false;
+
+	double GetBytesPerSecond() const { return BusySeconds > 0.0 ? ExtractedBytes / BusySeconds : 0.0; }
+};
+
+struct FVerifyFailure
+{
+	// File path, or the pak name for failures of the pak signature
+	FString Path;
+	FString PakName;
+	// Offset of the entry in its pak or container
+	int64 Offset = 0;
+	// First failing compression block and its absolute offset, INDEX_NONE when the whole entry is affected
+	int32 BlockIndex = INDEX_NONE;
+	int64 BlockOffset = 0;
+	FString Reason;
+};
+
+struct FVerifyResult
+{
+	int32 TotalCount = 0;
+	int32 VerifiedCount = 0;
+	// Bytes read from the paks
+	int64 VerifiedBytes = 0;
+	double Seconds = 0.0;
+	bool bCancelled = false;
+	TArray<FVerifyFailure> Failures;
+
+	double GetBytesPerSecond() const { return Seconds > 0.0 ? VerifiedBytes / Seconds : 0.0; }
+};
+
 class FPakAnalyzerDelegates
 {
 public:
 	DECLARE_DELEGATE_RetVal_ThreeParams(FString, FOnGetAESKey, const FString&/* PakPath*/, const FGuid&/* Guid*/, bool& /*bCancel*/);
 	DECLARE_DELEGATE_OneParam(FOnLoadPakFailed, const FString&)
 	DECLARE_DELEGATE_ThreeParams(FOnUpdateExtractProgress, int32 /*CompleteCount*/, int32 /*ErrorCount*/, int32 /*TotalCount*/);
+	DECLARE_DELEGATE_OneParam(FOnUpdateExtractWorkerStats, const TArray<FExtractWorkerStats>&);
 	DECLARE_DELEGATE(FOnExtractStart);
+	DECLARE_DELEGATE_OneParam(FOnVerifyFinish, const FVerifyResult&);
 	DECLARE_MULTICAST_DELEGATE(FOnAssetParseFinish);
+	DECLARE_MULTICAST_DELEGATE_OneParam(FOnAssetParsed, TSharedPtr<struct FPakFileEntry> /*File*/);
 	DECLARE_MULTICAST_DELEGATE(FOnPakLoadFinish);
 
 public:
 	static FOnGetAESKey OnGetAESKey;
 	static FOnLoadPakFailed OnLoadPakFailed;
 	static FOnUpdateExtractProgress OnUpdateExtractProgress;
+	static FOnUpdateExtractWorkerStats OnUpdateExtractWorkerStats;
 	static FOnExtractStart OnExtractStart;
+	static FOnVerifyFinish OnVerifyFinish;
 	static FOnAssetParseFinish OnAssetParseFinish;
+	// Prioritized asset parsed ahead of the rest of the batch
+	static FOnAssetParsed OnAssetParsed;
 	static FOnPakLoadFinish OnPakLoadFinish;
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Search box query for the file list, e.g. "class:Texture2D size>4MB pak:pakchunk3 ratio<0.5 encrypted:true hero".
+ * Words without a known key are path substrings, all parts of a query must match.
+ * Comma separated values match any of them, class, pak and compression values may use wildcards.
+ */
+struct FFileQuery
+{
+	enum class EField : uint8
+	{
+		Size,
+		CompressedSize,
+		BlockCount,
+		Ratio,
+		Class,
+		Pak,
+		Compression,
+		Encrypted,
+	};
+
+	enum class ECompare : uint8
+	{
+		Equal,
+		Less,
+		LessEqual,
+		Greater,
+		GreaterEqual,
+	};
+
+	struct FPredicate
+	{
+		EField Field;
+		ECompare Compare;
+		double Number = 0.0;
+		TArray<FString> Values;
+
+		bool IsNumeric() const { return Field == EField::Size || Field == EField::CompressedSize || Field == EField::BlockCount || Field == EField::Ratio; }
+		bool operator==(const FPredicate& Other) const { return Field == Other.Field && Compare == Other.Compare && Number == Other.Number && Values == Other.Values; }
+	};
+
+	TArray<FPredicate> Predicates;
+	TArray<FString> Terms;
+
+	/** Parses a query, tokens which are not valid predicates are kept as path substrings. */
+	static FFileQuery Parse(const FString& InText);
+
+	bool IsEmpty() const { return Predicates.Num() <= 0 && Terms.Num() <= 0; }
+	bool HasPredicates() const { return Predicates.Num() > 0; }
+
+	/** Whether every path containing all terms of this query also matches InPath. */
+	bool MatchesPath(const TCHAR* InPath) const;
+
+	/** Whether every file matching this query also matches InOther, so results of InOther can be narrowed down. */
+	bool IsNarrowerThan(const FFileQuery& InOther) const;
+
+	static bool CompareNumber(double InValue, ECompare InCompare, double InOperand);
+
+protected:
+	static void Tokenize(const FString& InText, TArray<FString>& OutTokens);
+	static bool ParsePredicate(const FString& InToken, FPredicate& OutPredicate);
+	static bool ParseNumber(const FString& InText, bool bInAllowUnit, double& OutNumber);
+};
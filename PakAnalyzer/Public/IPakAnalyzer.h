@@ -4,11 +4,14 @@
 
 #include "CoreMinimal.h"
 
+#include "CommonDefines.h"
 #include "PakFileEntry.h"
 
 struct FPakEntry;
 
 static const int32 DEFAULT_EXTRACT_THREAD_COUNT = 4;
+static const int32 DEFAULT_EXTRACT_READ_THREAD_COUNT = 2;
+static const int32 DEFAULT_EXTRACT_WRITE_THREAD_COUNT = 2;
 
 class IPakAnalyzer
 {
@@ -21,10 +24,20 @@ public:
 	virtual const TArray<FPakFileSumaryPtr>& GetPakFileSumary() const = 0;
 	virtual const TArray<FPakTreeEntryPtr>& GetPakTreeRootNode() const = 0;
 	virtual void ExtractFiles(const FString& InOutputPath, TArray<FPakFileEntryPtr>& InFiles) = 0;
+	/** Writes the files into one tar archive, returns false without starting when the selection can not share an archive. */
+	virtual bool ExtractFilesToArchive(const FString& InArchivePath, TArray<FPakFileEntryPtr>& InFiles) = 0;
 	virtual void CancelExtract() = 0;
+	/** Reads and checks the selected files in the background without writing output, the result is sent with OnVerifyFinish. */
+	virtual void VerifyFiles(const TArray<FPakFileEntryPtr>& InFiles) = 0;
+	virtual void CancelVerify() = 0;
+	/** Parses the given assets ahead of the running background parse, the first one first. */
+	virtual void PrioritizeAssetParse(const TArray<FPakFileEntryPtr>& InFiles) = 0;
 	virtual bool ExportToJson(const FString& InOutputPath, const TArray<FPakFileEntryPtr>& InFiles) = 0;
 	virtual bool ExportToCsv(const FString& InOutputPath, const TArray<FPakFileEntryPtr>& InFiles) = 0;
 	virtual void SetExtractThreadCount(int32 InThreadCount) = 0;
+	virtual void SetExtractIOThreadCount(int32 InReadThreadCount, int32 InWriteThreadCount) = 0;
+	virtual void SetExtractMode(EExtractMode InMode) = 0;
+	virtual void SetExtractDeduplicate(bool bInDeduplicate) = 0;
 	virtual bool LoadAssetRegistry(const FString& InRegristryPath) = 0;
 	virtual FString GetAssetRegistryPath() const = 0;
 };
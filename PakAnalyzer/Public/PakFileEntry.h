@@ -16,6 +16,8 @@ typedef TSharedPtr<struct FPakTreeEntry> FPakTreeEntryPtr;
 typedef TSharedPtr<struct FPackageInfo> FPackageInfoPtr;
 typedef TSharedPtr<struct FPakFileSumary> FPakFileSumaryPtr;
 
+class FPakTreeArena;
+
 struct FPakClassEntry
 {
 	FPakClassEntry(FName InClassName, int64 InSize, int64 InCompressedSize, int32 InFileCount)
@@ -78,18 +80,116 @@ struct FAssetSummary
 	TArray<FPackageInfoPtr> DependentList; // assets depends on this
 };
 
-struct FPakFileEntry : TSharedFromThis<FPakFileEntry>
+/**
+ * Path of a file entry. Nodes built into a tree point into the path pool of their arena, which every node keeps alive.
+ * Any other path, and every copy of a path, owns its characters.
+ */
+class FPakPath
+{
+public:
+	FPakPath() {}
+	FPakPath(const TCHAR* InPath) { Assign(InPath, FCString::Strlen(InPath)); }
+	FPakPath(const FString& InPath) { Assign(*InPath, InPath.Len()); }
+	FPakPath(const FPakPath& Other) { Assign(Other.Data, Other.Length); }
+
+	FPakPath(FPakPath&& Other)
+		: Data(Other.Data)
+		, Length(Other.Length)
+		, bOwned(Other.bOwned)
+	{
+		Other.Data = nullptr;
+		Other.Length = 0;
+		Other.bOwned = false;
+	}
+
+	~FPakPath() { Free(); }
+
+	FPakPath& operator=(const FPakPath& Other)
+	{
+		if (this != &Other)
+		{
+			Free();
+			Assign(Other.Data, Other.Length);
+		}
+		return *this;
+	}
+
+	FPakPath& operator=(FPakPath&& Other)
+	{
+		if (this != &Other)
+		{
+			Free();
+			Data = Other.Data;
+			Length = Other.Length;
+			bOwned = Other.bOwned;
+			Other.Data = nullptr;
+			Other.Length = 0;
+			Other.bOwned = false;
+		}
+		return *this;
+	}
+
+	/** Path borrowing null terminated characters, which must outlive it. */
+	static FPakPath MakeView(const TCHAR* InData, int32 InLength)
+	{
+		FPakPath Path;
+		Path.Data = InData;
+		Path.Length = InLength;
+		return Path;
+	}
+
+	FORCEINLINE const TCHAR* operator*() const { return Data ? Data : TEXT(""); }
+	FORCEINLINE int32 Len() const { return Length; }
+	FORCEINLINE bool IsEmpty() const { return Length == 0; }
+	FString ToString() const { return FString(Length, **this); }
+	SIZE_T GetAllocatedSize() const { return bOwned ? (Length + 1) * sizeof(TCHAR) : 0; }
+
+	/** Case insensitive like FString. */
+	friend bool operator<(const FPakPath& A, const FPakPath& B) { return FCString::Stricmp(*A, *B) < 0; }
+
+private:
+	void Assign(const TCHAR* InData, int32 InLength)
+	{
+		Data = nullptr;
+		Length = InLength;
+		bOwned = InLength > 0;
+		if (bOwned)
+		{
+			TCHAR* Owned = (TCHAR*)FMemory::Malloc((InLength + 1) * sizeof(TCHAR));
+			FMemory::Memcpy(Owned, InData, InLength * sizeof(TCHAR));
+			Owned[InLength] = TEXT('\0');
+			Data = Owned;
+		}
+	}
+
+	void Free()
+	{
+		if (bOwned)
+		{
+			FMemory::Free((void*)Data);
+		}
+		Data = nullptr;
+		Length = 0;
+		bOwned = false;
+	}
+
+	const TCHAR* Data = nullptr;
+	int32 Length = 0;
+	bool bOwned = false;
+};
+
+struct FPakFileEntry
 {
-	FPakFileEntry(FName InFilename, const FString& InPath)
+	FPakFileEntry(FName InFilename, FPakPath&& InPath)
 		: Filename(InFilename)
-		, Path(InPath)
+		, Path(MoveTemp(InPath))
 	{
 
 	}
 
 	FPakEntry PakEntry;
 	FName Filename;
-	FString Path;
+	FPakPath Path;
 	FName CompressionMethod;
 	FName Class;
 	FName PackagePath;
@@ -106,11 +206,9 @@ struct FPakTreeEntry : public FPakFileEntry
 	float CompressedSizePercentOfParent;
 
 	bool bIsDirectory;
-	TMap<FName, TSharedPtr<FPakTreeEntry>> ChildrenMap;
-	TMap<FName, FPakClassEntryPtr> FileClassMap;
 
-	FPakTreeEntry(FName InFilename, const FString& InPath, bool bInIsDirectory)
-		: FPakFileEntry(InFilename, InPath)
+	FPakTreeEntry(FName InFilename, FPakPath&& InPath, bool bInIsDirectory)
+		: FPakFileEntry(InFilename, MoveTemp(InPath))
 		, FileCount(0)
 		, Size(0)
 		, CompressedSize(0)
@@ -118,8 +216,77 @@ struct FPakTreeEntry : public FPakFileEntry
 		, CompressedSizePercentOfParent(1.f)
 		, bIsDirectory(bInIsDirectory)
 	{
+		if (bIsDirectory)
+		{
+			DirectoryData = MakeUnique<FDirectoryData>();
+		}
+	}
 
+	FORCEINLINE TMap<FName, TSharedPtr<FPakTreeEntry>>& GetMutableChildrenMap()
+	{
+		check(DirectoryData.IsValid());
+		return DirectoryData->ChildrenMap;
 	}
+
+	FORCEINLINE const TMap<FName, TSharedPtr<FPakTreeEntry>>& GetChildrenMap() const
+	{
+		static const TMap<FName, TSharedPtr<FPakTreeEntry>> EmptyChildrenMap;
+		return DirectoryData.IsValid() ? DirectoryData->ChildrenMap : EmptyChildrenMap;
+	}
+
+	FORCEINLINE TMap<FName, FPakClassEntryPtr>& GetMutableFileClassMap()
+	{
+		check(DirectoryData.IsValid());
+		return DirectoryData->FileClassMap;
+	}
+
+	FORCEINLINE const TMap<FName, FPakClassEntryPtr>& GetFileClassMap() const
+	{
+		static const TMap<FName, FPakClassEntryPtr> EmptyFileClassMap;
+		return DirectoryData.IsValid() ? DirectoryData->FileClassMap : EmptyFileClassMap;
+	}
+
+	/** Heap memory owned by the node, excluding the node itself and the pooled path. */
+	SIZE_T GetAllocatedSize() const
+	{
+		SIZE_T AllocatedSize = Path.GetAllocatedSize() + PakEntry.CompressionBlocks.GetAllocatedSize();
+		if (DirectoryData.IsValid())
+		{
+			AllocatedSize += sizeof(FDirectoryData) + DirectoryData->ChildrenMap.GetAllocatedSize() + DirectoryData->FileClassMap.GetAllocatedSize();
+		}
+		return AllocatedSize;
+	}
+
+	/** Only set on tree roots, the arena holding every node below. */
+	void SetArena(const TSharedPtr<FPakTreeArena>& InArena)
+	{
+		check(DirectoryData.IsValid());
+		DirectoryData->Arena = InArena;
+	}
+
+	const FPakTreeArena* GetArena() const
+	{
+		return DirectoryData.IsValid() ? DirectoryData->Arena.Get() : nullptr;
+	}
+
+	/**
+	 * Drops the tree below a root, nodes still referenced elsewhere stay valid but lose their children.
+	 * Also runs when the root itself is destroyed, so a root dropped without it does not leak the tree.
+	 */
+	void ReleaseTree();
+
+protected:
+	// Children and class summary only exist for directories, file nodes stay small
+	struct FDirectoryData
+	{
+		~FDirectoryData();
+
+		TMap<FName, TSharedPtr<FPakTreeEntry>> ChildrenMap;
+		TMap<FName, FPakClassEntryPtr> FileClassMap;
+		TSharedPtr<FPakTreeArena> Arena;
+	};
+
+	TUniquePtr<FDirectoryData> DirectoryData;
 };
 
 struct FPakFileSumary
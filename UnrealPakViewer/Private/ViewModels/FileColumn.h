@@ -19,6 +19,11 @@ class FFileColumn
 public:
 	typedef TFunction<bool(const FPakFileEntryPtr& A, const FPakFileEntryPtr& B)> FFileCompareFunc;
 
+	/** Sort keys are extracted once per row, so the sort itself never calls back into the column */
+	typedef TFunction<int64(const FPakFileEntry& InEntry)> FFileIntegerKeyFunc;
+	typedef TFunction<FName(const FPakFileEntry& InEntry)> FFileNameKeyFunc;
+	typedef TFunction<const TCHAR*(const FPakFileEntry& InEntry)> FFileStringKeyFunc;
+
 	static const FName NameColumnName;
 	static const FName PathColumnName;
 	static const FName ClassColumnName;
@@ -79,6 +84,17 @@ public:
 	FFileCompareFunc GetAscendingCompareDelegate() const { return AscendingCompareDelegate; }
 	FFileCompareFunc GetDescendingCompareDelegate() const { return DescendingCompareDelegate; }
 
+	void SetIntegerSortKey(FFileIntegerKeyFunc InKeyFunc) { IntegerSortKey = InKeyFunc; }
+	void SetNameSortKey(FFileNameKeyFunc InKeyFunc) { NameSortKey = InKeyFunc; }
+	void SetStringSortKey(FFileStringKeyFunc InKeyFunc) { StringSortKey = InKeyFunc; }
+
+	const FFileIntegerKeyFunc& GetIntegerSortKey() const { return IntegerSortKey; }
+	const FFileNameKeyFunc& GetNameSortKey() const { return NameSortKey; }
+	const FFileStringKeyFunc& GetStringSortKey() const { return StringSortKey; }
+
+	/** Whether this column can be sorted by keys instead of compare delegates. */
+	bool HasSortKey() const { return IntegerSortKey || NameSortKey || StringSortKey; }
+
 protected:
 	int32 Index;
 	FName Id;
@@ -88,6 +104,9 @@ protected:
 	EFileColumnFlags Flags;
 	FFileCompareFunc AscendingCompareDelegate;
 	FFileCompareFunc DescendingCompareDelegate;
+	FFileIntegerKeyFunc IntegerSortKey;
+	FFileNameKeyFunc NameSortKey;
+	FFileStringKeyFunc StringSortKey;
 
 	bool bIsVisible;
 };
\ No newline at end of file
@@ -1,8 +1,14 @@
 #include "FileSortAndFilter.h"
 
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformTime.h"
 #include "Misc/ScopeLock.h"
+#include "CommonDefines.h"
+#include "FileQuery.h"
 #include "PakAnalyzerModule.h"
 #include "ViewModels/FileColumn.h"
+#include "ViewModels/FileSorter.h"
 #include "Widgets/SPakFileView.h"
 
 void FFileSortAndFilterTask::DoWork()
@@ -13,8 +19,23 @@ void FFileSortAndFilterTask::DoWork()
 		return;
 	}
 
+	if (IsCancelled())
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const bool bRefine = CanRefinePreviousResult();
+
 	TArray<FPakFileEntryPtr> FilterResult;
-	IPakAnalyzerModule::Get().GetPakAnalyzer()->GetFiles(CurrentSearchText, ClassFilterMap, IndexFilterMap, FilterResult);
+	if (bRefine)
+	{
+		FilterPreviousResult(FilterResult);
+	}
+	else
+	{
+		IPakAnalyzerModule::Get().GetPakAnalyzer()->GetFiles(CurrentSearchText, ClassFilterMap, IndexFilterMap, FilterResult);
+	}
 
 	const FFileColumn* Column = PakFileViewPin->FindCoulum(CurrentSortedColumn);
 	if (!Column)
@@ -22,12 +43,26 @@ void FFileSortAndFilterTask::DoWork()
 		return;
 	}
 
-	if (!Column->CanBeSorted())
+	if (!Column->CanBeSorted() || IsCancelled())
 	{
 		return;
 	}
 
-	if (CurrentSortMode == EColumnSortMode::Ascending)
+	// Filtering keeps the order of the previous result, which is already sorted by the same column
+	const bool bSameColumn = bRefine && PreviousSortedColumn == CurrentSortedColumn;
+	if (bSameColumn)
+	{
+		if (PreviousSortMode != CurrentSortMode)
+		{
+			// Only the direction flipped
+			Algo::Reverse(FilterResult);
+		}
+	}
+	else if (Column->HasSortKey())
+	{
+		FFileSorter::Sort(*Column, CurrentSortMode, FilterResult, [this]() { return IsCancelled(); });
+	}
+	else if (CurrentSortMode == EColumnSortMode::Ascending)
 	{
 		FilterResult.Sort(Column->GetAscendingCompareDelegate());
 	}
@@ -36,16 +71,50 @@ void FFileSortAndFilterTask::DoWork()
 		FilterResult.Sort(Column->GetDescendingCompareDelegate());
 	}
 
+	if (IsCancelled())
+	{
+		UE_LOG(LogPakAnalyzer, Verbose, TEXT("Sort and filter generation %u cancelled after %.3fs."), WorkGeneration, FPlatformTime::Seconds() - StartTime);
+		return;
+	}
+
+	// Built here so the view never scans the list on the game thread to find a row
+	TMap<const FPakFileEntry*, int32> FilterResultRows;
+	FilterResultRows.Reserve(FilterResult.Num());
+	for (int32 i = 0; i < FilterResult.Num(); ++i)
+	{
+		FilterResultRows.Add(FilterResult[i].Get(), i);
+	}
+
+	bHasPreviousResult = true;
+	PreviousResult = FilterResult;
+	PreviousSortedColumn = CurrentSortedColumn;
+	PreviousSortMode = CurrentSortMode;
+	PreviousSearchText = CurrentSearchText;
+	PreviousClassFilterMap = ClassFilterMap;
+	PreviousIndexFilterMap = IndexFilterMap;
+
 	{
 		FScopeLock Lock(&CriticalSection);
 		Result = MoveTemp(FilterResult);
+		ResultRows = MoveTemp(FilterResultRows);
 	}
 
-	OnWorkFinished.ExecuteIfBound(CurrentSortedColumn, CurrentSortMode, CurrentSearchText);
+	UE_LOG(LogPakAnalyzer, Verbose, TEXT("Sort and filter generation %u: %d files in %.3fs%s."), WorkGeneration, PreviousResult.Num(), FPlatformTime::Seconds() - StartTime, bRefine ? TEXT(", refined") : TEXT(""));
+
+	OnWorkFinished.ExecuteIfBound(CurrentSortedColumn, CurrentSortMode, CurrentSearchText, WorkGeneration);
 }
 
-void FFileSortAndFilterTask::SetWorkInfo(FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText, const TMap<FName, bool>& InClassFilterMap, const TMap<int32, bool>& InIndexFilterMap)
+void FFileSortAndFilterTask::SetWorkInfo(FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText, const TMap<FName, bool>& InClassFilterMap, const TMap<int32, bool>& InIndexFilterMap, bool bInFilesChanged, uint32 InGeneration)
 {
+	WorkGeneration = InGeneration;
+	RequestedGeneration = InGeneration;
+	bFilesChanged = bInFilesChanged;
+	if (bInFilesChanged)
+	{
+		// A cancelled generation never publishes, drop the old result now so it is not refined against the new file list later
+		bHasPreviousResult = false;
+		PreviousResult.Empty();
+	}
 	CurrentSortedColumn = InSortedColumn;
 	CurrentSortMode = InSortMode;
 	CurrentSearchText = InSearchText;
@@ -53,8 +122,67 @@ void FFileSortAndFilterTask::SetWorkInfo(FName InSortedColumn, EColumnSortMode::
 	IndexFilterMap = InIndexFilterMap;
 }
 
-void FFileSortAndFilterTask::RetriveResult(TArray<FPakFileEntryPtr>& OutResult)
+void FFileSortAndFilterTask::RetriveResult(TArray<FPakFileEntryPtr>& OutResult, TMap<const FPakFileEntry*, int32>& OutRows)
 {
 	FScopeLock Lock(&CriticalSection);
 	OutResult = MoveTemp(Result);
+	OutRows = MoveTemp(ResultRows);
+}
+
+bool FFileSortAndFilterTask::CanRefinePreviousResult() const
+{
+	if (bFilesChanged || !bHasPreviousResult)
+	{
+		return false;
+	}
+
+	// Query predicates are only evaluated by the analyzer, plain terms can be checked against the previous matches
+	const FFileQuery CurrentQuery = FFileQuery::Parse(CurrentSearchText);
+	if (CurrentQuery.HasPredicates() || !CurrentQuery.IsNarrowerThan(FFileQuery::Parse(PreviousSearchText)))
+	{
+		return false;
+	}
+
+	return IsFilterStricter(ClassFilterMap, PreviousClassFilterMap) && IsFilterStricter(IndexFilterMap, PreviousIndexFilterMap);
+}
+
+void FFileSortAndFilterTask::FilterPreviousResult(TArray<FPakFileEntryPtr>& OutResult) const
+{
+	static const int32 ChunkSize = 16 * 1024;
+	const int32 FileCount = PreviousResult.Num();
+	const int32 ChunkCount = FMath::DivideAndRoundUp(FileCount, ChunkSize);
+
+	TArray<TArray<FPakFileEntryPtr>> ChunkResults;
+	ChunkResults.SetNum(ChunkCount);
+
+	const FFileQuery Query = FFileQuery::Parse(CurrentSearchText);
+
+	ParallelFor(ChunkCount, [this, &Query, &ChunkResults, FileCount](int32 ChunkIndex)
+	{
+		if (IsCancelled())
+		{
+			return;
+		}
+
+		TArray<FPakFileEntryPtr>& ChunkResult = ChunkResults[ChunkIndex];
+		const int32 End = FMath::Min((ChunkIndex + 1) * ChunkSize, FileCount);
+
+		for (int32 i = ChunkIndex * ChunkSize; i < End; ++i)
+		{
+			const FPakFileEntryPtr& File = PreviousResult[i];
+
+			const bool* bShowClass = ClassFilterMap.Find(File->Class);
+			const bool* bShowIndex = IndexFilterMap.Find(File->OwnerPakIndex);
+			if ((ClassFilterMap.Num() <= 0 || (bShowClass && *bShowClass)) && (IndexFilterMap.Num() <= 0 || (bShowIndex && *bShowIndex)) &&
+				Query.MatchesPath(*File->Path))
+			{
+				ChunkResult.Add(File);
+			}
+		}
+	});
+
+	for (const TArray<FPakFileEntryPtr>& ChunkResult : ChunkResults)
+	{
+		OutResult.Append(ChunkResult);
+	}
 }
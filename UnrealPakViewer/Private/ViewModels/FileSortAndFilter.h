@@ -5,10 +5,11 @@
 #include "Async/AsyncWork.h"
 #include "HAL/CriticalSection.h"
 #include "Stats/Stats.h"
+#include "Templates/Atomic.h"
 #include "Widgets/Views/SHeaderRow.h"
 
 
-DECLARE_DELEGATE_ThreeParams(FOnSortAndFilterFinished, const FName, EColumnSortMode::Type, const FString&);
+DECLARE_DELEGATE_FourParams(FOnSortAndFilterFinished, const FName, EColumnSortMode::Type, const FString&, uint32);
 
 class SPakFileView;
 
@@ -20,12 +21,16 @@ public:
 		, CurrentSortMode(InSortMode)
 		, CurrentSearchText(TEXT(""))
 		, WeakPakFileView(InPakFileView)
+		, RequestedGeneration(0)
 	{
 
 	}
 
 	void DoWork();
-	void SetWorkInfo(FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText, const TMap<FName, bool>& InClassFilterMap, const TMap<int32, bool>& InIndexFilterMap);
+	void SetWorkInfo(FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText, const TMap<FName, bool>& InClassFilterMap, const TMap<int32, bool>& InIndexFilterMap, bool bInFilesChanged, uint32 InGeneration);
+
+	/** Called from game thread whenever the view wants newer results, work of older generations stops at the next chunk and is never published */
+	void SetRequestedGeneration(uint32 InGeneration) { RequestedGeneration = InGeneration; }
 	FOnSortAndFilterFinished& GetOnSortAndFilterFinishedDelegate() { return OnWorkFinished; }
 
 	FORCEINLINE TStatId GetStatId() const
@@ -33,9 +38,18 @@ public:
 		RETURN_QUICK_DECLARE_CYCLE_STAT(STAT_FFileSortAndFilterTask, STATGROUP_ThreadPoolAsyncTasks);
 	}
 
-	void RetriveResult(TArray<FPakFileEntryPtr>& OutResult);
+	/** OutRows maps every file of OutResult to its row. */
+	void RetriveResult(TArray<FPakFileEntryPtr>& OutResult, TMap<const FPakFileEntry*, int32>& OutRows);
 
 protected:
+	/** Whether the current search only narrows the previous one, so the previous result contains every match */
+	bool CanRefinePreviousResult() const;
+	void FilterPreviousResult(TArray<FPakFileEntryPtr>& OutResult) const;
+	bool IsCancelled() const { return RequestedGeneration.Load(EMemoryOrder::Relaxed) != WorkGeneration; }
+
+	template <typename KeyType>
+	static bool IsFilterStricter(const TMap<KeyType, bool>& InNewFilter, const TMap<KeyType, bool>& InOldFilter);
+
 	FName CurrentSortedColumn;
 	EColumnSortMode::Type CurrentSortMode;
 	FString CurrentSearchText;
@@ -47,7 +61,47 @@ protected:
 
 	FCriticalSection CriticalSection;
 	TArray<FPakFileEntryPtr> Result;
+	TMap<const FPakFileEntry*, int32> ResultRows;
 
 	TMap<FName, bool> ClassFilterMap;
 	TMap<int32, bool> IndexFilterMap;
-};
\ No newline at end of file
+	bool bFilesChanged = true;
+
+	uint32 WorkGeneration = 0;
+	TAtomic<uint32> RequestedGeneration;
+
+	/** Sorted result and inputs of the last finished work, only touched on the worker thread */
+	bool bHasPreviousResult = false;
+	TArray<FPakFileEntryPtr> PreviousResult;
+	FName PreviousSortedColumn;
+	EColumnSortMode::Type PreviousSortMode = EColumnSortMode::None;
+	FString PreviousSearchText;
+	TMap<FName, bool> PreviousClassFilterMap;
+	TMap<int32, bool> PreviousIndexFilterMap;
+};
+
+template <typename KeyType>
+bool FFileSortAndFilterTask::IsFilterStricter(const TMap<KeyType, bool>& InNewFilter, const TMap<KeyType, bool>& InOldFilter)
+{
+	// An empty filter shows everything
+	if (InOldFilter.Num() <= 0)
+	{
+		return true;
+	}
+
+	if (InNewFilter.Num() <= 0)
+	{
+		return false;
+	}
+
+	for (const auto& Pair : InNewFilter)
+	{
+		const bool* bOldShow = InOldFilter.Find(Pair.Key);
+		if (Pair.Value && !(bOldShow && *bOldShow))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "FileSorter.h"
+
+#include "Algo/Reverse.h"
+#include "Algo/Sort.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformMisc.h"
+#include "ViewModels/FileColumn.h"
+
+bool FFileSorter::Sort(const FFileColumn& InColumn, EColumnSortMode::Type InSortMode, TArray<FPakFileEntryPtr>& InOutFiles, TFunctionRef<bool()> InIsCancelled)
+{
+	if (!InColumn.HasSortKey())
+	{
+		return false;
+	}
+
+	const int32 FileCount = InOutFiles.Num();
+
+	TArray<FSortPair> Pairs;
+	Pairs.SetNumUninitialized(FileCount);
+
+	if (InColumn.GetIntegerSortKey())
+	{
+		const FFileColumn::FFileIntegerKeyFunc& KeyFunc = InColumn.GetIntegerSortKey();
+		ParallelFor(FileCount, [&Pairs, &InOutFiles, &KeyFunc](int32 Index)
+		{
+			Pairs[Index].Key = KeyFunc(*InOutFiles[Index]);
+			Pairs[Index].Index = Index;
+		});
+	}
+	else if (InColumn.GetNameSortKey())
+	{
+		if (!BuildNameKeys(InColumn, InOutFiles, Pairs, InIsCancelled))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		// Strings point into the file entries, which stay alive through InOutFiles
+		const FFileColumn::FFileStringKeyFunc& KeyFunc = InColumn.GetStringSortKey();
+
+		TArray<const TCHAR*> Strings;
+		Strings.SetNumUninitialized(FileCount);
+		for (int32 i = 0; i < FileCount; ++i)
+		{
+			Strings[i] = KeyFunc(*InOutFiles[i]);
+		}
+
+		TArray<int64> Ranks;
+		if (!BuildStringKeys(Strings, Ranks, InIsCancelled))
+		{
+			return false;
+		}
+
+		for (int32 i = 0; i < FileCount; ++i)
+		{
+			Pairs[i].Key = Ranks[i];
+			Pairs[i].Index = i;
+		}
+	}
+
+	if (InIsCancelled() || !ParallelSort(Pairs, InIsCancelled))
+	{
+		return false;
+	}
+
+	if (InSortMode == EColumnSortMode::Descending)
+	{
+		Algo::Reverse(Pairs);
+	}
+
+	TArray<FPakFileEntryPtr> SortedFiles;
+	SortedFiles.Reserve(FileCount);
+	for (const FSortPair& Pair : Pairs)
+	{
+		SortedFiles.Add(MoveTemp(InOutFiles[Pair.Index]));
+	}
+	InOutFiles = MoveTemp(SortedFiles);
+
+	return true;
+}
+
+bool FFileSorter::BuildNameKeys(const FFileColumn& InColumn, const TArray<FPakFileEntryPtr>& InFiles, TArray<FSortPair>& OutPairs, TFunctionRef<bool()> InIsCancelled)
+{
+	const FFileColumn::FFileNameKeyFunc& KeyFunc = InColumn.GetNameSortKey();
+
+	// Only distinct names are compared, rows get the ordinal of their name
+	TMap<FName, int32> NameToUniqueIndex;
+	TArray<int32> UniqueIndices;
+	UniqueIndices.SetNumUninitialized(InFiles.Num());
+	for (int32 i = 0; i < InFiles.Num(); ++i)
+	{
+		const FName Name = KeyFunc(*InFiles[i]);
+		const int32* UniqueIndex = NameToUniqueIndex.Find(Name);
+		UniqueIndices[i] = UniqueIndex ? *UniqueIndex : NameToUniqueIndex.Add(Name, NameToUniqueIndex.Num());
+	}
+
+	TArray<FString> UniqueNames;
+	UniqueNames.SetNum(NameToUniqueIndex.Num());
+	for (const auto& Pair : NameToUniqueIndex)
+	{
+		UniqueNames[Pair.Value] = Pair.Key.ToString();
+	}
+
+	TArray<const TCHAR*> Strings;
+	Strings.SetNumUninitialized(UniqueNames.Num());
+	for (int32 i = 0; i < UniqueNames.Num(); ++i)
+	{
+		Strings[i] = *UniqueNames[i];
+	}
+
+	TArray<int64> Ranks;
+	if (!BuildStringKeys(Strings, Ranks, InIsCancelled))
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < InFiles.Num(); ++i)
+	{
+		OutPairs[i].Key = Ranks[UniqueIndices[i]];
+		OutPairs[i].Index = i;
+	}
+
+	return true;
+}
+
+bool FFileSorter::BuildStringKeys(const TArray<const TCHAR*>& InStrings, TArray<int64>& OutRanks, TFunctionRef<bool()> InIsCancelled)
+{
+	TArray<FStringPair> Pairs;
+	Pairs.SetNumUninitialized(InStrings.Num());
+	for (int32 i = 0; i < InStrings.Num(); ++i)
+	{
+		Pairs[i].String = InStrings[i];
+		Pairs[i].Index = i;
+	}
+
+	if (!ParallelSort(Pairs, InIsCancelled))
+	{
+		return false;
+	}
+
+	// Strings equal ignoring case share one rank, so ties are broken by row order later
+	OutRanks.SetNumUninitialized(InStrings.Num());
+	int64 Rank = 0;
+	for (int32 i = 0; i < Pairs.Num(); ++i)
+	{
+		if (i > 0 && FCString::Stricmp(Pairs[i - 1].String, Pairs[i].String) != 0)
+		{
+			++Rank;
+		}
+		OutRanks[Pairs[i].Index] = Rank;
+	}
+
+	return true;
+}
+
+template <typename PairType>
+bool FFileSorter::ParallelSort(TArray<PairType>& InOutPairs, TFunctionRef<bool()> InIsCancelled)
+{
+	static const int32 MinRunSize = 16 * 1024;
+
+	const int32 Num = InOutPairs.Num();
+	const int32 WorkerCount = FMath::Max(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1);
+	const int32 RunSize = FMath::Max(MinRunSize, FMath::DivideAndRoundUp(Num, WorkerCount));
+	const int32 RunCount = FMath::DivideAndRoundUp(Num, RunSize);
+
+	if (RunCount <= 1)
+	{
+		Algo::Sort(InOutPairs);
+		return true;
+	}
+
+	ParallelFor(RunCount, [&InOutPairs, RunSize, Num](int32 RunIndex)
+	{
+		const int32 Start = RunIndex * RunSize;
+		Algo::Sort(MakeArrayView(InOutPairs.GetData() + Start, FMath::Min(RunSize, Num - Start)));
+	});
+
+	TArray<PairType> Buffer;
+	Buffer.SetNumUninitialized(Num);
+
+	PairType* Source = InOutPairs.GetData();
+	PairType* Dest = Buffer.GetData();
+
+	// Merge neighbouring runs, doubling the run width every pass
+	for (int32 Width = RunSize; Width < Num; Width *= 2)
+	{
+		if (InIsCancelled())
+		{
+			return false;
+		}
+
+		const int32 MergeCount = FMath::DivideAndRoundUp(Num, Width * 2);
+		ParallelFor(MergeCount, [Source, Dest, Width, Num](int32 MergeIndex)
+		{
+			const int32 Start = MergeIndex * Width * 2;
+			const int32 Middle = FMath::Min(Start + Width, Num);
+			const int32 End = FMath::Min(Start + Width * 2, Num);
+
+			int32 Left = Start;
+			int32 Right = Middle;
+			int32 Out = Start;
+			while (Left < Middle && Right < End)
+			{
+				Dest[Out++] = Source[Right] < Source[Left] ? Source[Right++] : Source[Left++];
+			}
+			while (Left < Middle)
+			{
+				Dest[Out++] = Source[Left++];
+			}
+			while (Right < End)
+			{
+				Dest[Out++] = Source[Right++];
+			}
+		});
+
+		Swap(Source, Dest);
+	}
+
+	if (Source != InOutPairs.GetData())
+	{
+		Swap(InOutPairs, Buffer);
+	}
+
+	return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PakFileEntry.h"
+#include "Widgets/Views/SHeaderRow.h"
+
+class FFileColumn;
+
+/**
+ * Sorts file rows by keys extracted once per row.
+ * Names and strings are turned into ordinals first, then key/index pairs are sorted with a parallel merge sort and the permutation is applied.
+ */
+class FFileSorter
+{
+public:
+	/** Returns false if the column has no sort key or sorting was cancelled, InOutFiles is left untouched then. */
+	static bool Sort(const FFileColumn& InColumn, EColumnSortMode::Type InSortMode, TArray<FPakFileEntryPtr>& InOutFiles, TFunctionRef<bool()> InIsCancelled);
+
+protected:
+	struct FSortPair
+	{
+		int64 Key;
+		int32 Index;
+
+		bool operator<(const FSortPair& Other) const
+		{
+			return Key < Other.Key || (Key == Other.Key && Index < Other.Index);
+		}
+	};
+
+	struct FStringPair
+	{
+		const TCHAR* String;
+		int32 Index;
+
+		bool operator<(const FStringPair& Other) const
+		{
+			const int32 Result = FCString::Stricmp(String, Other.String);
+			return Result < 0 || (Result == 0 && Index < Other.Index);
+		}
+	};
+
+	static bool BuildNameKeys(const FFileColumn& InColumn, const TArray<FPakFileEntryPtr>& InFiles, TArray<FSortPair>& OutPairs, TFunctionRef<bool()> InIsCancelled);
+	static bool BuildStringKeys(const TArray<const TCHAR*>& InStrings, TArray<int64>& OutRanks, TFunctionRef<bool()> InIsCancelled);
+
+	template <typename PairType>
+	static bool ParallelSort(TArray<PairType>& InOutPairs, TFunctionRef<bool()> InIsCancelled);
+};
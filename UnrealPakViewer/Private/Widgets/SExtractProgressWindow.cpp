@@ -19,17 +19,18 @@ SExtractProgressWindow::SExtractProgressWindow()
 	, bExtractFinished(false)
 {
 	FPakAnalyzerDelegates::OnUpdateExtractProgress.BindRaw(this, &SExtractProgressWindow::OnUpdateExtractProgress);
+	FPakAnalyzerDelegates::OnUpdateExtractWorkerStats.BindRaw(this, &SExtractProgressWindow::OnUpdateExtractWorkerStats);
 }
 
 SExtractProgressWindow::~SExtractProgressWindow()
 {
-
+	FPakAnalyzerDelegates::OnUpdateExtractWorkerStats.Unbind();
 }
 
 void SExtractProgressWindow::Construct(const FArguments& Args)
 {
 	const float DPIScaleFactor = FPlatformApplicationMisc::GetDPIScaleFactorAtPoint(10.0f, 10.0f);
-	const FVector2D InitialWindowDimensions(600, 60);
+	const FVector2D InitialWindowDimensions(600, 120);
 
 	SWindow::Construct(SWindow::FArguments()
 		.Title(LOCTEXT("WindowTitle", "Extracting..."))
@@ -110,6 +111,15 @@ void SExtractProgressWindow::Construct(const FArguments& Args)
 						SNew(SKeyValueRow).KeyStretchCoefficient(0.8f).KeyText(LOCTEXT("Time", "Time:")).ValueText(this, &SExtractProgressWindow::GetTimeElapsed)
 					]
 				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(0.f, 4.f)
+				[
+					SNew(STextBlock)
+					.Text(this, &SExtractProgressWindow::GetWorkerStatsText)
+					.WrapTextAt(InitialWindowDimensions.X * DPIScaleFactor)
+				]
 			]
 		]
 	);
@@ -165,6 +175,34 @@ FORCEINLINE FText SExtractProgressWindow::GetTimeElapsed() const
 	return FText::FromString(ElapsedTime.ToString());
 }
 
+FText SExtractProgressWindow::GetWorkerStatsText() const
+{
+	static const TCHAR* StageNames[] = { TEXT("Read"), TEXT("Decode"), TEXT("Write") };
+
+	// Throughput of a stage is the sum of its workers
+	int32 WorkerCounts[3] = { 0, 0, 0 };
+	double BytesPerSecond[3] = { 0.0, 0.0, 0.0 };
+	double IdleSeconds[3] = { 0.0, 0.0, 0.0 };
+	for (const FExtractWorkerStats& Stats : WorkerStats)
+	{
+		const int32 StageIndex = (int32)Stats.Stage;
+		++WorkerCounts[StageIndex];
+		BytesPerSecond[StageIndex] += Stats.GetBytesPerSecond();
+		IdleSeconds[StageIndex] = FMath::Max(IdleSeconds[StageIndex], Stats.IdleSeconds);
+	}
+
+	FString StatsText;
+	for (int32 i = 0; i < UE_ARRAY_COUNT(StageNames); ++i)
+	{
+		if (WorkerCounts[i] > 0)
+		{
+			StatsText += FString::Printf(TEXT("%s%s x%d: %.1f MB/s, idle %.1fs"), StatsText.IsEmpty() ? TEXT("") : TEXT("    "), StageNames[i], WorkerCounts[i], BytesPerSecond[i] / 1024.0 / 1024.0, IdleSeconds[i]);
+		}
+	}
+
+	return FText::FromString(StatsText);
+}
+
 void SExtractProgressWindow::OnExit(const TSharedRef<SWindow>& InWindow)
 {
 	IPakAnalyzerModule::Get().GetPakAnalyzer()->CancelExtract();
@@ -177,4 +215,9 @@ void SExtractProgressWindow::OnUpdateExtractProgress(int32 InCompleteCount, int3
 	TotalCount = InTotalCount;
 }
 
+void SExtractProgressWindow::OnUpdateExtractWorkerStats(const TArray<FExtractWorkerStats>& InWorkerStats)
+{
+	WorkerStats = InWorkerStats;
+}
+
 #undef LOCTEXT_NAMESPACE
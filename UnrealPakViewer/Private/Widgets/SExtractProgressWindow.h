@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "CommonDefines.h"
 #include "Misc/DateTime.h"
 #include "Widgets/SWindow.h"
 
@@ -35,9 +36,11 @@ protected:
 	FORCEINLINE TOptional<float> GetExtractProgress() const;
 	FORCEINLINE FText GetExtractProgressText() const;
 	FORCEINLINE FText GetTimeElapsed() const;
+	FText GetWorkerStatsText() const;
 
 	void OnExit(const TSharedRef<SWindow>& InWindow);
 	void OnUpdateExtractProgress(int32 InCompleteCount, int32 InErrorCount, int32 InTotalCount);
+	void OnUpdateExtractWorkerStats(const TArray<FExtractWorkerStats>& InWorkerStats);
 
 protected:
 	int32 CompleteCount;
@@ -46,4 +49,5 @@ protected:
 	TAttribute<FDateTime> StartTime;
 	FDateTime LastTime;
 	bool bExtractFinished;
+	TArray<FExtractWorkerStats> WorkerStats;
 };
\ No newline at end of file
@@ -39,6 +39,7 @@ SMainWindow::SMainWindow()
 	FWidgetDelegates::GetOnSwitchToFileViewDelegate().AddRaw(this, &SMainWindow::OnSwitchToFileView);
 	FWidgetDelegates::GetOnSwitchToTreeViewDelegate().AddRaw(this, &SMainWindow::OnSwitchToTreeView);
 	FPakAnalyzerDelegates::OnExtractStart.BindRaw(this, &SMainWindow::OnExtractStart);
+	FPakAnalyzerDelegates::OnVerifyFinish.BindRaw(this, &SMainWindow::OnVerifyFinish);
 }
 
 SMainWindow::~SMainWindow()
@@ -440,6 +441,28 @@ void SMainWindow::OnExtractStart()
 		TStatId(), nullptr, ENamedThreads::GameThread);
 }
 
+void SMainWindow::OnVerifyFinish(const FVerifyResult& InResult)
+{
+	// The full list is in the log
+	static const int32 MaxListedFailures = 20;
+
+	FString Message = FString::Printf(TEXT("Verified %d of %d files, %d failures.\n%.2f MB in %.2fs, %.2f MB/s."),
+		InResult.VerifiedCount, InResult.TotalCount, InResult.Failures.Num(), InResult.VerifiedBytes / 1024.0 / 1024.0, InResult.Seconds, InResult.GetBytesPerSecond() / 1024.0 / 1024.0);
+
+	for (int32 i = 0; i < InResult.Failures.Num() && i < MaxListedFailures; ++i)
+	{
+		const FVerifyFailure& Failure = InResult.Failures[i];
+		Message += FString::Printf(TEXT("\n%s: %s (%s, offset %lld, block %d at %lld)"), *Failure.Reason, *Failure.Path, *Failure.PakName, Failure.Offset, Failure.BlockIndex, Failure.BlockOffset);
+	}
+
+	if (InResult.Failures.Num() > MaxListedFailures)
+	{
+		Message += FString::Printf(TEXT("\n... %d more, see log."), InResult.Failures.Num() - MaxListedFailures);
+	}
+
+	FMessageDialog::Open(EAppMsgType::Ok, FText::FromString(Message));
+}
+
 void SMainWindow::OnLoadRecentFile(int32 InIndex)
 {
 	if (RecentFiles.IsValidIndex(InIndex))
@@ -558,6 +581,7 @@ void SMainWindow::LoadPakFile(const TArray<FString>& PakFilePaths)
 	}
 
 	IPakAnalyzerModule::Get().InitializeAnalyzerBackend(PakFiles[0]);
+	SOptionsWindow::ApplyExtractOptions();
 
 	const bool bLoadResult = IPakAnalyzerModule::Get().GetPakAnalyzer()->LoadPakFiles(PakFiles, CachedAESKeys);
 	if (bLoadResult)
@@ -4,6 +4,7 @@
 #include "Widgets/SWindow.h"
 
 class FSpawnTabArgs;
+struct FVerifyResult;
 
 class SMainWindow : public SWindow
 {
@@ -37,6 +38,7 @@ protected:
 	void OnSwitchToTreeView(const FString& InPath, int32 PakIndex);
 	void OnSwitchToFileView(const FString& InPath, int32 PakIndex);
 	void OnExtractStart();
+	void OnVerifyFinish(const FVerifyResult& InResult);
 	void OnLoadRecentFile(int32 InIndex);
 	bool OnLoadRecentFileCanExecute(int32 InIndex) const;
 
@@ -26,8 +26,25 @@ void SOptionsWindow::Construct(const FArguments& Args)
 	int32 DefaultThreadCount = DEFAULT_EXTRACT_THREAD_COUNT;
 	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractThreadCount"), DefaultThreadCount, GEngineIni);
 
+	int32 DefaultReadThreadCount = DEFAULT_EXTRACT_READ_THREAD_COUNT;
+	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractReadThreadCount"), DefaultReadThreadCount, GEngineIni);
+
+	int32 DefaultWriteThreadCount = DEFAULT_EXTRACT_WRITE_THREAD_COUNT;
+	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractWriteThreadCount"), DefaultWriteThreadCount, GEngineIni);
+
+	int32 DefaultExtractMode = (int32)EExtractMode::Full;
+	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractMode"), DefaultExtractMode, GEngineIni);
+
+	ExtractModes.Add(MakeShared<EExtractMode>(EExtractMode::Full));
+	ExtractModes.Add(MakeShared<EExtractMode>(EExtractMode::Resume));
+	ExtractModes.Add(MakeShared<EExtractMode>(EExtractMode::Incremental));
+	SelectedExtractMode = ExtractModes.IsValidIndex(DefaultExtractMode) ? ExtractModes[DefaultExtractMode] : ExtractModes[0];
+
+	bool bDefaultDeduplicate = false;
+	GConfig->GetBool(TEXT("UnrealPakViewer"), TEXT("ExtractDeduplicate"), bDefaultDeduplicate, GEngineIni);
+
 	const float DPIScaleFactor = FPlatformApplicationMisc::GetDPIScaleFactorAtPoint(10.0f, 10.0f);
-	const FVector2D InitialWindowDimensions(600, 70);
+	const FVector2D InitialWindowDimensions(600, 185);
 
 	SWindow::Construct(SWindow::FArguments()
 		.Title(LOCTEXT("WindowTitle", "Options"))
@@ -45,6 +62,28 @@ void SOptionsWindow::Construct(const FArguments& Args)
 
 				+ SVerticalBox::Slot()
 				.AutoHeight()
+				.Padding(0.f, 2.f)
+				[
+					MakeThreadCountRow(LOCTEXT("ExtractReadThreadCountText", "Extract read thread count:"), ReadThreadCountBox, DefaultReadThreadCount)
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(0.f, 2.f)
+				[
+					MakeThreadCountRow(LOCTEXT("ExtractThreadCountText", "Extract decompress thread count:"), ThreadCountBox, DefaultThreadCount)
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(0.f, 2.f)
+				[
+					MakeThreadCountRow(LOCTEXT("ExtractWriteThreadCountText", "Extract write thread count:"), WriteThreadCountBox, DefaultWriteThreadCount)
+				]
+
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(0.f, 2.f)
 				[
 					SNew(SHorizontalBox)
 
@@ -54,21 +93,37 @@ void SOptionsWindow::Construct(const FArguments& Args)
 					.VAlign(EVerticalAlignment::VAlign_Center)
 					.Padding(FMargin(0.f, 0.f, 5.f, 0.f))
 					[
-						SNew(STextBlock).Text(LOCTEXT("ExtractThreadCountText", "Extract thread count:"))
+						SNew(SBox).MinDesiredWidth(200)
+						[
+							SNew(STextBlock).Text(LOCTEXT("ExtractModeText", "Extract mode:"))
+						]
 					]
 
 					+ SHorizontalBox::Slot()
 					.FillWidth(1.f)
 					.Padding(FMargin(0.f, 0.f, 5.f, 0.f))
 					[
-						SAssignNew(ThreadCountBox, SSpinBox<int32>).MinValue(1).MaxValue(FPlatformMisc::NumberOfCoresIncludingHyperthreads()).Value(DefaultThreadCount)
+						SNew(SComboBox<TSharedPtr<EExtractMode>>)
+						.OptionsSource(&ExtractModes)
+						.InitiallySelectedItem(SelectedExtractMode)
+						.OnGenerateWidget(this, &SOptionsWindow::OnGenerateExtractModeWidget)
+						.OnSelectionChanged_Lambda([this](TSharedPtr<EExtractMode> InMode, ESelectInfo::Type) { if (InMode.IsValid()) { SelectedExtractMode = InMode; } })
+						.Content()
+						[
+							SNew(STextBlock).Text_Lambda([this]() { return GetExtractModeText(*SelectedExtractMode); })
+						]
 					]
+				]
 
-					+ SHorizontalBox::Slot()
-					.AutoWidth()
-					.Padding(FMargin(0.f, 0.f, 5.f, 0.f))
+				+ SVerticalBox::Slot()
+				.AutoHeight()
+				.Padding(0.f, 2.f)
+				[
+					SAssignNew(DeduplicateCheckBox, SCheckBox)
+					.IsChecked(bDefaultDeduplicate ? ECheckBoxState::Checked : ECheckBoxState::Unchecked)
+					.ToolTipText(LOCTEXT("ExtractDeduplicateTip", "Files with the same content hash are extracted once, the others become hardlinks or copies of it."))
 					[
-						SNew(STextBlock).Text(FText::Format(LOCTEXT("LimitRangeText", "(1 ~ {0})"), FPlatformMisc::NumberOfCoresIncludingHyperthreads()))
+						SNew(STextBlock).Text(LOCTEXT("ExtractDeduplicateText", "Deduplicate identical files"))
 					]
 				]
 
@@ -106,13 +161,90 @@ void SOptionsWindow::Construct(const FArguments& Args)
 	);
 }
 
+TSharedRef<SWidget> SOptionsWindow::MakeThreadCountRow(const FText& InLabel, TSharedPtr<SSpinBox<int32>>& OutSpinBox, int32 InValue)
+{
+	return SNew(SHorizontalBox)
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.HAlign(EHorizontalAlignment::HAlign_Left)
+		.VAlign(EVerticalAlignment::VAlign_Center)
+		.Padding(FMargin(0.f, 0.f, 5.f, 0.f))
+		[
+			SNew(SBox).MinDesiredWidth(200)
+			[
+				SNew(STextBlock).Text(InLabel)
+			]
+		]
+
+		+ SHorizontalBox::Slot()
+		.FillWidth(1.f)
+		.Padding(FMargin(0.f, 0.f, 5.f, 0.f))
+		[
+			SAssignNew(OutSpinBox, SSpinBox<int32>).MinValue(1).MaxValue(FPlatformMisc::NumberOfCoresIncludingHyperthreads()).Value(InValue)
+		]
+
+		+ SHorizontalBox::Slot()
+		.AutoWidth()
+		.Padding(FMargin(0.f, 0.f, 5.f, 0.f))
+		[
+			SNew(STextBlock).Text(FText::Format(LOCTEXT("LimitRangeText", "(1 ~ {0})"), FPlatformMisc::NumberOfCoresIncludingHyperthreads()))
+		];
+}
+
+TSharedRef<SWidget> SOptionsWindow::OnGenerateExtractModeWidget(TSharedPtr<EExtractMode> InMode) const
+{
+	return SNew(STextBlock).Text(GetExtractModeText(*InMode)).Margin(FMargin(2.f, 2.f, 2.f, 2.f));
+}
+
+FText SOptionsWindow::GetExtractModeText(EExtractMode InMode)
+{
+	switch (InMode)
+	{
+	case EExtractMode::Resume:
+		return LOCTEXT("ExtractModeResume", "Resume (skip journaled files that exist with the same size)");
+	case EExtractMode::Incremental:
+		return LOCTEXT("ExtractModeIncremental", "Incremental (only write files whose hash changed)");
+	default:
+		return LOCTEXT("ExtractModeFull", "Full");
+	}
+}
+
+void SOptionsWindow::ApplyExtractOptions()
+{
+	IPakAnalyzer* PakAnalyzer = IPakAnalyzerModule::Get().GetPakAnalyzer();
+	if (!PakAnalyzer)
+	{
+		return;
+	}
+
+	int32 ThreadCount = DEFAULT_EXTRACT_THREAD_COUNT;
+	int32 ReadThreadCount = DEFAULT_EXTRACT_READ_THREAD_COUNT;
+	int32 WriteThreadCount = DEFAULT_EXTRACT_WRITE_THREAD_COUNT;
+	int32 ExtractMode = (int32)EExtractMode::Full;
+	bool bDeduplicate = false;
+	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractThreadCount"), ThreadCount, GEngineIni);
+	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractReadThreadCount"), ReadThreadCount, GEngineIni);
+	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractWriteThreadCount"), WriteThreadCount, GEngineIni);
+	GConfig->GetInt(TEXT("UnrealPakViewer"), TEXT("ExtractMode"), ExtractMode, GEngineIni);
+	GConfig->GetBool(TEXT("UnrealPakViewer"), TEXT("ExtractDeduplicate"), bDeduplicate, GEngineIni);
+
+	PakAnalyzer->SetExtractThreadCount(ThreadCount);
+	PakAnalyzer->SetExtractIOThreadCount(ReadThreadCount, WriteThreadCount);
+	PakAnalyzer->SetExtractMode((EExtractMode)FMath::Clamp(ExtractMode, (int32)EExtractMode::Full, (int32)EExtractMode::Incremental));
+	PakAnalyzer->SetExtractDeduplicate(bDeduplicate);
+}
+
 FReply SOptionsWindow::OnApply()
 {
-	const int32 ThreadCount = ThreadCountBox->GetValueAttribute().Get();
-	GConfig->SetInt(TEXT("UnrealPakViewer"), TEXT("ExtractThreadCount"), ThreadCount, GEngineIni);
+	GConfig->SetInt(TEXT("UnrealPakViewer"), TEXT("ExtractThreadCount"), ThreadCountBox->GetValueAttribute().Get(), GEngineIni);
+	GConfig->SetInt(TEXT("UnrealPakViewer"), TEXT("ExtractReadThreadCount"), ReadThreadCountBox->GetValueAttribute().Get(), GEngineIni);
+	GConfig->SetInt(TEXT("UnrealPakViewer"), TEXT("ExtractWriteThreadCount"), WriteThreadCountBox->GetValueAttribute().Get(), GEngineIni);
+	GConfig->SetInt(TEXT("UnrealPakViewer"), TEXT("ExtractMode"), (int32)*SelectedExtractMode, GEngineIni);
+	GConfig->SetBool(TEXT("UnrealPakViewer"), TEXT("ExtractDeduplicate"), DeduplicateCheckBox->IsChecked(), GEngineIni);
 	GConfig->Flush(false, GEngineIni);
 
-	IPakAnalyzerModule::Get().GetPakAnalyzer()->SetExtractThreadCount(ThreadCount);
+	ApplyExtractOptions();
 
 	RequestDestroyWindow();
 
@@ -1,9 +1,13 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SComboBox.h"
 #include "Widgets/Input/SSpinBox.h"
 #include "Widgets/SWindow.h"
 
+#include "CommonDefines.h"
+
 class SOptionsWindow : public SWindow
 {
 public:
@@ -18,10 +22,24 @@ public:
 	/** Widget constructor */
 	void Construct(const FArguments& Args);
 
+	/** Applies the saved extract options to the current analyzer. */
+	static void ApplyExtractOptions();
+
 protected:
+	TSharedRef<SWidget> MakeThreadCountRow(const FText& InLabel, TSharedPtr<SSpinBox<int32>>& OutSpinBox, int32 InValue);
+
+	TSharedRef<SWidget> OnGenerateExtractModeWidget(TSharedPtr<EExtractMode> InMode) const;
+	static FText GetExtractModeText(EExtractMode InMode);
+
 	FReply OnApply();
 	FReply OnCancel();
 
 protected:
 	TSharedPtr<SSpinBox<int32>> ThreadCountBox;
+	TSharedPtr<SSpinBox<int32>> ReadThreadCountBox;
+	TSharedPtr<SSpinBox<int32>> WriteThreadCountBox;
+
+	TArray<TSharedPtr<EExtractMode>> ExtractModes;
+	TSharedPtr<EExtractMode> SelectedExtractMode;
+	TSharedPtr<SCheckBox> DeduplicateCheckBox;
 };
\ No newline at end of file
@@ -349,7 +349,7 @@ void SPakClassView::Reload(FPakTreeEntryPtr InFolder)
 
 	if (InFolder.IsValid())
 	{
-		for (const auto& Pair : InFolder->FileClassMap)
+		for (const auto& Pair : InFolder->GetFileClassMap())
 		{
 			ClassCache.Add(Pair.Value);
 		}
@@ -7,8 +7,11 @@
 #include "Framework/Application/SlateApplication.h"
 #include "Json.h"
 #include "HAL/PlatformApplicationMisc.h"
+#include "HAL/PlatformTime.h"
 #include "IPlatformFilePak.h"
+#include "Misc/ConfigCacheIni.h"
 #include "Misc/Guid.h"
+#include "Misc/MessageDialog.h"
 #include "Styling/CoreStyle.h"
 #include "Widgets/Layout/SBorder.h"
 #include "Widgets/Layout/SBox.h"
@@ -211,7 +214,7 @@ protected:
 		FPakFileEntryPtr PakFileItemPin = WeakPakFileItem.Pin();
 		if (PakFileItemPin.IsValid())
 		{
-			return FText::FromString(PakFileItemPin->Path);
+			return FText::FromString(PakFileItemPin->Path.ToString());
 		}
 		else
 		{
@@ -463,6 +466,8 @@ SPakFileView::~SPakFileView()
 
 	if (SortAndFilterTask.IsValid())
 	{
+		// Stops work in flight at the next chunk
+		InnderTask->SetRequestedGeneration(++SortAndFilterGeneration);
 		SortAndFilterTask->Cancel();
 		SortAndFilterTask->EnsureCompletion();
 	}
@@ -538,7 +543,7 @@ void SPakFileView::Construct(const FArguments& InArgs)
 						+ SHorizontalBox::Slot().FillWidth(1.f).Padding(0.f)
 						[
 							SAssignNew(SearchBox, SSearchBox)
-							.HintText(LOCTEXT("SearchBoxHint", "Search files"))
+							.HintText(LOCTEXT("SearchBoxHint", "Search files, e.g. hero class:Texture2D size>4MB pak:pakchunk3 ratio<0.5 encrypted:true"))
 							.OnTextChanged(this, &SPakFileView::OnSearchBoxTextChanged)
 							.IsEnabled(this, &SPakFileView::SearchBoxIsEnabled)
 							.ToolTipText(LOCTEXT("FilterSearchHint", "Type here to search files"))
@@ -563,7 +568,7 @@ void SPakFileView::Construct(const FArguments& InArgs)
 				.ItemHeight(20.f)
 				.SelectionMode(ESelectionMode::Multi)
 				//.OnMouseButtonClick()
-				//.OnSelectiongChanged()
+				.OnSelectionChanged(this, &SPakFileView::OnSelectionChanged)
 				.ListItemsSource(&FileCache)
 				.OnGenerateRow(this, &SPakFileView::OnGenerateFileRow)
 				.ConsumeMouseWheel(EConsumeMouseWheel::Always)
@@ -586,6 +591,8 @@ void SPakFileView::Construct(const FArguments& InArgs)
 
 	InnderTask->GetOnSortAndFilterFinishedDelegate().BindRaw(this, &SPakFileView::OnSortAndFilterFinihed);
 
+	GConfig->GetFloat(TEXT("UnrealPakViewer"), TEXT("SearchDebounceDelay"), SearchDebounceDelay, GEngineIni);
+
 	FilesSummary = MakeShared<FPakFileEntry>(TEXT("Total"), TEXT("Total"));
 }
 
@@ -594,7 +601,8 @@ void SPakFileView::Tick(const FGeometry& AllottedGeometry, const double InCurren
 	IPakAnalyzer* PakAnalyzer = IPakAnalyzerModule::Get().GetPakAnalyzer();
 	if (PakAnalyzer)
 	{
-		if (bIsDirty)
+		const bool bDebouncing = FPlatformTime::Seconds() - LastSearchTextChangeTime < SearchDebounceDelay;
+		if (bIsDirty && !bDebouncing)
 		{
 			if (SortAndFilterTask->IsDone())
 			{
@@ -606,7 +614,8 @@ void SPakFileView::Tick(const FGeometry& AllottedGeometry, const double InCurren
 					IndexFilterMap.Add(i, PakFilterMap[i].bShow);
 				}
 
-				InnderTask->SetWorkInfo(CurrentSortedColumn, CurrentSortMode, CurrentSearchText, ClassFilterMap, IndexFilterMap);
+				InnderTask->SetWorkInfo(CurrentSortedColumn, CurrentSortMode, CurrentSearchText, ClassFilterMap, IndexFilterMap, bFilesChanged, SortAndFilterGeneration);
+				bFilesChanged = false;
 				SortAndFilterTask->StartBackgroundTask();
 			}
 		}
@@ -635,6 +644,7 @@ void SPakFileView::OnSearchBoxTextChanged(const FText& InFilterText)
 	}
 
 	CurrentSearchText = InFilterText.ToString();
+	LastSearchTextChangeTime = FPlatformTime::Seconds();
 	MarkDirty(true);
 }
 
@@ -662,6 +672,32 @@ TSharedPtr<SWidget> SPakFileView::OnGenerateContextMenu()
 			),
 			NAME_None, EUserInterfaceActionType::Button
 		);
+
+		MenuBuilder.AddMenuEntry
+		(
+			LOCTEXT("ContextMenu_Extract_To_Tar", "Extract To Tar..."),
+			LOCTEXT("ContextMenu_Extract_To_Tar_Desc", "Extract selected files into a single tar archive"),
+			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Extract"),
+			FUIAction
+			(
+				FExecuteAction::CreateSP(this, &SPakFileView::OnExtractToArchive),
+				FCanExecuteAction::CreateSP(this, &SPakFileView::HasFileSelected)
+			),
+			NAME_None, EUserInterfaceActionType::Button
+		);
+
+		MenuBuilder.AddMenuEntry
+		(
+			LOCTEXT("ContextMenu_Verify", "Verify"),
+			LOCTEXT("ContextMenu_Verify_Desc", "Check hashes of selected files without writing them"),
+			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Find"),
+			FUIAction
+			(
+				FExecuteAction::CreateSP(this, &SPakFileView::OnVerify),
+				FCanExecuteAction::CreateSP(this, &SPakFileView::HasFileSelected)
+			),
+			NAME_None, EUserInterfaceActionType::Button
+		);
 	}
 	MenuBuilder.EndSection();
 
@@ -675,7 +711,7 @@ TSharedPtr<SWidget> SPakFileView::OnGenerateContextMenu()
 			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Export"),
 			FUIAction
 			(
-				FExecuteAction::CreateSP(this, &SPakFileView::OnExportToJson),
+				FExecuteAction::CreateSP(this, &SPakFileView::OnExportToJson, false),
 				FCanExecuteAction::CreateSP(this, &SPakFileView::HasFileSelected)
 			),
 			NAME_None, EUserInterfaceActionType::Button
@@ -688,11 +724,37 @@ TSharedPtr<SWidget> SPakFileView::OnGenerateContextMenu()
 			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Export"),
 			FUIAction
 			(
-				FExecuteAction::CreateSP(this, &SPakFileView::OnExportToCsv),
+				FExecuteAction::CreateSP(this, &SPakFileView::OnExportToCsv, false),
 				FCanExecuteAction::CreateSP(this, &SPakFileView::HasFileSelected)
 			),
 			NAME_None, EUserInterfaceActionType::Button
 		);
+
+		MenuBuilder.AddMenuEntry
+		(
+			LOCTEXT("ContextMenu_Export_Query_To_Json", "Export Search Result To Json..."),
+			LOCTEXT("ContextMenu_Export_Query_To_Json_Desc", "Export info of all files matching the current search query to json"),
+			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Export"),
+			FUIAction
+			(
+				FExecuteAction::CreateSP(this, &SPakFileView::OnExportToJson, true),
+				FCanExecuteAction::CreateSP(this, &SPakFileView::HasQueryResult)
+			),
+			NAME_None, EUserInterfaceActionType::Button
+		);
+
+		MenuBuilder.AddMenuEntry
+		(
+			LOCTEXT("ContextMenu_Export_Query_To_Csv", "Export Search Result To Csv..."),
+			LOCTEXT("ContextMenu_Export_Query_To_Csv_Desc", "Export info of all files matching the current search query to csv"),
+			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Export"),
+			FUIAction
+			(
+				FExecuteAction::CreateSP(this, &SPakFileView::OnExportToCsv, true),
+				FCanExecuteAction::CreateSP(this, &SPakFileView::HasQueryResult)
+			),
+			NAME_None, EUserInterfaceActionType::Button
+		);
 	}
 	MenuBuilder.EndSection();
 
@@ -978,7 +1040,7 @@ void SPakFileView::FillClassesFilter()
 		const TArray<FPakTreeEntryPtr>& TreeRoots = PakAnalyzer->GetPakTreeRootNode();
 		for (const FPakTreeEntryPtr& TreeRoot : TreeRoots)
 		{
-			for (const auto& Pair : TreeRoot->FileClassMap)
+			for (const auto& Pair : TreeRoot->GetFileClassMap())
 			{
 				ClassFilterMap.Add(Pair.Key, true);
 			}
@@ -1068,6 +1130,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->Filename.LexicalLess(A->Filename);
 		}
 	);
+	NameColumn.SetNameSortKey([](const FPakFileEntry& InEntry) -> FName { return InEntry.Filename; });
 
 	// Path Column
 	FFileColumn& PathColumn = FileColumns.Emplace(FFileColumn::PathColumnName, FFileColumn(1, FFileColumn::PathColumnName, LOCTEXT("PathColumn", "Path"), LOCTEXT("PathColumnTip", "File path in pak"), 3.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1083,6 +1146,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->Path < A->Path;
 		}
 	);
+	PathColumn.SetStringSortKey([](const FPakFileEntry& InEntry) -> const TCHAR* { return *InEntry.Path; });
 
 	// Class Column
 	FFileColumn& ClassColumn = FileColumns.Emplace(FFileColumn::ClassColumnName, FFileColumn(2, FFileColumn::ClassColumnName, LOCTEXT("ClassColumn", "Class"), LOCTEXT("ClassColumnTip", "Class name in asset registry or file extension if not found"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1098,6 +1162,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->Class.LexicalLess(A->Class);
 		}
 	);
+	ClassColumn.SetNameSortKey([](const FPakFileEntry& InEntry) -> FName { return InEntry.Class; });
 
 	// Dependency Count Column
 	FFileColumn& DependencyCountColumn = FileColumns.Emplace(FFileColumn::DependencyCountColumnName, FFileColumn(3, FFileColumn::DependencyCountColumnName, LOCTEXT("DependencyCountColumn", "Dependency Count"), LOCTEXT("DependencyCountColumnTip", "Packages this package depends on"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1117,6 +1182,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return BCount < ACount;
 		}
 	);
+	DependencyCountColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.AssetSummary.IsValid() ? InEntry.AssetSummary->DependencyList.Num() : 0; });
 
 	// Dependent Count Column
 	FFileColumn& DependentCountColumn = FileColumns.Emplace(FFileColumn::DependentCountColumnName, FFileColumn(4, FFileColumn::DependentCountColumnName, LOCTEXT("DependentCountColumn", "Dependent Count"), LOCTEXT("DependentCountColumnTip", "Packages depend on this package"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1136,6 +1202,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return BCount < ACount;
 		}
 	);
+	DependentCountColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.AssetSummary.IsValid() ? InEntry.AssetSummary->DependentList.Num() : 0; });
 
 	// Offset Column
 	FFileColumn& OffsetColumn = FileColumns.Emplace(FFileColumn::OffsetColumnName, FFileColumn(5, FFileColumn::OffsetColumnName, LOCTEXT("OffsetColumn", "Offset"), LOCTEXT("OffsetColumnTip", "File offset in pak"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1151,6 +1218,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->PakEntry.Offset < A->PakEntry.Offset;
 		}
 	);
+	OffsetColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.PakEntry.Offset; });
 
 	// Size Column
 	FFileColumn& SizeColumn = FileColumns.Emplace(FFileColumn::SizeColumnName, FFileColumn(6, FFileColumn::SizeColumnName, LOCTEXT("SizeColumn", "Size"), LOCTEXT("SizeColumnTip", "File original size"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1166,6 +1234,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->PakEntry.UncompressedSize < A->PakEntry.UncompressedSize;
 		}
 	);
+	SizeColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.PakEntry.UncompressedSize; });
 	
 	// Compressed Size Column
 	FFileColumn& CompressedSizeColumn = FileColumns.Emplace(FFileColumn::CompressedSizeColumnName, FFileColumn(7, FFileColumn::CompressedSizeColumnName, LOCTEXT("CompressedSizeColumn", "Compressed Size"), LOCTEXT("CompressedSizeColumnTip", "File compressed size"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1181,6 +1250,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->PakEntry.Size < A->PakEntry.Size;
 		}
 	);
+	CompressedSizeColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.PakEntry.Size; });
 	
 	// Compressed Block Count
 	FFileColumn& CompressionBlockCountColumn = FileColumns.Emplace(FFileColumn::CompressionBlockCountColumnName, FFileColumn(8, FFileColumn::CompressionBlockCountColumnName, LOCTEXT("CompressionBlockCountColumn", "Compression Block Count"), LOCTEXT("CompressionBlockCountColumnTip", "File compression block count"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeFiltered | EFileColumnFlags::CanBeHidden));
@@ -1196,6 +1266,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->PakEntry.CompressionBlocks.Num() < A->PakEntry.CompressionBlocks.Num();
 		}
 	);
+	CompressionBlockCountColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.PakEntry.CompressionBlocks.Num(); });
 	
 	// Compressed Block Size
 	FileColumns.Emplace(FFileColumn::CompressionBlockSizeColumnName, FFileColumn(9, FFileColumn::CompressionBlockSizeColumnName, LOCTEXT("CompressionBlockSizeColumn", "Compression Block Size"), LOCTEXT("CompressionBlockSizeColumnTip", "File compression block size"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeHidden));
@@ -1214,6 +1285,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->CompressionMethod.LexicalLess(A->CompressionMethod);
 		}
 	);
+	CompressionMethodColumn.SetNameSortKey([](const FPakFileEntry& InEntry) -> FName { return InEntry.CompressionMethod; });
 	
 	// Owner Pak
 	FFileColumn& OwnerPakColumn = FileColumns.Emplace(FFileColumn::OwnerPakColumnName, FFileColumn(11, FFileColumn::OwnerPakColumnName, LOCTEXT("OwnerPakColumn", "Onwer Pak"), LOCTEXT("OnwerPakColumnTip", "Owner Pak Name"), 2.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeHidden | EFileColumnFlags::CanBeFiltered));
@@ -1229,6 +1301,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->OwnerPakIndex < A->OwnerPakIndex;
 		}
 	);
+	OwnerPakColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.OwnerPakIndex; });
 
 	// SHA1
 	FileColumns.Emplace(FFileColumn::SHA1ColumnName, FFileColumn(12, FFileColumn::SHA1ColumnName, LOCTEXT("SHA1Column", "SHA1"), LOCTEXT("SHA1ColumnTip", "File sha1"), 1.f, EFileColumnFlags::ShouldBeVisible | EFileColumnFlags::CanBeHidden));
@@ -1247,6 +1320,7 @@ void SPakFileView::InitializeAndShowHeaderColumns()
 			return B->PakEntry.IsEncrypted() < A->PakEntry.IsEncrypted();
 		}
 	);
+	IsEncryptedColumn.SetIntegerSortKey([](const FPakFileEntry& InEntry) -> int64 { return InEntry.PakEntry.IsEncrypted() ? 1 : 0; });
 
 	// Show columns.
 	for (const auto& ColumnPair : FileColumns)
@@ -1460,7 +1534,7 @@ void SPakFileView::OnCopyAllColumnsExecute()
 				TSharedRef<FJsonObject> FileObject = MakeShareable(new FJsonObject);
 
 				FileObject->SetStringField(TEXT("Name"), PakFileItem->Filename.ToString());
-				FileObject->SetStringField(TEXT("Path"), PakFileItem->Path);
+				FileObject->SetStringField(TEXT("Path"), PakFileItem->Path.ToString());
 				FileObject->SetNumberField(TEXT("Offset"), PakEntry->Offset);
 				FileObject->SetNumberField(TEXT("Size"), PakEntry->UncompressedSize);
 				FileObject->SetNumberField(TEXT("Compressed Size"), PakEntry->Size);
@@ -1505,7 +1579,7 @@ void SPakFileView::OnCopyColumnExecute(const FName ColumnId)
 			}
 			else if (ColumnId == FFileColumn::PathColumnName)
 			{
-				Values.Add(PakFileItem->Path);
+				Values.Add(PakFileItem->Path.ToString());
 			}
 			else if (ColumnId == FFileColumn::ClassColumnName)
 			{
@@ -1568,31 +1642,38 @@ void SPakFileView::OnJumpToTreeViewExecute()
 
 	if (SelectedItems.Num() > 0 && SelectedItems[0].IsValid())
 	{
-		FWidgetDelegates::GetOnSwitchToTreeViewDelegate().Broadcast(SelectedItems[0]->Path, SelectedItems[0]->OwnerPakIndex);
+		FWidgetDelegates::GetOnSwitchToTreeViewDelegate().Broadcast(SelectedItems[0]->Path.ToString(), SelectedItems[0]->OwnerPakIndex);
 	}
 }
 
 void SPakFileView::MarkDirty(bool bInIsDirty)
 {
 	bIsDirty = bInIsDirty;
+
+	if (bInIsDirty && InnderTask)
+	{
+		// Outdates the work in flight, it stops at the next chunk and the new request starts as soon as it is done
+		SortAndFilterRequestTime = FPlatformTime::Seconds();
+		InnderTask->SetRequestedGeneration(++SortAndFilterGeneration);
+	}
 }
 
-void SPakFileView::OnSortAndFilterFinihed(const FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText)
+void SPakFileView::OnSortAndFilterFinihed(const FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText, uint32 InGeneration)
 {
-	FFunctionGraphTask::CreateAndDispatchWhenReady([this, InSearchText]()
+	FFunctionGraphTask::CreateAndDispatchWhenReady([this, InGeneration]()
 		{
-			IPakAnalyzer* PakAnalyzer = IPakAnalyzerModule::Get().GetPakAnalyzer();
+			if (InGeneration != SortAndFilterGeneration)
+			{
+				// Inputs changed during sort or filter, a newer generation is pending
+				return;
+			}
 
-			InnderTask->RetriveResult(FileCache);
+			InnderTask->RetriveResult(FileCache, FileCacheRows);
 			FillFilesSummary();
 
 			FileListView->RebuildList();
 
-			if (!InSearchText.Equals(CurrentSearchText, ESearchCase::IgnoreCase))
-			{
-				// Search text changed during sort or filter
-				MarkDirty(true);
-			}
+			UE_LOG(LogPakAnalyzer, Log, TEXT("Sort and filter generation %u: %d files shown %.3fs after request."), InGeneration, FMath::Max(FileCache.Num() - 1, 0), FPlatformTime::Seconds() - SortAndFilterRequestTime);
 		},
 		TStatId(), nullptr, ENamedThreads::GameThread);
 }
@@ -1620,7 +1701,12 @@ bool SPakFileView::IsFileListEmpty() const
 	return FileCache.Num() - 1 <= 0;
 }
 
-void SPakFileView::OnExportToJson()
+bool SPakFileView::HasQueryResult() const
+{
+	return !IsFileListEmpty();
+}
+
+void SPakFileView::OnExportToJson(bool bInQueryResult)
 {
 	bool bOpened = false;
 	TArray<FString> OutFileNames;
@@ -1646,12 +1732,19 @@ void SPakFileView::OnExportToJson()
 	}
 
 	TArray<FPakFileEntryPtr> SelectedItems;
-	GetSelectedItems(SelectedItems);
+	if (bInQueryResult)
+	{
+		GetQueryResult(SelectedItems);
+	}
+	else
+	{
+		GetSelectedItems(SelectedItems);
+	}
 
 	IPakAnalyzerModule::Get().GetPakAnalyzer()->ExportToJson(OutFileNames[0], SelectedItems);
 }
 
-void SPakFileView::OnExportToCsv()
+void SPakFileView::OnExportToCsv(bool bInQueryResult)
 {
 	bool bOpened = false;
 	TArray<FString> OutFileNames;
@@ -1677,7 +1770,14 @@ void SPakFileView::OnExportToCsv()
 	}
 
 	TArray<FPakFileEntryPtr> SelectedItems;
-	GetSelectedItems(SelectedItems);
+	if (bInQueryResult)
+	{
+		GetQueryResult(SelectedItems);
+	}
+	else
+	{
+		GetSelectedItems(SelectedItems);
+	}
 
 	IPakAnalyzerModule::Get().GetPakAnalyzer()->ExportToCsv(OutFileNames[0], SelectedItems);
 }
@@ -1710,11 +1810,53 @@ void SPakFileView::OnExtract()
 	IPakAnalyzerModule::Get().GetPakAnalyzer()->ExtractFiles(OutputPath, SelectedItems);
 }
 
+void SPakFileView::OnExtractToArchive()
+{
+	bool bOpened = false;
+	TArray<FString> OutFileNames;
+
+	IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+	if (DesktopPlatform)
+	{
+		FSlateApplication::Get().CloseToolTip();
+
+		bOpened = DesktopPlatform->SaveFileDialog(
+			FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+			LOCTEXT("OpenExtractArchiveDialogTitleText", "Select output tar file path...").ToString(),
+			TEXT(""),
+			TEXT(""),
+			TEXT("Tar Files (*.tar)|*.tar|All Files (*.*)|*.*"),
+			EFileDialogFlags::None,
+			OutFileNames);
+	}
+
+	if (!bOpened || OutFileNames.Num() <= 0)
+	{
+		return;
+	}
+
+	TArray<FPakFileEntryPtr> SelectedItems;
+	GetSelectedItems(SelectedItems);
+
+	if (!IPakAnalyzerModule::Get().GetPakAnalyzer()->ExtractFilesToArchive(OutFileNames[0], SelectedItems))
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ExtractToArchiveMixedText", "Pak and IoStore files can not be written into one archive, extract them separately."));
+	}
+}
+
+void SPakFileView::OnVerify()
+{
+	TArray<FPakFileEntryPtr> SelectedItems;
+	GetSelectedItems(SelectedItems);
+
+	IPakAnalyzerModule::Get().GetPakAnalyzer()->VerifyFiles(SelectedItems);
+}
+
 void SPakFileView::ScrollToItem(const FString& InPath, int32 PakIndex)
 {
 	for (const FPakFileEntryPtr FileEntry : FileCache)
 	{
-		if (FileEntry->Path.Equals(InPath, ESearchCase::IgnoreCase) && FileEntry->OwnerPakIndex == PakIndex)
+		if (FCString::Stricmp(*FileEntry->Path, *InPath) == 0 && FileEntry->OwnerPakIndex == PakIndex)
 		{
 			TArray<FPakFileEntryPtr> SelectArray = { FileEntry };
 			FileListView->SetItemSelection(SelectArray, true, ESelectInfo::Direct);
@@ -1728,6 +1870,7 @@ void SPakFileView::OnLoadAssetReigstryFinished()
 {
 	FillClassesFilter();
 
+	bFilesChanged = true;
 	MarkDirty(true);
 }
 
@@ -1736,6 +1879,7 @@ void SPakFileView::OnLoadPakFinished()
 	FillClassesFilter();
 	FillPaksFilter();
 
+	bFilesChanged = true;
 	MarkDirty(true);
 }
 
@@ -1743,9 +1887,39 @@ void SPakFileView::OnParseAssetFinished()
 {
 	FillClassesFilter();
 
+	bFilesChanged = true;
 	MarkDirty(true);
 }
 
+void SPakFileView::OnSelectionChanged(FPakFileEntryPtr SelectedItem, ESelectInfo::Type SelectInfo)
+{
+	// Rows around the selection are likely to be viewed next
+	static const int32 NeighbourCount = 16;
+
+	const int32* SelectedRow = SelectedItem.IsValid() ? FileCacheRows.Find(SelectedItem.Get()) : nullptr;
+	if (!SelectedRow)
+	{
+		return;
+	}
+
+	const int32 SelectedIndex = *SelectedRow;
+
+	TArray<FPakFileEntryPtr> PriorityFiles;
+	PriorityFiles.Add(SelectedItem);
+	for (int32 Distance = 1; Distance <= NeighbourCount; ++Distance)
+	{
+		for (const int32 Index : { SelectedIndex + Distance, SelectedIndex - Distance })
+		{
+			if (FileCache.IsValidIndex(Index) && !FileCache[Index]->AssetSummary.IsValid())
+			{
+				PriorityFiles.Add(FileCache[Index]);
+			}
+		}
+	}
+
+	IPakAnalyzerModule::Get().GetPakAnalyzer()->PrioritizeAssetParse(PriorityFiles);
+}
+
 void SPakFileView::FillFilesSummary()
 {
 	FilesSummary->PakEntry.Offset = 0;
@@ -1764,6 +1938,12 @@ void SPakFileView::FillFilesSummary()
 	}
 }
 
+void SPakFileView::GetQueryResult(TArray<FPakFileEntryPtr>& OutFiles) const
+{
+	OutFiles = FileCache;
+	OutFiles.Remove(FilesSummary);
+}
+
 bool SPakFileView::GetSelectedItems(TArray<FPakFileEntryPtr>& OutSelectedItems) const
 {
 	if (FileListView.IsValid())
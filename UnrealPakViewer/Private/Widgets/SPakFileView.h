@@ -103,24 +103,29 @@ protected:
 	void OnJumpToTreeViewExecute();
 
 	void MarkDirty(bool bInIsDirty);
-	void OnSortAndFilterFinihed(const FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText);
+	void OnSortAndFilterFinihed(const FName InSortedColumn, EColumnSortMode::Type InSortMode, const FString& InSearchText, uint32 InGeneration);
 
 	FText GetFileCount() const;
 
 	// Export
 	bool IsFileListEmpty() const;
-	void OnExportToJson();
-	void OnExportToCsv();
+	bool HasQueryResult() const;
+	void OnExportToJson(bool bInQueryResult);
+	void OnExportToCsv(bool bInQueryResult);
 	void OnExtract();
+	void OnExtractToArchive();
+	void OnVerify();
 
 	void ScrollToItem(const FString& InPath, int32 PakIndex);
 
 	void OnLoadAssetReigstryFinished();
 	void OnLoadPakFinished();
 	void OnParseAssetFinished();
+	void OnSelectionChanged(FPakFileEntryPtr SelectedItem, ESelectInfo::Type SelectInfo);
 
 	void FillFilesSummary();
 	bool GetSelectedItems(TArray<FPakFileEntryPtr>& OutSelectedItems) const;
+	void GetQueryResult(TArray<FPakFileEntryPtr>& OutFiles) const;
 
 protected:
 	/** The search box widget used to filter items displayed in the file view. */
@@ -134,19 +139,30 @@ protected:
 
 	/** List of files to show in list view (i.e. filtered). */
 	TArray<FPakFileEntryPtr> FileCache;
+	/** Row of every file in FileCache except the summary row, published together with it. */
+	TMap<const FPakFileEntry*, int32> FileCacheRows;
 
 	/** Manage show, hide and sort. */
 	TMap<FName, FFileColumn> FileColumns;
 
 	/** The async task to sort and filter file on a worker thread */
 	TUniquePtr<FAsyncTask<class FFileSortAndFilterTask>> SortAndFilterTask;
-	FFileSortAndFilterTask* InnderTask;
+	FFileSortAndFilterTask* InnderTask = nullptr;
 
 	FName CurrentSortedColumn = FFileColumn::OffsetColumnName;
 	EColumnSortMode::Type CurrentSortMode = EColumnSortMode::Ascending;
 	FString CurrentSearchText;
 
 	bool bIsDirty = false;
+	/** Set when the analyzed files changed, so the next search can't narrow the previous result */
+	bool bFilesChanged = true;
+
+	/** Bumped on every change, only the result of the newest generation is shown */
+	uint32 SortAndFilterGeneration = 0;
+	double SortAndFilterRequestTime = 0.0;
+	/** Search typing waits this long before starting a new sort and filter, 0 disables debouncing */
+	float SearchDebounceDelay = 0.15f;
+	double LastSearchTextChangeTime = 0.0;
 
 	FString DelayHighlightItem;
 	int32 DelayHighlightItemPakIndex = -1;
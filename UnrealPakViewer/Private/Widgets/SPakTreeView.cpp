@@ -5,6 +5,7 @@
 #include "Framework/Application/SlateApplication.h"
 #include "IPlatformFilePak.h"
 #include "Misc/Guid.h"
+#include "Misc/MessageDialog.h"
 #include "Misc/Paths.h"
 #include "Styling/CoreStyle.h"
 #include "Widgets/Layout/SBox.h"
@@ -28,6 +29,7 @@ SPakTreeView::SPakTreeView()
 	FWidgetDelegates::GetOnLoadAssetRegistryFinishedDelegate().AddRaw(this, &SPakTreeView::OnLoadAssetReigstryFinished);
 	FPakAnalyzerDelegates::OnPakLoadFinish.AddRaw(this, &SPakTreeView::OnLoadPakFinished);
 	FPakAnalyzerDelegates::OnAssetParseFinish.AddRaw(this, &SPakTreeView::OnParseAssetFinished);
+	FPakAnalyzerDelegates::OnAssetParsed.AddRaw(this, &SPakTreeView::OnAssetParsed);
 }
 
 SPakTreeView::~SPakTreeView()
@@ -35,6 +37,7 @@ SPakTreeView::~SPakTreeView()
 	FWidgetDelegates::GetOnLoadAssetRegistryFinishedDelegate().RemoveAll(this);
 	FPakAnalyzerDelegates::OnPakLoadFinish.RemoveAll(this);
 	FPakAnalyzerDelegates::OnAssetParseFinish.RemoveAll(this);
+	FPakAnalyzerDelegates::OnAssetParsed.RemoveAll(this);
 }
 
 void SPakTreeView::Construct(const FArguments& InArgs)
@@ -277,7 +280,7 @@ void SPakTreeView::OnGetTreeNodeChildren(FPakTreeEntryPtr InParent, TArray<FPakT
 	{
 		OutChildren.Empty();
 		
-		for (auto& Pair : InParent->ChildrenMap)
+		for (auto& Pair : InParent->GetChildrenMap())
 		{
 			FPakTreeEntryPtr Child = Pair.Value;
 			OutChildren.Add(Child);
@@ -317,6 +320,28 @@ void SPakTreeView::OnSelectionChanged(FPakTreeEntryPtr SelectedItem, ESelectInfo
 	{
 		AssetSummaryView->SetViewingPackage(CurrentSelectedItem);
 	}
+
+	// Parse the selected file, or the files of the selected directory, ahead of the background parse
+	TArray<FPakFileEntryPtr> PriorityFiles;
+	if (bIsSelectionFile && !bIsAssetFile)
+	{
+		PriorityFiles.Add(CurrentSelectedItem);
+	}
+	else if (bIsSelectionDirectory)
+	{
+		for (const auto& Pair : CurrentSelectedItem->GetChildrenMap())
+		{
+			if (!Pair.Value->bIsDirectory && !Pair.Value->AssetSummary.IsValid())
+			{
+				PriorityFiles.Add(Pair.Value);
+			}
+		}
+	}
+
+	if (PriorityFiles.Num() > 0)
+	{
+		IPakAnalyzerModule::Get().GetPakAnalyzer()->PrioritizeAssetParse(PriorityFiles);
+	}
 }
 
 void SPakTreeView::ExpandTreeItem(const FString& InPath, int32 PakIndex)
@@ -337,7 +362,7 @@ void SPakTreeView::ExpandTreeItem(const FString& InPath, int32 PakIndex)
 	FPakTreeEntryPtr Parent = TreeNodes[PakIndex];
 	for (int32 i = 0; i < PathItems.Num(); ++i)
 	{
-		FPakTreeEntryPtr* Child = Parent->ChildrenMap.Find(*PathItems[i]);
+		const FPakTreeEntryPtr* Child = Parent->GetChildrenMap().Find(*PathItems[i]);
 		if (Child)
 		{
 			TreeView->SetItemExpansion(Parent, true);
@@ -364,7 +389,7 @@ FORCEINLINE FText SPakTreeView::GetSelectionName() const
 
 FORCEINLINE FText SPakTreeView::GetSelectionPath() const
 {
-	return CurrentSelectedItem.IsValid() ? FText::FromString(CurrentSelectedItem->Path) : FText();
+	return CurrentSelectedItem.IsValid() ? FText::FromString(CurrentSelectedItem->Path.ToString()) : FText();
 }
 
 FORCEINLINE FText SPakTreeView::GetSelectionOffset() const
@@ -501,6 +526,30 @@ TSharedPtr<SWidget> SPakTreeView::OnGenerateContextMenu()
 			LOCTEXT("ContextMenu_Extract_Desc", "Extract current selected file or folder to disk"),
 			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Extract"), Action_Extract, NAME_None, EUserInterfaceActionType::Button
 		);
+
+		FUIAction Action_ExtractToArchive
+		(
+			FExecuteAction::CreateSP(this, &SPakTreeView::OnExtractToArchiveExecute),
+			FCanExecuteAction::CreateSP(this, &SPakTreeView::HasSelection)
+		);
+		MenuBuilder.AddMenuEntry
+		(
+			LOCTEXT("ContextMenu_Extract_To_Tar", "Extract To Tar..."),
+			LOCTEXT("ContextMenu_Extract_To_Tar_Desc", "Extract current selected file or folder into a single tar archive"),
+			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Extract"), Action_ExtractToArchive, NAME_None, EUserInterfaceActionType::Button
+		);
+
+		FUIAction Action_Verify
+		(
+			FExecuteAction::CreateSP(this, &SPakTreeView::OnVerifyExecute),
+			FCanExecuteAction::CreateSP(this, &SPakTreeView::HasSelection)
+		);
+		MenuBuilder.AddMenuEntry
+		(
+			LOCTEXT("ContextMenu_Verify", "Verify"),
+			LOCTEXT("ContextMenu_Verify_Desc", "Check hashes of current selected file or folder without writing them"),
+			FSlateIcon(FUnrealPakViewerStyle::GetStyleSetName(), "Find"), Action_Verify, NAME_None, EUserInterfaceActionType::Button
+		);
 	}
 	MenuBuilder.EndSection();
 
@@ -589,12 +638,66 @@ void SPakTreeView::OnExtractExecute()
 	IPakAnalyzerModule::Get().GetPakAnalyzer()->ExtractFiles(OutputPath, TargetFiles);
 }
 
+void SPakTreeView::OnExtractToArchiveExecute()
+{
+	bool bOpened = false;
+	TArray<FString> OutFileNames;
+
+	IDesktopPlatform* DesktopPlatform = FDesktopPlatformModule::Get();
+	if (DesktopPlatform)
+	{
+		FSlateApplication::Get().CloseToolTip();
+
+		bOpened = DesktopPlatform->SaveFileDialog(
+			FSlateApplication::Get().FindBestParentWindowHandleForDialogs(nullptr),
+			LOCTEXT("OpenExtractArchiveDialogTitleText", "Select output tar file path...").ToString(),
+			TEXT(""),
+			TEXT(""),
+			TEXT("Tar Files (*.tar)|*.tar|All Files (*.*)|*.*"),
+			EFileDialogFlags::None,
+			OutFileNames);
+	}
+
+	if (!bOpened || OutFileNames.Num() <= 0)
+	{
+		return;
+	}
+
+	TArray<FPakFileEntryPtr> TargetFiles;
+	TArray<FPakTreeEntryPtr> SelectedItems;
+
+	TreeView->GetSelectedItems(SelectedItems);
+	for (FPakTreeEntryPtr PakTreeEntry : SelectedItems)
+	{
+		RetriveFiles(PakTreeEntry, TargetFiles);
+	}
+
+	if (!IPakAnalyzerModule::Get().GetPakAnalyzer()->ExtractFilesToArchive(OutFileNames[0], TargetFiles))
+	{
+		FMessageDialog::Open(EAppMsgType::Ok, LOCTEXT("ExtractToArchiveMixedText", "Pak and IoStore files can not be written into one archive, extract them separately."));
+	}
+}
+
+void SPakTreeView::OnVerifyExecute()
+{
+	TArray<FPakFileEntryPtr> TargetFiles;
+	TArray<FPakTreeEntryPtr> SelectedItems;
+
+	TreeView->GetSelectedItems(SelectedItems);
+	for (FPakTreeEntryPtr PakTreeEntry : SelectedItems)
+	{
+		RetriveFiles(PakTreeEntry, TargetFiles);
+	}
+
+	IPakAnalyzerModule::Get().GetPakAnalyzer()->VerifyFiles(TargetFiles);
+}
+
 void SPakTreeView::OnJumpToFileViewExecute()
 {
 	TArray<FPakTreeEntryPtr> SelectedItems = TreeView->GetSelectedItems();
 	if (SelectedItems.Num() > 0 && SelectedItems[0].IsValid())
 	{
-		FWidgetDelegates::GetOnSwitchToFileViewDelegate().Broadcast(SelectedItems[0]->Path, SelectedItems[0]->OwnerPakIndex);
+		FWidgetDelegates::GetOnSwitchToFileViewDelegate().Broadcast(SelectedItems[0]->Path.ToString(), SelectedItems[0]->OwnerPakIndex);
 	}
 }
 
@@ -692,7 +795,7 @@ void SPakTreeView::RetriveFiles(FPakTreeEntryPtr InRoot, TArray<FPakFileEntryPtr
 {
 	if (InRoot->bIsDirectory)
 	{
-		for (auto& Pair : InRoot->ChildrenMap)
+		for (auto& Pair : InRoot->GetChildrenMap())
 		{
 			FPakTreeEntryPtr Child = Pair.Value;
 			if (Child->bIsDirectory)
@@ -743,4 +846,12 @@ void SPakTreeView::OnParseAssetFinished()
 	}
 }
 
+void SPakTreeView::OnAssetParsed(FPakFileEntryPtr InFile)
+{
+	if (CurrentSelectedItem.IsValid() && CurrentSelectedItem.Get() == InFile.Get())
+	{
+		OnSelectionChanged(CurrentSelectedItem, ESelectInfo::Direct);
+	}
+}
+
 #undef LOCTEXT_NAMESPACE
@@ -76,6 +76,8 @@ protected:
 	TSharedPtr<SWidget> OnGenerateContextMenu();
 
 	void OnExtractExecute();
+	void OnExtractToArchiveExecute();
+	void OnVerifyExecute();
 	void OnJumpToFileViewExecute();
 	bool HasSelection() const;
 	bool HasFileSelection() const;
@@ -87,6 +89,7 @@ protected:
 	void OnLoadPakFinished();
 	void OnLoadAssetReigstryFinished();
 	void OnParseAssetFinished();
+	void OnAssetParsed(FPakFileEntryPtr InFile);
 
 protected:
 	TSharedPtr<STreeView<FPakTreeEntryPtr>> TreeView;